@@ -4,12 +4,13 @@
 
 static rkChain chain;
 static rkIK ik;
-static rkIKSeq ik_seq;
+static FILE *fin;
 
 enum{
   RK_IK_MODELFILE=0, RK_IK_CONFFILE,
   RK_IK_ENTRYFILE, RK_IK_OUTPUTFILE,
   RK_IK_ITERNUM, RK_IK_TOL,
+  RK_IK_BINARY,
   RK_IK_VERBOSE,
   RK_IK_HELP,
   RK_IK_INVALID,
@@ -21,6 +22,7 @@ zOption option[] = {
   { "o", "out", "<.zvs file>", "output joint sequence file", NULL, false },
   { "i", "iternum", "<n>", "number of the maximum iteration steps", "1000", false },
   { "t", "tol", "<n>", "tolerance of error", "1.0e-10", false },
+  { "b", "binary", NULL, "read entry data in binary format", NULL, false },
   { "v", "verbose", NULL, "run this program verbosely", NULL, false },
   { "h", "help", NULL, "show this message", NULL, false },
   { NULL, NULL, NULL, NULL, NULL, false },
@@ -84,11 +86,18 @@ FILE *rk_ik_command_args(int argc, char *argv[])
   rk_ik_message( "Read an IK configuration file ..." );
   if( !rkIKConfReadZTK( &ik, &chain, option[RK_IK_CONFFILE].arg ) ) exit( 1 );
   rk_ik_message( "done.\n" );
-  rk_ik_message( "Read an IK entry file ..." );
-  if( option[RK_IK_ENTRYFILE].flag )
-    rkIKSeqScanFile( &ik_seq, option[RK_IK_ENTRYFILE].arg );
+  rk_ik_message( "Open an IK entry file ..." );
+  if( !option[RK_IK_ENTRYFILE].flag )
+    fin = stdin;
   else
-    rkIKSeqScan( &ik_seq );
+  if( !( fin = option[RK_IK_BINARY].flag ?
+      zOpenFile( option[RK_IK_ENTRYFILE].arg, RK_IKSEQ_BIN_SUFFIX, "rb" ) :
+      zOpenFile( option[RK_IK_ENTRYFILE].arg, RK_IKSEQ_SUFFIX, "r" ) ) )
+    exit( 1 );
+  if( option[RK_IK_BINARY].flag && !rkIKSeqBinFReadHeader( fin ) ){
+    ZRUNERROR( RK_ERR_IK_SEQ_INVBIN, option[RK_IK_ENTRYFILE].flag ? option[RK_IK_ENTRYFILE].arg : "stdin" );
+    exit( 1 );
+  }
   rk_ik_message( "done.\n" );
 
   if( !option[RK_IK_OUTPUTFILE].flag ){
@@ -106,9 +115,16 @@ FILE *rk_ik_command_args(int argc, char *argv[])
   return fout;
 }
 
-void rk_ik_solve(rkIKSeq *seq, FILE *fout, rkIK *ik)
+/* read the next entry from the stream, so that the memory is kept constant. */
+bool rk_ik_read(rkIKSeqCell *c)
+{
+  return option[RK_IK_BINARY].flag ?
+    rkIKSeqCellFRead( fin, c ) : rkIKSeqCellFScan( fin, c );
+}
+
+void rk_ik_solve(FILE *fout, rkIK *ik)
 {
-  rkIKSeqListCell *cp;
+  rkIKSeqCell cell;
   zVec v;
   int iter;
   int i = 0;
@@ -120,18 +136,18 @@ void rk_ik_solve(rkIKSeq *seq, FILE *fout, rkIK *ik)
   }
   iter = atoi( option[RK_IK_ITERNUM].arg );
   tol = atof( option[RK_IK_TOL].arg );
-  while( !zListIsEmpty(seq) ){
-    zQueueDequeue( seq, &cp );
+  rkIKSeqCellInit( &cell );
+  while( rk_ik_read( &cell ) ){
     rkIKDeactivate( ik );
     rkIKBind( ik ); /* bind current status to the reference. */
-    rkIKSeqCellSet( ik, &cp->data );
+    rkIKSeqCellSet( ik, &cell );
     eprintf( "output: %d\n", ++i );
     rkIKSolve( ik, v, tol, iter );
     /* output */
-    fprintf( fout, "%.10f ", cp->data.dt );
+    fprintf( fout, "%.10f ", cell.dt );
     zVecFPrint( fout, v ); fflush( fout );
-    rkIKSeqListCellFree( cp );
   }
+  rkIKSeqCellFree( &cell );
   zVecFree( v );
 }
 
@@ -140,9 +156,9 @@ int main(int argc, char *argv[])
   FILE *fout;
 
   fout = rk_ik_command_args( argc, argv+1 );
-  rk_ik_solve( &ik_seq, fout, &ik );
+  rk_ik_solve( fout, &ik );
   if( !option[RK_IK_OUTPUTFILE].flag ) fclose( fout );
-  rkIKSeqFree( &ik_seq );
+  if( option[RK_IK_ENTRYFILE].flag ) fclose( fin );
   rkIKDestroy( &ik );
   rkChainDestroy( &chain );
   return 0;
@@ -0,0 +1,102 @@
+/* converter of inverse kinematics sequence between text and binary formats */
+
+#include <roki/rk_ik.h>
+
+enum{
+  RK_IKSEQ_CONV_INPUTFILE=0, RK_IKSEQ_CONV_OUTPUTFILE,
+  RK_IKSEQ_CONV_REVERSE,
+  RK_IKSEQ_CONV_HELP,
+  RK_IKSEQ_CONV_INVALID,
+};
+zOption option[] = {
+  { "i", "in", "<entry file>", "input IK sequence file", NULL, false },
+  { "o", "out", "<entry file>", "output IK sequence file", NULL, false },
+  { "r", "reverse", NULL, "convert binary to text", NULL, false },
+  { "h", "help", NULL, "show this message", NULL, false },
+  { NULL, NULL, NULL, NULL, NULL, false },
+};
+
+void rk_ikseq_conv_usage(void)
+{
+  eprintf( "Usage: rk_ikseq_conv <options> [input file] [output file]\n" );
+  zOptionHelp( option );
+  eprintf( "\nAn IK sequence in text format is converted to binary format (." RK_IKSEQ_BIN_SUFFIX "),\n" );
+  eprintf( "and vice versa with -r option.\n" );
+  eprintf( "\nWhen [input file] is omitted, data are read through the standard input.\n" );
+  eprintf( "\nWhen [output file] is omitted, result is output to the standard output.\n" );
+  exit( 0 );
+}
+
+FILE *rk_ikseq_conv_open_in(void)
+{
+  FILE *fp;
+
+  if( !option[RK_IKSEQ_CONV_INPUTFILE].flag ) return stdin;
+  if( !( fp = option[RK_IKSEQ_CONV_REVERSE].flag ?
+      zOpenFile( option[RK_IKSEQ_CONV_INPUTFILE].arg, RK_IKSEQ_BIN_SUFFIX, "rb" ) :
+      zOpenFile( option[RK_IKSEQ_CONV_INPUTFILE].arg, RK_IKSEQ_SUFFIX, "r" ) ) )
+    exit( 1 );
+  return fp;
+}
+
+FILE *rk_ikseq_conv_open_out(void)
+{
+  FILE *fp;
+
+  if( !option[RK_IKSEQ_CONV_OUTPUTFILE].flag ) return stdout;
+  if( !( fp = fopen( option[RK_IKSEQ_CONV_OUTPUTFILE].arg, option[RK_IKSEQ_CONV_REVERSE].flag ? "w" : "wb" ) ) ){
+    ZOPENERROR( option[RK_IKSEQ_CONV_OUTPUTFILE].arg );
+    exit( 1 );
+  }
+  return fp;
+}
+
+bool rk_ikseq_conv(FILE *fin, FILE *fout)
+{
+  rkIKSeqCell cell;
+  bool ret = true;
+
+  rkIKSeqCellInit( &cell );
+  if( option[RK_IKSEQ_CONV_REVERSE].flag ){
+    if( !rkIKSeqBinFReadHeader( fin ) ){
+      ZRUNERROR( RK_ERR_IK_SEQ_INVBIN, option[RK_IKSEQ_CONV_INPUTFILE].flag ? option[RK_IKSEQ_CONV_INPUTFILE].arg : "stdin" );
+      return false;
+    }
+    while( rkIKSeqCellFRead( fin, &cell ) )
+      rkIKSeqCellFPrint( fout, &cell );
+  } else{
+    if( !( ret = rkIKSeqBinFWriteHeader( fout ) ) ) goto TERMINATE;
+    while( rkIKSeqCellFScan( fin, &cell ) )
+      if( !( ret = rkIKSeqCellFWrite( fout, &cell ) ) ) break;
+  }
+ TERMINATE:
+  rkIKSeqCellFree( &cell );
+  return ret;
+}
+
+int main(int argc, char *argv[])
+{
+  zStrAddrList arglist;
+  char *inputfile, *outputfile;
+  FILE *fin, *fout;
+  bool ret;
+
+  zOptionRead( option, argv+1, &arglist );
+  if( option[RK_IKSEQ_CONV_HELP].flag ) rk_ikseq_conv_usage();
+  zStrListGetPtr( &arglist, 2, &inputfile, &outputfile );
+  if( inputfile ){
+    option[RK_IKSEQ_CONV_INPUTFILE].flag = true;
+    option[RK_IKSEQ_CONV_INPUTFILE].arg  = inputfile;
+  }
+  if( outputfile ){
+    option[RK_IKSEQ_CONV_OUTPUTFILE].flag = true;
+    option[RK_IKSEQ_CONV_OUTPUTFILE].arg  = outputfile;
+  }
+  fin = rk_ikseq_conv_open_in();
+  fout = rk_ikseq_conv_open_out();
+  ret = rk_ikseq_conv( fin, fout );
+  if( option[RK_IKSEQ_CONV_INPUTFILE].flag ) fclose( fin );
+  if( option[RK_IKSEQ_CONV_OUTPUTFILE].flag ) fclose( fout );
+  zStrAddrListDestroy( &arglist );
+  return ret ? 0 : 1;
+}
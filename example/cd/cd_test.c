@@ -20,6 +20,7 @@ int main(int argc, char *argv[])
   rkCDPairChainUnreg( &cd, &chain);
   rkCDColChkVert( &cd );
   rkCDPairPrint( &cd );
+  rkCDStatFPrint( stdout, &cd );
 
   rkChainDestroy( &chain );
   rkChainDestroy( &chain2 );
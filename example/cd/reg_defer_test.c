@@ -0,0 +1,65 @@
+#define _POSIX_C_SOURCE 200112L
+#include <roki/roki.h>
+#include <time.h>
+
+#define REPEAT 10
+#define CACHEFILE "reg_defer_test.cache"
+
+/* wall-clock time, since clock() sums up CPU time of all threads */
+double wall_time(void)
+{
+  struct timespec ts;
+
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+/* time to register a chain to a collision detector */
+double reg_time(rkChain *chain, int mode)
+{
+  rkCD cd;
+  double t, t_total = 0;
+  register int i;
+
+  for( i=0; i<REPEAT; i++ ){
+    rkCDCreate( &cd );
+    t = wall_time();
+    switch( mode ){
+    case 0: rkCDChainReg( &cd, chain, RK_CD_CELL_MOVE ); break;
+    case 1: rkCDChainRegDefer( &cd, chain, RK_CD_CELL_MOVE, NULL ); break;
+    default: rkCDChainRegDefer( &cd, chain, RK_CD_CELL_MOVE, CACHEFILE );
+    }
+    t_total += wall_time() - t;
+    rkCDDestroy( &cd );
+  }
+  return t_total / REPEAT;
+}
+
+/* benchmark of the deferred registration against the eager one */
+void reg_defer_bench(char *filename)
+{
+  rkChain chain;
+  double t_eager, t;
+
+  if( !rkChainReadZTK( &chain, filename ) ) return;
+  rkChainUpdateFK( &chain );
+  t_eager = reg_time( &chain, 0 );
+  printf( "%s (%d links) rkCDChainReg: %g sec\n", filename, rkChainLinkNum(&chain), t_eager );
+  t = reg_time( &chain, 1 );
+  printf( "%s (%d links) rkCDChainRegDefer: %g sec (x%g)\n", filename, rkChainLinkNum(&chain), t, t_eager / t );
+  remove( CACHEFILE ); /* written at the first registration and read at the others */
+  t = reg_time( &chain, 2 );
+  printf( "%s (%d links) rkCDChainRegDefer with cache: %g sec (x%g)\n", filename, rkChainLinkNum(&chain), t, t_eager / t );
+  remove( CACHEFILE );
+  rkChainDestroy( &chain );
+}
+
+int main(int argc, char *argv[])
+{
+  char *filename[] = { "../model/puma.ztk", "../model/mighty.ztk", "../model/humanoid.ztk", NULL };
+  char **fp;
+
+  for( fp=argc > 1 ? argv+1 : filename; *fp; fp++ )
+    reg_defer_bench( *fp );
+  return 0;
+}
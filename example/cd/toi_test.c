@@ -0,0 +1,39 @@
+#include <roki/rk_cd.h>
+
+#define TOL 1.0e-4
+
+int main(int argc, char *argv[])
+{
+  rkChain box, wall;
+  rkCD cd;
+  zVec dis;
+  double toi;
+
+  if( !rkChainScanFile( &box, "../model/box.ztk" ) ||
+      !rkChainScanFile( &wall, "../model/wall.ztk" ) ) return EXIT_FAILURE;
+  dis = zVecAlloc( rkChainJointSize(&box) );
+  zVecSetElem( dis, zX, -0.5 );
+  rkChainFK( &box, dis );
+  rkChainUpdateFK( &wall );
+
+  rkCDCreate( &cd );
+  rkCDChainReg( &cd, &box, RK_CD_CELL_MOVE );
+  rkCDChainReg( &cd, &wall, RK_CD_CELL_STAT );
+
+  /* the box passes through the wall in a step */
+  zVecSetElem( dis, zX, 0.5 );
+  rkChainFK( &box, dis );
+  rkCDColChkGJK( &cd );
+  printf( "discrete check: %s\n", zBoolStr( cd.candnum > 0 && cd.cand[0]->data.is_col ) );
+  toi = rkCDColChkTOI( &cd, TOL );
+  printf( "continuous check: %d pair(s), time of impact = %g\n", cd.colnum, toi );
+  zVecSetElem( dis, zX, -0.5 + toi );
+  rkChainFK( &box, dis );
+  printf( "position at impact = %g\n", rkChainRootPos(&box)->e[zX] );
+
+  rkCDDestroy( &cd );
+  zVecFree( dis );
+  rkChainDestroy( &box );
+  rkChainDestroy( &wall );
+  return 0;
+}
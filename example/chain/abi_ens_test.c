@@ -0,0 +1,52 @@
+#include <roki/roki.h>
+#include <time.h>
+
+#define NUM  256
+#define STEP 100
+
+int main(int argc, char *argv[])
+{
+  rkChain chain;
+  rkABIEns ens;
+  zVec dis, vel, acc;
+  clock_t c;
+  double t_ens, t_update, t_abi;
+  register int i, n;
+
+  zRandInit();
+  if( !rkChainReadZTK( &chain, argc > 1 ? argv[1] : "../model/puma.ztk" ) ) return 1;
+  if( !rkChainABIAlloc( &chain ) || !rkABIEnsCreate( &ens, &chain, NUM ) ) return 1;
+  dis = zVecAlloc( rkChainJointSize(&chain) );
+  vel = zVecAlloc( rkChainJointSize(&chain) );
+  acc = zVecAlloc( rkChainJointSize(&chain) );
+  for( n=0; n<NUM; n++ ){
+    zVecRandUniform( dis, -1.0, 1.0 );
+    zVecRandUniform( vel, -1.0, 1.0 );
+    rkABIEnsSetState( &ens, n, dis, vel, NULL );
+  }
+  c = clock();
+  for( i=0; i<STEP; i++ )
+    rkABIEnsUpdate( &ens );
+  t_ens = (double)( clock() - c ) / CLOCKS_PER_SEC;
+  /* the ABI method only, where the kinematics is done in advance */
+  rkChainFK( &chain, dis );
+  rkChainSetJointVelAll( &chain, vel );
+  rkChainUpdateVel( &chain );
+  c = clock();
+  for( i=0; i<STEP; i++ )
+    for( n=0; n<NUM; n++ )
+      rkChainABIUpdate( &chain );
+  t_update = (double)( clock() - c ) / CLOCKS_PER_SEC;
+  /* the ABI method with the kinematics of each instance */
+  c = clock();
+  for( i=0; i<STEP; i++ )
+    for( n=0; n<NUM; n++ )
+      rkChainABI( &chain, dis, vel, acc );
+  t_abi = (double)( clock() - c ) / CLOCKS_PER_SEC;
+  printf( "%d instances x %d steps: ensemble %g sec, rkChainABIUpdate %g sec, rkChainABI %g sec\n", NUM, STEP, t_ens, t_update, t_abi );
+  zVecFreeAO( 3, dis, vel, acc );
+  rkABIEnsDestroy( &ens );
+  rkChainABIDestroy( &chain );
+  rkChainDestroy( &chain );
+  return 0;
+}
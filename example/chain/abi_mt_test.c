@@ -0,0 +1,64 @@
+#define _POSIX_C_SOURCE 200112L
+#include <roki/roki.h>
+#include <time.h>
+
+#define STEP 10000
+
+/* wall-clock time, since clock() sums up CPU time of all threads */
+double wall_time(void)
+{
+  struct timespec ts;
+
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+/* benchmark of branch-parallel ABI against the serial one */
+void abi_mt_bench(char *filename)
+{
+  rkChain chain;
+  zVec dis, vel;
+  double t, t_serial;
+  register int i, nthread;
+
+  if( !rkChainReadZTK( &chain, filename ) ) return;
+  if( !rkChainABIAlloc( &chain ) ){
+    rkChainDestroy( &chain );
+    return;
+  }
+  dis = zVecAlloc( rkChainJointSize(&chain) );
+  vel = zVecAlloc( rkChainJointSize(&chain) );
+  zVecRandUniform( dis, -1.0, 1.0 );
+  zVecRandUniform( vel, -1.0, 1.0 );
+  rkChainFK( &chain, dis );
+  rkChainSetJointVelAll( &chain, vel );
+  rkChainUpdateVel( &chain );
+  t = wall_time();
+  for( i=0; i<STEP; i++ )
+    rkChainABIUpdate( &chain );
+  t_serial = wall_time() - t;
+  printf( "%s (%d links) serial: %g updates/sec\n", filename, rkChainLinkNum(&chain), STEP / t_serial );
+  for( nthread=1; nthread<=4; nthread++ ){
+    rkChainABIUpdateMT( &chain, nthread ); /* to spawn workers before measurement */
+    t = wall_time();
+    for( i=0; i<STEP; i++ )
+      rkChainABIUpdateMT( &chain, nthread );
+    t = wall_time() - t;
+    printf( "%s (%d links) %d threads: %g updates/sec (x%g)\n", filename, rkChainLinkNum(&chain), nthread, STEP / t, t_serial / t );
+  }
+  zVecFreeAO( 2, dis, vel );
+  rkChainABIDestroy( &chain );
+  rkChainDestroy( &chain );
+}
+
+int main(int argc, char *argv[])
+{
+  char *filename[] = { "../model/puma.ztk", "../model/mighty.ztk", "../model/humanoid.ztk", NULL };
+  char **fp;
+
+  zRandInit();
+  for( fp=argc > 1 ? argv+1 : filename; *fp; fp++ )
+    abi_mt_bench( *fp );
+  rkChainABIPoolDestroy();
+  return 0;
+}
@@ -0,0 +1,46 @@
+#include <roki/roki.h>
+#include <time.h>
+
+#define STEP 1000
+
+/* benchmark of forward dynamics integrator */
+void fd_step_bench(char *filename, rkChainFDMethod method, const char *methodname)
+{
+  rkChain chain;
+  rkChainFD fd;
+  zVec vel;
+  clock_t c;
+  double t;
+
+  if( !rkChainReadZTK( &chain, filename ) ) return;
+  if( !rkChainABIAlloc( &chain ) ){
+    rkChainDestroy( &chain );
+    return;
+  }
+  if( !rkChainFDCreate( &fd, &chain, method, 0.001 ) ) goto TERMINATE;
+  vel = zVecAlloc( rkChainJointSize(&chain) );
+  zVecRandUniform( vel, -1.0, 1.0 );
+  rkChainFDInit( &fd, NULL, vel );
+  c = clock();
+  rkChainFDStepN( &fd, STEP );
+  t = (double)( clock() - c ) / CLOCKS_PER_SEC;
+  printf( "%s (%d joints) %s: %g steps/sec\n", filename, rkChainJointSize(&chain), methodname, t > 0 ? STEP / t : HUGE_VAL );
+  zVecFree( vel );
+  rkChainFDDestroy( &fd );
+ TERMINATE:
+  rkChainABIDestroy( &chain );
+  rkChainDestroy( &chain );
+}
+
+int main(int argc, char *argv[])
+{
+  char *filename[] = { "../model/arm.ztk", "../model/puma.ztk", "../model/humanoid.ztk", NULL };
+  char **fp;
+
+  zRandInit();
+  for( fp=argc > 1 ? argv+1 : filename; *fp; fp++ ){
+    fd_step_bench( *fp, RK_CHAIN_FD_EULER, "Euler" );
+    fd_step_bench( *fp, RK_CHAIN_FD_RK4, "RK4" );
+  }
+  return 0;
+}
@@ -0,0 +1,52 @@
+#include <roki/rk_chain.h>
+#include <time.h>
+
+#define STEP 10000
+
+/* benchmark of selective inverse dynamics against the full pass */
+void id_select_bench(rkChain *chain, zVec vel, zVec acc, int flag, const char *modename)
+{
+  clock_t c;
+  double t;
+  register int i;
+
+  c = clock();
+  for( i=0; i<STEP; i++ )
+    rkChainIDSelect( chain, vel, acc, flag );
+  t = (double)( clock() - c ) / CLOCKS_PER_SEC;
+  printf( "  %-24s: %g passes/sec\n", modename, t > 0 ? STEP / t : HUGE_VAL );
+}
+
+void id_select_test(char *filename)
+{
+  rkChain chain;
+  zVec dis, vel, acc;
+
+  if( !rkChainReadZTK( &chain, filename ) ) return;
+  dis = zVecAlloc( rkChainJointSize(&chain) );
+  vel = zVecAlloc( rkChainJointSize(&chain) );
+  acc = zVecAlloc( rkChainJointSize(&chain) );
+  zVecRandUniform( dis, -1.0, 1.0 );
+  zVecRandUniform( vel, -1.0, 1.0 );
+  zVecRandUniform( acc, -1.0, 1.0 );
+  rkChainFK( &chain, dis );
+  printf( "%s (%d joints)\n", filename, rkChainJointSize(&chain) );
+  id_select_bench( &chain, vel, acc, RK_ID_FULL, "full" );
+  id_select_bench( &chain, vel, acc, RK_ID_GRAVITY, "gravity" );
+  id_select_bench( &chain, vel, acc, RK_ID_GRAVITY | RK_ID_NOCOM, "gravity w/o COM" );
+  id_select_bench( &chain, vel, acc, RK_ID_ROOTWRENCH, "root wrench" );
+  id_select_bench( &chain, vel, acc, RK_ID_ROOTWRENCH | RK_ID_NOCOM, "root wrench w/o COM" );
+  zVecFreeAO( 3, dis, vel, acc );
+  rkChainDestroy( &chain );
+}
+
+int main(int argc, char *argv[])
+{
+  char *filename[] = { "../model/arm.ztk", "../model/puma.ztk", "../model/humanoid.ztk", NULL };
+  char **fp;
+
+  zRandInit();
+  for( fp=argc > 1 ? argv+1 : filename; *fp; fp++ )
+    id_select_test( *fp );
+  return 0;
+}
@@ -0,0 +1,28 @@
+#include <roki/rk_ik.h>
+
+#define TMPFILE "ik_seq_bin_test." RK_IKSEQ_BIN_SUFFIX
+
+int main(int argc, char *argv[])
+{
+  rkIKSeqCell cell;
+  rkIKSeqMap map;
+  FILE *fp;
+
+  /* convert a text sequence from the standard input to binary */
+  if( !( fp = fopen( TMPFILE, "w" ) ) ){
+    ZOPENERROR( TMPFILE );
+    return 1;
+  }
+  rkIKSeqCellInit( &cell );
+  rkIKSeqBinFWriteHeader( fp );
+  while( rkIKSeqCellScan( &cell ) )
+    rkIKSeqCellFWrite( fp, &cell );
+  rkIKSeqCellFree( &cell );
+  fclose( fp );
+  /* print the binary sequence through a memory map */
+  if( !rkIKSeqMapOpen( &map, TMPFILE ) ) return 1;
+  while( rkIKSeqMapNext( &map, &cell ) )
+    rkIKSeqCellFPrint( stdout, &cell );
+  rkIKSeqMapClose( &map );
+  return 0;
+}
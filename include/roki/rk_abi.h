@@ -51,6 +51,41 @@ __EXPORT void rkChainABIUpdateGetWrench(rkChain *chain);
 __EXPORT void rkChainABIUpdateAddExForce(rkChain *chain);
 __EXPORT void rkChainABIUpdateAddExForceGetWrench(rkChain *chain);
 
+/*! \brief branch-parallel ABI method.
+ *
+ * rkChainABIUpdateBackwardMT() and rkChainABIUpdateForwardMT() do the
+ * same computation with rkChainABIUpdateBackward() and
+ * rkChainABIUpdateForward(), respectively, where subtrees of a kinematic
+ * chain \a chain branching from a link are computed concurrently by at
+ * most \a nthread threads. In the backward computation, the ABIs of
+ * the subtrees are joined at the branching link. Subtrees with a small
+ * number of links are computed in the current thread.
+ * rkChainABIUpdateForwardGetWrenchMT() also computes wrenches.
+ * Subtrees are computed by a pool of worker threads shared by all chains,
+ * which are created at the first call and kept alive afterward.
+ * The number of links of each subtree is counted by rkChainABIAlloc(),
+ * so that the chain has to be allocated again when its structure is
+ * changed.
+ *
+ * rkChainABIPoolDestroy() terminates and joins the worker threads.
+ * It has to be called when no branch-parallel computation is running.
+ * The pool is created again at the next call of the above functions.
+ *
+ * rkChainABIUpdateMT() and rkChainABIUpdateGetWrenchMT() are
+ * branch-parallel versions of rkChainABIUpdate() and
+ * rkChainABIUpdateGetWrench(), respectively.
+ *
+ * If POSIX threads are not available, they are computed serially.
+ * \return
+ * No values are returned.
+ */
+__EXPORT void rkChainABIUpdateBackwardMT(rkChain *chain, int nthread);
+__EXPORT void rkChainABIUpdateForwardMT(rkChain *chain, int nthread);
+__EXPORT void rkChainABIUpdateForwardGetWrenchMT(rkChain *chain, int nthread);
+__EXPORT void rkChainABIUpdateMT(rkChain *chain, int nthread);
+__EXPORT void rkChainABIUpdateGetWrenchMT(rkChain *chain, int nthread);
+__EXPORT void rkChainABIPoolDestroy(void);
+
 /* compute accleration of a kinematic chain based on ABI method. */
 __EXPORT zVec rkChainABI(rkChain *chain, zVec dis, zVec vel, zVec acc);
 
@@ -59,6 +94,189 @@ __EXPORT void rkChainABIPopPrpAccBias(rkChain *chain);
 __EXPORT void rkChainABIPopPrpAccBiasAddExForceTwo(rkChain *chain, rkLink *link, rkLink *link2);
 __EXPORT void rkChainABIUpdateAddExForceTwo(rkChain *chain, rkLink *link, rkWrench *w, rkLink *link2, rkWrench *w2);
 
+/*! \brief contact axis, namely, a direction of a force at a point on a link. */
+typedef struct{
+  rkLink *link; /*!< link on which the contact point is */
+  zVec3D p;     /*!< contact point with respect to the link frame */
+  zVec3D n;     /*!< direction of the force with respect to the world frame */
+} rkABIContactAxis;
+
+/*! \brief contact-space inverse inertia matrix (Delassus matrix).
+ *
+ * rkChainABIContactInvInertiaMat() computes the inverse inertia
+ * matrix \a d of a kinematic chain \a chain in the space of \a k
+ * contact axes \a axis, namely, the (i,j) component of \a d is the
+ * acceleration of the i-th contact point along the i-th direction
+ * caused by the unit force applied at the j-th contact point along
+ * the j-th direction.
+ * A pair of forces acting on two links in a self-contact is
+ * represented by two contact axes in the opposite directions, and
+ * the response of the pair is the sum of the corresponding elements.
+ *
+ * Each column is computed by a backward pass along the path from
+ * the contact link to the root and a forward pass, reusing the
+ * articulated inertias, so that the total cost is O(nk+k^2) rather
+ * than O(nk^2) of the pair-by-pair computation.
+ *
+ * As well as rkChainABIUpdateAddExForceTwo(), the regular ABI method
+ * has to be done and rkChainABIPushPrpAccBias() has to be called in
+ * advance. The accelerations and ABbias of \a chain are restored
+ * before returning.
+ * \return
+ * rkChainABIContactInvInertiaMat() returns a pointer \a d if
+ * succeeding. If the size of \a d is not k x k, the null pointer
+ * is returned.
+ */
+__EXPORT zMat rkChainABIContactInvInertiaMat(rkChain *chain, int k, rkABIContactAxis axis[], zMat d);
+
+/*! \brief joint-space inverse inertia matrix.
+ *
+ * rkChainInvInertiaMat() computes the inverse \a m of the joint-space
+ * inertia matrix of a kinematic chain \a chain directly from the
+ * articulated body inertias without inverting the inertia matrix.
+ * Each column is computed as the response of the joint accelerations
+ * to a unit generalized force by recomputing ABbias and the forward
+ * path of the ABI method, so that the total cost is O(n^2) for n
+ * joints.
+ *
+ * rkChainInvInertiaMulVec() computes the product \a a of the inverse
+ * inertia matrix and a vector \a v without forming the matrix, in
+ * O(n) time. \a v and \a a have to be different vectors.
+ *
+ * The regular ABI method, e.g. rkChainABIUpdate(), has to be done for
+ * the current state in advance. The accelerations and ABbias of
+ * \a chain are restored before returning.
+ * \return
+ * rkChainInvInertiaMat() returns a pointer \a m, and
+ * rkChainInvInertiaMulVec() returns a pointer \a a, if succeeding.
+ * If the sizes of them do not match with the joint size of \a chain,
+ * the null pointer is returned.
+ */
+__EXPORT zMat rkChainInvInertiaMat(rkChain *chain, zMat m);
+__EXPORT zVec rkChainInvInertiaMulVec(rkChain *chain, zVec v, zVec a);
+
+/*! \brief operational-space inertia matrix.
+ *
+ * rkChainLinkOpSpaceInvInertia() computes the inverse \a m of the
+ * operational-space inertia matrix of a kinematic chain \a chain
+ * with respect to \a n points \a p on links \a link, namely,
+ * J M^-1 J^T, where J is the stacked Jacobian matrix of the points.
+ * p[i] is with respect to the frame of link[i]. The 6x6 block at
+ * the i-th row and the j-th column is the response of the linear
+ * and angular accelerations of the i-th point with respect to the
+ * world frame to the force and moment applied at the j-th point,
+ * so that the cross-coupling between the points is also computed.
+ * The size of \a m has to be 6n x 6n.
+ *
+ * Each column is computed by the backward and forward paths with
+ * the articulated inertias of the last ABI update kept, so that the
+ * cost is O(n_j n) for n_j joints without forming the joint-space
+ * inertia matrix.
+ *
+ * rkChainLinkOpSpaceInertia() computes the operational-space inertia
+ * matrix \a lambda, namely, the inverse of the above matrix. \a m is
+ * a 6n x 6n workspace, in which the inverse is stored.
+ *
+ * As well as rkChainABIContactInvInertiaMat(), the regular ABI method
+ * has to be done and rkChainABIPushPrpAccBias() has to be called in
+ * advance. The accelerations and ABbias of \a chain are restored
+ * before returning.
+ * \return
+ * rkChainLinkOpSpaceInvInertia() returns a pointer \a m, and
+ * rkChainLinkOpSpaceInertia() returns a pointer \a lambda, if
+ * succeeding. If the size of the matrix is not 6n x 6n, or the
+ * inverse matrix is not obtained, the null pointer is returned.
+ */
+__EXPORT zMat rkChainLinkOpSpaceInvInertia(rkChain *chain, int n, rkLink *link[], zVec3D p[], zMat m);
+__EXPORT zMat rkChainLinkOpSpaceInertia(rkChain *chain, int n, rkLink *link[], zVec3D p[], zMat m, zMat lambda);
+
+/*! \brief hybrid dynamics.
+ *
+ * The hybrid dynamics computes the accelerations of torque-specified
+ * joints and the torques of acceleration-specified joints at once.
+ * rkLinkABISetAccSpec() sets the joint of a link \a l for an
+ * acceleration-specified joint if \a f is the true value, or for a
+ * torque-specified joint otherwise. All joints are torque-specified
+ * by default. rkLinkABIIsAccSpec() checks if the joint of \a l is
+ * acceleration-specified.
+ *
+ * rkChainHDUpdate() updates the accelerations and wrenches of links of
+ * a kinematic chain \a chain in a single pair of backward and forward
+ * paths of the ABI method. The specified accelerations have to be set
+ * to the acceleration-specified joints, and the torques of them are
+ * stored to the joints. The torque-specified joints are driven by the
+ * motors as well as rkChainABIUpdate().
+ *
+ * rkChainHD() computes the hybrid dynamics of \a chain at the joint
+ * displacement \a dis and velocity \a vel. The components of \a acc
+ * for acceleration-specified joints are the specified accelerations,
+ * and the others are replaced with the computed accelerations.
+ * If \a trq is not the null pointer, the motor input torques are
+ * stored in it. The components for acceleration-specified joints are
+ * the input torques required to realize the specified accelerations,
+ * which include the torques consumed by the motors computed with
+ * rkJointMotorDrivingTrq(). The others are the current inputs.
+ * \return
+ * rkChainHDUpdate() returns no value.
+ * rkChainHD() returns a pointer \a acc.
+ */
+#define rkLinkABISetAccSpec(l,f) ( rkLinkABIPrp(l)->acc_spec = (f) )
+#define rkLinkABIIsAccSpec(l)    rkLinkABIPrp(l)->acc_spec
+
+__EXPORT void rkChainHDUpdate(rkChain *chain);
+__EXPORT zVec rkChainHD(rkChain *chain, zVec dis, zVec vel, zVec acc, zVec trq);
+
+/*! \brief ABI method with frozen articulated inertias.
+ *
+ * rkChainABIUpdateFrozen() updates the accelerations of links of a
+ * kinematic chain \a chain by reusing the articulated inertias and
+ * the axis inertias computed in the last regular update, e.g.
+ * rkChainABIUpdate(). Only the velocity-dependent terms, the external
+ * forces, the driving torques and ABbias are recomputed, which saves
+ * the cost of the transformations and inversions of inertias. It is
+ * exact if the configuration has not changed since the last regular
+ * update, and approximates well if the change is small.
+ * rkChainABIUpdateFrozenGetWrench() also computes wrenches.
+ *
+ * rkABIFreeze is a refresh policy of the frozen articulated inertias.
+ * rkABIFreezeCreate() creates a policy \a fz for \a chain, where the
+ * inertias are refreshed after \a interval substeps, or when the
+ * distance of the joint displacement from that at the last refresh
+ * exceeds \a tol. rkABIFreezeDestroy() destroys \a fz.
+ *
+ * rkChainABIFreeze() computes the joint acceleration \a acc of \a chain
+ * at the joint displacement \a dis and velocity \a vel as well as
+ * rkChainABI(), choosing the regular or frozen update according to
+ * \a fz. As an error monitor, fz->err is the distance of the joint
+ * displacement from that at the last refresh, and fz->acc_err is the
+ * distance of the joint acceleration by the frozen inertias from the
+ * exact one, which is observed at every refresh.
+ * \return
+ * rkChainABIUpdateFrozen(), rkChainABIUpdateFrozenGetWrench() and
+ * rkABIFreezeDestroy() return no value.
+ * rkABIFreezeCreate() returns a pointer \a fz if succeeding, or the
+ * null pointer otherwise.
+ * rkChainABIFreeze() returns a pointer \a acc.
+ */
+typedef struct{
+  int interval;   /*!< maximum number of substeps with frozen inertias */
+  double tol;     /*!< tolerance of the deviation of joint displacement */
+  int count;      /*!< number of substeps since the last refresh */
+  int refresh;    /*!< number of refreshes */
+  double err;     /*!< deviation of joint displacement from the last refresh */
+  double acc_err; /*!< error of joint acceleration observed at the last refresh */
+  /*! \cond */
+  zVec _dis, _acc;
+  /*! \endcond */
+} rkABIFreeze;
+
+__EXPORT void rkChainABIUpdateFrozen(rkChain *chain);
+__EXPORT void rkChainABIUpdateFrozenGetWrench(rkChain *chain);
+
+__EXPORT rkABIFreeze *rkABIFreezeCreate(rkABIFreeze *fz, rkChain *chain, int interval, double tol);
+__EXPORT void rkABIFreezeDestroy(rkABIFreeze *fz);
+__EXPORT zVec rkChainABIFreeze(rkChain *chain, rkABIFreeze *fz, zVec dis, zVec vel, zVec acc);
+
 __END_DECLS
 
 #endif /* __RK_ABI_H__ */
@@ -0,0 +1,108 @@
+/* RoKi - Robot Kinetics library
+ * Copyright (C) 1998 Tomomichi Sugihara (Zhidao)
+ *
+ * rk_abi_ens - ensemble of articulated body inertia method
+ */
+
+#ifndef __RK_ABI_ENS_H__
+#define __RK_ABI_ENS_H__
+
+#include <roki/rk_abi.h>
+
+__BEGIN_DECLS
+
+/* ********************************************************** */
+/* CLASS: rkABIEns
+ * ensemble of ABI method for multiple instances of a kinematic chain
+ * ********************************************************** */
+
+/*! \brief ensemble of ABI method.
+ *
+ * An ensemble holds the states of \a num instances of a kinematic
+ * chain, which share the model data, namely, the topology, the
+ * original frames and the mass properties of links. The states are
+ * stored in the structure-of-arrays layout, where the i-th joint
+ * component of the n-th instance is the (i*num+n)-th element of each
+ * array, so that the ABI method is computed with the instances on
+ * the innermost loops to be vectorized.
+ *
+ * Only revolutional, prismatic and fixed joints are supported; other
+ * joints including cylindrical, universal, spherical and free-floating
+ * joints are rejected at creation. The joints are driven by the torques
+ * given to \a trq, which play the same role with the inputs of torque
+ * motors (without the limits) in rkChainABI(). Since the ensemble does
+ * not compute the rotor inertias and the resistances of motors, nor the
+ * restoring torques due to the joint stiffness, viscosity and Coulomb
+ * friction, joints with motors other than torque motors or with nonzero
+ * stiffness, viscosity or Coulomb friction are also rejected at creation.
+ * Frictions set by rkJointSetFriction() and external forces are not
+ * considered.
+ */
+typedef struct{
+  rkChain *chain; /*!< kinematic chain shared by the instances */
+  int num;        /*!< number of instances */
+  double *dis;    /*!< joint displacements */
+  double *vel;    /*!< joint velocities */
+  double *trq;    /*!< joint torques */
+  double *acc;    /*!< joint accelerations */
+  /*! \cond */
+  int *_order;    /* links in preorder */
+  int *_parent;   /* parent links */
+  int *_axis;     /* components of joint axes */
+  double *_model; /* model data of links */
+  double *_ws;    /* workspace of links */
+  double *_tmp;   /* temporary arrays over instances */
+  /*! \endcond */
+} rkABIEns;
+
+#define rkABIEnsNum(e)      (e)->num
+#define rkABIEnsDis(e,i,n)  (e)->dis[(i)*(e)->num+(n)]
+#define rkABIEnsVel(e,i,n)  (e)->vel[(i)*(e)->num+(n)]
+#define rkABIEnsTrq(e,i,n)  (e)->trq[(i)*(e)->num+(n)]
+#define rkABIEnsAcc(e,i,n)  (e)->acc[(i)*(e)->num+(n)]
+
+/*! \brief create and destroy an ensemble of ABI method.
+ *
+ * rkABIEnsCreate() creates an ensemble \a ens of \a num instances of
+ * a kinematic chain \a chain. \a chain is referred as the model, and
+ * must not be modified or destroyed until \a ens is destroyed.
+ * All the states are initialized for zero.
+ *
+ * rkABIEnsDestroy() destroys \a ens.
+ * \return
+ * rkABIEnsCreate() returns a pointer \a ens if succeeding. If \a chain
+ * includes a joint which is not supported as stated above, or it fails
+ * to allocate memory, the null pointer is returned.
+ * rkABIEnsDestroy() returns no value.
+ */
+__EXPORT rkABIEns *rkABIEnsCreate(rkABIEns *ens, rkChain *chain, int num);
+__EXPORT void rkABIEnsDestroy(rkABIEns *ens);
+
+/*! \brief set and get states of an instance.
+ *
+ * rkABIEnsSetState() sets the joint displacement \a dis, velocity
+ * \a vel and torque \a trq of the \a n-th instance of an ensemble
+ * \a ens. If \a trq is the null pointer, the torques are set for zero.
+ *
+ * rkABIEnsGetAcc() copies the joint acceleration of the \a n-th
+ * instance to \a acc.
+ * \return
+ * rkABIEnsSetState() returns no value.
+ * rkABIEnsGetAcc() returns a pointer \a acc.
+ */
+__EXPORT void rkABIEnsSetState(rkABIEns *ens, int n, zVec dis, zVec vel, zVec trq);
+__EXPORT zVec rkABIEnsGetAcc(rkABIEns *ens, int n, zVec acc);
+
+/*! \brief ABI method for all instances.
+ *
+ * rkABIEnsUpdate() computes the joint accelerations of all instances
+ * of an ensemble \a ens under the gravity by the ABI method. The
+ * result is stored in ens->acc.
+ * \return
+ * rkABIEnsUpdate() returns no value.
+ */
+__EXPORT void rkABIEnsUpdate(rkABIEns *ens);
+
+__END_DECLS
+
+#endif /* __RK_ABI_ENS_H__ */
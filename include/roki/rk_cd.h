@@ -17,6 +17,47 @@ __BEGIN_DECLS
 /*! \brief type to classify stationary or movable shape */
 typedef enum{ RK_CD_CELL_STAT, RK_CD_CELL_MOVE } rkCDCellType;
 
+/* ********************************************************** */
+/*! \brief bounding volume hierarchy of a shape.
+ *
+ * A binary tree of axis-aligned bounding boxes built over vertices or
+ * faces of a polyhedron in the local frame of a shape. It is built once
+ * when a cell is registered, and used to cull vertices and faces apart
+ * from the region in question before the exact tests.
+ *//* ******************************************************* */
+typedef struct{
+  zAABox3D box; /*!< bounding box of primitives under the node */
+  int child[2]; /*!< identifiers of child nodes, or -1 for a leaf */
+  int head;     /*!< head of primitives in the leaf */
+  int num;      /*!< number of primitives under the node */
+} rkCDBVHNode;
+
+typedef struct{
+  int nodenum;       /*!< number of nodes */
+  rkCDBVHNode *node; /*!< array of nodes, the first of which is the root */
+  int *idx;          /*!< identifiers of primitives sorted in the order of leaves */
+} rkCDBVH;
+
+/* ********************************************************** */
+/*! \brief primitive shape of a collision detection cell.
+ *
+ * Spheres, capsules, cylinders and boxes are kept in the link frame
+ * before the shapes are converted to polyhedra, so that pairs of them
+ * are checked by closed-form tests instead of GJK algorithm. The
+ * other shapes are typed RK_CD_PRIM_NONE and checked as polyhedra.
+ *//* ******************************************************* */
+typedef enum{
+  RK_CD_PRIM_NONE=0, RK_CD_PRIM_SPHERE, RK_CD_PRIM_CAPSULE, RK_CD_PRIM_CYLINDER, RK_CD_PRIM_BOX,
+} rkCDPrimType;
+
+typedef struct{
+  rkCDPrimType type; /*!< type of the primitive */
+  zVec3D center[2];  /*!< centers of the both ends, which are the same for a sphere and a box */
+  zVec3D axis[3];    /*!< axes of a box */
+  double dia[3];     /*!< half lengths of a box along the axes */
+  double radius;     /*!< radius of a sphere, a capsule or a cylinder */
+} rkCDPrim;
+
 /* ********************************************************** */
 /*! \brief collision detection cell class.
  *//* ******************************************************* */
@@ -28,7 +69,10 @@ typedef struct{
   zBox3D bb;         /*!< bounding box in local frame */
   zAABox3D aabb;     /*!< axis aligned bounding box in the world frame */
   zBox3D obb;        /*!< oriented bounding box in the world frame */
-  zPH3D ph;          /*!< polyhedron in the world frame */
+  zPH3D ph;          /*!< polyhedron in the world frame, which is not always up to date (see rkCDCellUpdatePH()) */
+  rkCDBVH vbvh;      /*!< hierarchy of vertices in the local frame */
+  rkCDBVH fbvh;      /*!< hierarchy of faces in the local frame */
+  rkCDPrim prim;     /*!< primitive shape in the local frame */
   /* for a fake-crawler */
   bool slide_mode;
   double slide_vel;
@@ -36,6 +80,11 @@ typedef struct{
   /*! \cond */
   bool _bb_update_flag; /* check if boundary boxes are updated */
   bool _ph_update_flag; /* check if polyhedra are updated */
+  int _id;              /* identifier in the broad phase */
+  bool _defer;          /* pairs with the cell are created in the broad phase */
+  bool _noself;         /* self-collision of the chain is not checked */
+  zFrame3D _f0;         /* frame of the link at the previous continuous check */
+  zAABox3D _aabb0;      /* bounding box at the previous continuous check */
   /*! \endcond */
 } rkCDCellDat;
 zListClass( rkCDCellList, rkCDCell, rkCDCellDat );
@@ -49,6 +98,12 @@ __EXPORT rkCDCell *rkCDCellReg(rkCDCellList *clist, rkChain *chain, rkLink *link
 __EXPORT void rkCDCellUpdateBB(rkCDCell *cell);
 
 /*! \brief update the polyhedron of a collision detection cell
+ *
+ * The polyhedron of a cell in the world frame is updated only in
+ * rkCDColVol() family, and replaced by the bounding box in
+ * rkCDColChkOBBVert(). The other checks work on the polyhedron of the
+ * shape in the local frame, so that this function has to be called
+ * before the polyhedron is read after them.
  */
 __EXPORT void rkCDCellUpdatePH(rkCDCell *cell);
 
@@ -75,6 +130,8 @@ typedef struct{
   rkContactFricType type; /* type to classify stick/slip mode */
   zVec3D dir;      /* direction of kinetic friction */
   zVec3D vel;      /* velocity of the vertex */
+  zVec3D _vert;    /* position of the vertex in the world frame */
+  int _id;         /* identifier of the vertex in the polyhedron */
   /*! \endcond */
 } rkCDVertDat;
 zListClass( rkCDVertList, rkCDVert, rkCDVertDat );
@@ -97,15 +154,79 @@ typedef struct{
   zVec3D norm;        /*!< normal vector of the pair */
   zVec3D axis[3];     /*!< contact bases */
   zVec3D center;      /*!< center of collision volume */
-  zPH3D colvol;       /*!< collision volume */
+  zPH3D colvol;       /*!< collision volume, which is reallocated at every check */
   rkCDPlaneList cplane; /*!< contact plane */
   rkContactInfo *ci;    /*!< contact information */
   zVec6D f;           /*!< contact force */
   zFrame3D ref[2];
   rkContactFricType type; /* type to classify stick/slip mode */
+  double toi;         /*!< time of impact found in the continuous check */
+  zVec3D wit[2];      /*!< witness points on the cells found by GJK algorithm or closed-form tests in collision */
+  /*! \cond */
+  zVec3D _sep;        /* separating direction in the frame of cell[1] cached for GJK algorithm */
+  rkCDVertList _vspare; /* contact vertices released at the previous step to be recycled */
+  int *_idx;          /* workspace for identifiers of vertices */
+  int _idxsize;
+  rkCDVert **_hist;   /* hash table of contact vertices at the previous step */
+  int _histcap;
+  int _histsize;
+  /*! \endcond */
 } rkCDPairDat;
 zListClass( rkCDPairList, rkCDPair, rkCDPairDat );
 
+/* ********************************************************** */
+/*! \brief sweep-and-prune broad phase class.
+ *
+ * The end points of axis-aligned bounding boxes of all cells are
+ * kept sorted along the sweep axis. Since cells move little between
+ * two successive steps, the insertion sort to update the order costs
+ * almost linear time to the number of cells. Overlapping cells found
+ * in the sweep are reported only if they are registered as a pair,
+ * which is looked up through a hash table keyed by the identifiers
+ * of cells. A pair of cells registered by rkCDChainRegDefer() is
+ * not created until their bounding boxes overlap for the first time,
+ * unless it is excluded in advance.
+ *//* ******************************************************* */
+typedef struct{
+  double val;  /*!< coordinate on the sweep axis */
+  int id;      /*!< identifier of the cell */
+  bool is_max; /*!< flag to check if the point is the upper bound */
+} rkCDSAPEndPoint;
+
+typedef struct{
+  rkCDCell *cell[2]; /*!< a pair of cells */
+  rkCDPair *pair;    /*!< the registered pair, or the null pointer for an excluded pair */
+} rkCDSAPEntry;
+
+typedef struct{
+  int axis;            /*!< sweep axis */
+  int cellnum;         /*!< number of cells */
+  rkCDCell **cell;     /*!< cells indexed by identifiers */
+  rkCDSAPEndPoint *ep; /*!< end points sorted along the sweep axis */
+  int pairnum;         /*!< number of pairs */
+  int tablesize;       /*!< size of the hash table of pairs */
+  int entrynum;        /*!< number of entries in the hash table */
+  rkCDSAPEntry *table; /*!< hash table of pairs */
+  /*! \cond */
+  int *_active;        /* cells under sweep */
+  int *_activepos;     /* positions of cells in the active list */
+  bool _dirty;         /* flag to rebuild */
+  /*! \endcond */
+} rkCDSAP;
+
+/* ********************************************************** */
+/*! \brief statistics of the midphase culling.
+ *//* ******************************************************* */
+typedef struct{
+  long vert_cand; /*!< vertices of colliding pairs */
+  long vert_test; /*!< vertices passed to the exact containment test */
+  long face_cand; /*!< faces subject to the closest point queries */
+  long face_test; /*!< faces passed to the exact closest point computation */
+  long gjk_test;  /*!< queries of GJK algorithm */
+  long gjk_warm;  /*!< queries settled by the cached separating direction */
+  long prim_test; /*!< queries settled by closed-form tests of primitives */
+} rkCDStat;
+
 /* ********************************************************** */
 /*! \brief collision detection class.
  *//* ******************************************************* */
@@ -114,6 +235,25 @@ typedef struct{
   rkCDPairList plist; /*!< a list of collision detection pairs */
   int colnum;         /*!< the number of collision pairs */
   rkContactFricType def_type; /*!< default friction type */
+  rkCDSAP sap;        /*!< sweep-and-prune broad phase */
+  rkCDPair **cand;    /*!< candidate pairs reported by the broad phase */
+  int candnum;        /*!< the number of candidate pairs */
+  int nthread;        /*!< the number of threads */
+  rkCDStat stat;      /*!< statistics of the midphase culling */
+  /*! \cond */
+  rkCDPair **_prev;   /* candidate pairs at the previous step */
+  int _prevnum;
+  int _candsize;      /* capacities of candidate arrays */
+  int _prevsize;
+  rkCDSAPEntry *_excl; /* pairs of deferred cells excluded from the check */
+  int _exclnum;
+  int _exclsize;
+  int *_res;          /* results of the narrow phase for candidate pairs */
+  int _ressize;
+  void *_pool;        /* pool of worker threads */
+  rkCDVertList _vpool;  /* contact vertices to be recycled */
+  rkCDPlaneList _ppool; /* contact planes to be recycled */
+  /*! \endcond */
 } rkCD;
 
 __EXPORT rkCD *rkCDCreate(rkCD *cd);
@@ -121,7 +261,62 @@ __EXPORT void rkCDDestroy(rkCD *cd);
 __EXPORT void rkCDReset(rkCD *cd);
 __EXPORT void rkCDSetDefaultFricType(rkCD *cd, rkContactFricType type);
 
+/*! \brief set the number of threads of a collision detector.
+ *
+ * rkCDSetThreadNum() sets the number of threads used in a collision
+ * detector \a cd to \a nthread. It is one by default. If POSIX threads
+ * are not available, every process runs in a single thread.
+ *
+ * The narrow phase processes candidate pairs on a pool of worker threads,
+ * which is created when it is used for the first time. Since the result
+ * of each pair is independent of the others, the results including the
+ * number of colliding pairs do not depend on the number of threads.
+ */
+__EXPORT void rkCDSetThreadNum(rkCD *cd, int nthread);
+
+/*! \brief reset and print statistics of a collision detector.
+ *
+ * rkCDStatReset() resets counters of vertices and faces of a collision
+ * detector \a cd, which are accumulated in the vertex-based checks to
+ * measure how many of them are culled by the bounding volume hierarchies
+ * of cells. Queries of GJK algorithm and those settled by separating
+ * directions cached in pairs at the previous step are also counted, and
+ * so are pairs of primitives checked by closed-form tests instead.
+ *
+ * rkCDStatFPrint() prints the counters of \a cd out to the file \a fp.
+ * \return
+ * Neither rkCDStatReset() nor rkCDStatFPrint() return any values.
+ */
+__EXPORT void rkCDStatReset(rkCD *cd);
+__EXPORT void rkCDStatFPrint(FILE *fp, rkCD *cd);
+
 __EXPORT rkCD *rkCDChainReg(rkCD *cd, rkChain *chain, rkCDCellType type);
+
+/*! \brief register a chain to a collision detector with deferred pair creation.
+ *
+ * rkCDChainRegDefer() registers all shapes of a kinematic chain \a chain
+ * to a collision detector \a cd as cells of type \a type in the same way
+ * with rkCDChainReg(), except that pairs of the cells are not created at
+ * this time. A pair is created in the broad phase when bounding boxes of
+ * the cells overlap for the first time, so that the registration costs
+ * linear time to the number of cells.
+ *
+ * Pairs of shapes of \a chain in permanent collision at the current
+ * posture are excluded from the check, as rkCDChainReg() does. The test
+ * runs in parallel on the threads set by rkCDSetThreadNum().
+ * If \a cachefile is not the null pointer, the result of the test is
+ * read from the file, which is created if not exist or not compatible
+ * with \a chain. The file records the name of \a chain, the number of
+ * vertices and the bounding box in the link frame of each shape, and
+ * the joint displacement at the test, and is discarded and rewritten if
+ * any of them does not match with the current ones.
+ * \return
+ * rkCDChainRegDefer() returns a pointer \a cd if it succeeds. If it fails
+ * to allocate internal workspace, the null pointer is returned, and the
+ * cells registered in the call are unregistered so that \a cd is left as
+ * it was before.
+ */
+__EXPORT rkCD *rkCDChainRegDefer(rkCD *cd, rkChain *chain, rkCDCellType type, const char *cachefile);
 __EXPORT void rkCDChainUnreg(rkCD *cd, rkChain *chain);
 
 __EXPORT rkCD *rkCDPairReg(rkCD *cd, rkLink *link1, rkLink *link2);
@@ -131,6 +326,25 @@ __EXPORT void rkCDPairChainUnreg(rkCD *cd, rkChain *chain);
 __EXPORT void rkCDPairPrint(rkCD *cd);
 __EXPORT void rkCDPairVertPrint(rkCD *cd);
 
+/*! \brief collision checks of a collision detector.
+ *
+ * In rkCDColChkGJK() and rkCDColChkGJKOnly(), a pair of
+ * primitives, namely, spheres, capsules, cylinders and boxes, is checked
+ * by a closed-form test instead of GJK algorithm if available, which is
+ * the case for pairs of spheres and capsules, a sphere and a box or a
+ * cylinder, and boxes. The deepest points of the cells are stored in the
+ * member wit of the pair, and the normal vector from the latter cell to
+ * the former in the member norm. The other pairs are checked as polyhedra
+ * by GJK algorithm, which stores a point common to the cells in wit.
+ * These members are meaningful only for pairs in collision. Since GJK
+ * algorithm stops as soon as it finds a separating axis, wit of a pair
+ * apart holds support points of the cells along the axis, which are not
+ * the closest points in general.
+ * rkCDColChkGJKOnly() checks all registered pairs without the broad phase,
+ * except that the sweep-and-prune is run beforehand if \a cd has cells
+ * registered by rkCDChainRegDefer(), so that pairs of them whose bounding
+ * boxes overlap are created and checked.
+ */
 __EXPORT void rkCDColChkAABB(rkCD *cd);    /* AABB */
 __EXPORT void rkCDColChkOBB(rkCD *cd);     /* AABB->OBB */
 __EXPORT void rkCDColChkGJK(rkCD *cd);     /* AABB->OBB->GJK */
@@ -145,6 +359,64 @@ __EXPORT void rkCDColVolBREPFast(rkCD *cd);/* AABB->OBB->BREP->CH(Fast) */
 
 __EXPORT void rkCDColVolBREPVert(rkCD *cd);    /* AABB->OBB->BREP->CH, Vert */
 
+/*! \brief time of impact of a pair of collision detection cells.
+ *
+ * rkCDPairTOI() finds the time when two cells of a pair \a pair collide
+ * for the first time while the frames of links which the cells belong to
+ * move from \a fs0 to \a fe0 and from \a fs1 to \a fe1, respectively.
+ * The positions and the attitudes of the frames are interpolated linearly
+ * with respect to the normalized time from 0 to 1.
+ * It is found by the conservative advancement, which repeatedly advances
+ * the time as far as the cells never collide according to the distance
+ * between them and an upper bound of their approaching speed, until the
+ * distance gets less than \a tol. Hence, the cells are apart from each
+ * other at the found time unless they collide at the beginning.
+ * If the distance does not get less than \a tol within a hundred
+ * iterations, which may happen for the cells grazing each other, the
+ * time advanced so far is regarded as the time of impact, namely, a hit
+ * is reported on the safe side.
+ * The time of impact is stored where \a toi points.
+ *
+ * rkCDColChkTOI() checks all pairs of a collision detector \a cd in the
+ * same way between the postures at the previous call of the function
+ * (or at the registration) and at present. The broad phase uses bounding
+ * boxes swept between the two postures, so that thin obstacles are not
+ * tunneled through, and the bounding boxes of cells at the current posture
+ * are restored after that. The time of impact of each pair is stored in
+ * its member toi, which is 1 for a pair not to collide, and the number of
+ * pairs to collide in the member colnum. The members is_col and vlist
+ * of pairs are not set by this function.
+ * Since rkCDColChkTOI() shares the broad phase with the discrete checks,
+ * it resets the results of the previous discrete check, namely, is_col,
+ * the contact planes and the collision volumes of pairs, and releases
+ * the contact vertices of pairs out of the swept bounding boxes. Hence,
+ * it has to be called before the discrete check at each step. Pairs in
+ * contact keep their contact vertices then, since the swept bounding
+ * boxes contain those at the current posture.
+ * \return
+ * rkCDPairTOI() returns the true value if the cells collide within the
+ * time, or the false value otherwise.
+ *
+ * rkCDColChkTOI() returns the earliest time of impact. If no pairs collide,
+ * 1 is returned.
+ */
+__EXPORT bool rkCDPairTOI(rkCDPair *pair, zFrame3D *fs0, zFrame3D *fe0, zFrame3D *fs1, zFrame3D *fe1, double tol, double *toi);
+__EXPORT double rkCDColChkTOI(rkCD *cd, double tol); /* swept AABB->TOI */
+
+/*! \brief allocate a contact plane.
+ *
+ * rkCDPlaneAlloc() allocates a contact plane of a collision detector \a cd.
+ * Contact planes in pairs are not freed but recycled by \a cd when it is
+ * reset, so that the heap is not touched in the steady state.
+ * Note that the collision volumes of pairs are, on the other hand, freed
+ * when \a cd is reset and allocated again in rkCDColVol() family, since
+ * they are created from scratch by Zeo.
+ * \return
+ * rkCDPlaneAlloc() returns a pointer to the allocated plane, or the null
+ * pointer if it fails to allocate memory.
+ */
+__EXPORT rkCDPlane *rkCDPlaneAlloc(rkCD *cd);
+
 /* for fd */
 __EXPORT rkCDPlaneList *rkCDPlaneListQuickSort(rkCDPlaneList *list, int (*cmp)(void*,void*,void*), void *priv);
 
@@ -324,6 +324,38 @@ __EXPORT void rkChainUpdateID(rkChain *c);
 __EXPORT void rkChainID(rkChain *c, zVec vel, zVec acc);
 __EXPORT void rkChainFKCNT(rkChain *c, zVec dis, double dt);
 
+/*! \brief selective inverse dynamics of kinematic chain.
+ *
+ * rkChainUpdateIDSelect() computes inverse dynamics of a kinematic
+ * chain \a c in the same way with rkChainUpdateID(), skipping the
+ * stages specified by \a flag, which is a bitwise OR of the following:
+ *  RK_ID_GRAVITY    : the joint velocities and accelerations are ignored,
+ *                     so that only the gravity (and external wrenches)
+ *                     are taken into account, e.g. for gravity compensation.
+ *  RK_ID_ROOTWRENCH : the joint wrenches are propagated to the root link
+ *                     but not resolved to the joint torques, e.g. for
+ *                     rkChainZMP(). The joint torques are left unchanged.
+ *  RK_ID_NOCOM      : the velocity and acceleration of the center of mass
+ *                     are not updated.
+ * RK_ID_FULL does the same computation with rkChainUpdateID().
+ *
+ * rkChainIDSelect() sets the joint velocity \a vel and acceleration
+ * \a acc, and then calls rkChainUpdateIDSelect(). \a vel and \a acc
+ * are not referred if RK_ID_GRAVITY is specified.
+ * \return
+ * Neither rkChainUpdateIDSelect() nor rkChainIDSelect() return any values.
+ * \notes
+ * With RK_ID_GRAVITY, velocities and accelerations of links are
+ * overwritten by those at rest.
+ */
+#define RK_ID_FULL       0x0
+#define RK_ID_GRAVITY    0x1
+#define RK_ID_ROOTWRENCH 0x2
+#define RK_ID_NOCOM      0x4
+
+__EXPORT void rkChainUpdateIDSelect(rkChain *c, int flag);
+__EXPORT void rkChainIDSelect(rkChain *c, zVec vel, zVec acc, int flag);
+
 /*! \brief link acceleration at zero joint acceleration.
  *
  * rkChainLinkZeroAcc() computes 6D acceleration of a point \a p
@@ -426,6 +458,27 @@ __EXPORT double rkChainKE(rkChain *c);
  */
 __EXPORT bool rkChainInertiaMatBiasVec(rkChain *chain, zMat inertia, zVec bias);
 
+/*! \brief Coriolis matrix of a kinematic chain.
+ *
+ * rkChainCoriolisMat() computes the Coriolis matrix C of a kinematic chain
+ * \a chain, with which the velocity-dependent part of the bias force vector
+ * is given as C qdot, by an O(n^2) recursive algorithm based on composite
+ * rigid bodies proposed by Echeandia and Wensing, 2021:
+ *  S. Echeandia and P. M. Wensing, Numerical Methods to Compute the Coriolis
+ *  Matrix and Christoffel Symbols for Rigid-Body Systems, Journal of
+ *  Computational and Nonlinear Dynamics, Vol. 16, No. 9, 091004, 2021.
+ * The result satisfies the skew-symmetry property of Mdot - 2 C, where M is
+ * the inertia matrix computed by rkChainInertiaMatBiasVec().
+ * \a chain has to take the posture and the velocity at which the matrix is
+ * computed in advance. The result is put into \a c.
+ * \return
+ * rkChainCoriolisMat() returns the true value if it succeeds to compute the
+ * matrix. If the size of \a c does not match the total degree of freedom of
+ * the chain, or it fails to allocate the internal workspace, the false value
+ * is returned.
+ */
+__EXPORT bool rkChainCoriolisMat(rkChain *chain, zMat c);
+
 /*! \brief external force applied to kinematic chain.
  *
  * rkChainNetExtWrench() calculates the net external wrench acting to
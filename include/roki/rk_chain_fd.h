@@ -0,0 +1,109 @@
+/* RoKi - Robot Kinetics library
+ * Copyright (C) 1998 Tomomichi Sugihara (Zhidao)
+ *
+ * rk_chain_fd - forward dynamics integrator of a kinematic chain
+ */
+
+#ifndef __RK_CHAIN_FD_H__
+#define __RK_CHAIN_FD_H__
+
+#include <roki/rk_abi.h>
+
+__BEGIN_DECLS
+
+/* ********************************************************** */
+/* CLASS: rkChainFD
+ * forward dynamics integrator of a kinematic chain
+ * ********************************************************** */
+
+/*! \brief integration methods of forward dynamics. */
+typedef enum{
+  RK_CHAIN_FD_EULER=0, /*!< semi-implicit Euler method */
+  RK_CHAIN_FD_RK4      /*!< classical fourth-order Runge-Kutta method */
+} rkChainFDMethod;
+
+/*! \brief forward dynamics integrator of a kinematic chain.
+ *
+ * The joint displacement, velocity and acceleration of a kinematic
+ * chain are integrated based on the ABI method. All the workspaces
+ * are preallocated, so that no memory is allocated in each step.
+ */
+typedef struct{
+  rkChain *chain;         /*!< kinematic chain */
+  rkChainFDMethod method; /*!< integration method */
+  double t;               /*!< time */
+  double dt;              /*!< time step */
+  zVec dis;               /*!< joint displacement */
+  zVec vel;               /*!< joint velocity */
+  zVec acc;               /*!< joint acceleration */
+  /*! \cond */
+  zVec _dis, _vel, _acc;  /* intermediate states */
+  zVec _vs, _as;          /* weighted sums of slopes */
+  /*! \endcond */
+} rkChainFD;
+
+#define rkChainFDTime(fd) (fd)->t
+#define rkChainFDDT(fd)   (fd)->dt
+#define rkChainFDDis(fd)  (fd)->dis
+#define rkChainFDVel(fd)  (fd)->vel
+#define rkChainFDAcc(fd)  (fd)->acc
+
+#define rkChainFDSetMethod(fd,m) ( (fd)->method = (m) )
+#define rkChainFDSetDT(fd,d)     ( (fd)->dt = (d) )
+
+/*! \brief create and destroy a forward dynamics integrator.
+ *
+ * rkChainFDCreate() creates a forward dynamics integrator \a fd of a
+ * kinematic chain \a chain with an integration method \a method and
+ * a time step \a dt. ABI of \a chain has to be allocated in advance
+ * by rkChainABIAlloc(). The initial joint displacement is copied from
+ * the current one of \a chain, and the initial joint velocity is zero.
+ *
+ * rkChainFDDestroy() destroys \a fd. ABI of the kinematic chain is not
+ * destroyed.
+ * \return
+ * rkChainFDCreate() returns a pointer \a fd if succeeding, or the
+ * null pointer otherwise.
+ * rkChainFDDestroy() returns no value.
+ */
+__EXPORT rkChainFD *rkChainFDCreate(rkChainFD *fd, rkChain *chain, rkChainFDMethod method, double dt);
+__EXPORT void rkChainFDDestroy(rkChainFD *fd);
+
+/*! \brief initialize a forward dynamics integrator.
+ *
+ * rkChainFDInit() sets the time of \a fd for zero, and the joint
+ * displacement and velocity for \a dis and \a vel, respectively.
+ * If \a dis or \a vel is the null pointer, the corresponding state
+ * is left unchanged.
+ * \return
+ * rkChainFDInit() returns no value.
+ */
+__EXPORT void rkChainFDInit(rkChainFD *fd, zVec dis, zVec vel);
+
+/*! \brief step forward dynamics.
+ *
+ * rkChainFDStep() integrates the motion of the kinematic chain of
+ * \a fd for a time step fd->dt. The joint accelerations are computed
+ * with the current motor inputs and external forces applied to the
+ * chain by rkChainABI(). The joint displacements are updated by
+ * rkChainCatJointDisAll(), so that the joints with non-Euclidean
+ * configuration spaces such as spherical and free-floating joints are
+ * correctly integrated.
+ *
+ * RK_CHAIN_FD_EULER updates the joint velocity first, and then updates
+ * the joint displacement with the updated velocity.
+ * RK_CHAIN_FD_RK4 evaluates the acceleration four times in a step.
+ *
+ * rkChainFDStepN() repeats rkChainFDStep() \a n times.
+ *
+ * The state of \a chain is the one at the last evaluation of the
+ * acceleration.
+ * \return
+ * rkChainFDStep() and rkChainFDStepN() return a pointer \a fd.
+ */
+__EXPORT rkChainFD *rkChainFDStep(rkChainFD *fd);
+__EXPORT rkChainFD *rkChainFDStepN(rkChainFD *fd, int n);
+
+__END_DECLS
+
+#endif /* __RK_CHAIN_FD_H__ */
@@ -48,6 +48,10 @@
 
 #define RK_ERR_MAT_VEC_SIZMISMATCH "unmatched matrix/vector size with joint size"
 
+#define RK_ERR_ABIENS_INVJOINT     "%s: %s joint is not supported by ABI ensemble"
+#define RK_ERR_ABIENS_INVMOTOR     "%s: %s motor is not supported by ABI ensemble"
+#define RK_ERR_ABIENS_PASSIVE      "%s: joint stiffness, viscosity and Coulomb friction are not supported by ABI ensemble"
+
 #define RK_ERR_CHAIN_INVSHAPE      "invalid model file"
 
 #define RK_ERR_LINK_MANY           "too many links defined"
@@ -59,6 +63,8 @@
 #define RK_ERR_SHAPE_UNKNOWN       "%s: unknown shape"
 
 #define RK_ERR_IK_UNKNOWN          "%s: unknown constraint type"
+#define RK_ERR_IK_SEQ_INVBIN       "%s: invalid binary IK sequence"
+#define RK_ERR_IK_SEED_INVFILE     "invalid or unmatched IK seed database"
 
 #define RK_ERR_FATAL               "fatal error! - please report to the author"
 
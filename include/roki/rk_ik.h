@@ -69,12 +69,52 @@ __BEGIN_DECLS
     kinematics, 'tol' is the tolerance of error, and 'iter' is
     the maximum number of iteration. When 'iter' is zero, the
     default number is applied.
+    In a loop with a hard deadline, use instead
+     rkIKSolveTimed( &ik, dis, tol, iter, budget );
+    which stops before exceeding 'budget' seconds and returns
+    the best posture found so far.
 
  9. rkIKDestroy( &ik );
     when terminating the program.
 
  * ***********************************************************/
 
+/*! \brief termination status of inverse kinematics solver. */
+typedef enum{
+  RK_IK_CONVERGED = 0, /*!< converged within the tolerance */
+  RK_IK_ITERMAX,       /*!< reached the maximum number of iterations */
+  RK_IK_TIMEOUT        /*!< ran out of the time budget */
+} rkIKStatus;
+
+/*! \brief statistics of the latest call of time-budgeted solver. */
+typedef struct{
+  rkIKStatus status; /*!< termination status */
+  int iter;          /*!< number of iterations */
+  double eval;       /*!< residual of the returned posture */
+  double time;       /*!< elapsed time [sec] */
+  double time_max;   /*!< the longest time of one iteration [sec] */
+} rkIKStat;
+
+/*! \brief trace of inverse kinematics iterations.
+ *
+ * Each record consists of RK_IK_TRACE_HEADSIZE values, namely, the
+ * serial number of iteration, the evaluation function, the norm of
+ * joint displacement step, the damping factor, the elapsed time of
+ * the iteration in seconds, and the residual errors of \a cellnum
+ * constraint cells in the order of registration, which are packed
+ * in a fixed-size ring buffer.
+ */
+typedef struct{
+  int size;    /*!< capacity of the ring buffer */
+  int cellnum; /*!< number of constraint cells recorded */
+  int head;    /*!< index of the oldest record */
+  int num;     /*!< number of records */
+  int count;   /*!< serial number of iteration */
+  double *buf; /*!< ring buffer */
+} rkIKTrace;
+
+#define RK_IK_TRACE_HEADSIZE 5
+
 typedef struct _rkIK{
   rkChain *chain;       /* a pointer to a kinematic chain */
 
@@ -83,9 +123,13 @@ typedef struct _rkIK{
   zVec joint_vel;       /* joint velocity */
   double eval;          /* evaluation function */
 
+  rkIKStat stat;        /* statistics of the latest solution */
+  rkIKTrace trace;      /* trace of iterations */
+  struct _rkIKSeedDB *seed; /* seed database */
+
   rkIKCellList clist;   /* constraint cell list */
   zMat _c_mat_cell;     /* constraint coefficient matrix cell */
-  zVec3D _c_srv_cell;   /* strict referential velocity vector cell */
+  zVec6D _c_srv_cell;   /* strict referential velocity vector cell */
 
   zIndex _j_idx;        /* cooperative joint index */
   zIndex _j_ofs;        /* reverse index */
@@ -95,6 +139,8 @@ typedef struct _rkIK{
   zVec _c_srv;          /* strict referential velocity vector */
   zVec _c_we;           /* weight on residual constraint error */
   zVec (*_jv)(struct _rkIK*); /* joint velocity computation method */
+  zVec _dis_best;       /* the best posture found in iteration */
+  double _damp;         /* damping factor of the latest iteration */
   /* workspace for joint velocity computation */
   zLE __le;
   zVec __c;
@@ -169,6 +215,15 @@ __EXPORT rkIKCell *rkIKCellRegL2LAtt(rkIK *ik, rkIKCellAttr *attr, int mask);
 __EXPORT rkIKCell *rkIKCellRegCOM(rkIK *ik, rkIKCellAttr *attr, int mask);
 __EXPORT rkIKCell *rkIKCellRegAM(rkIK *ik, rkIKCellAttr *attr, int mask);
 __EXPORT rkIKCell *rkIKCellRegAMCOM(rkIK *ik, rkIKCellAttr *attr, int mask);
+/*! \brief register a constraint cell of the position and attitude of a link.
+ *
+ * rkIKCellRegWldFrame() registers a six-component constraint cell
+ * on the frame of a link in the world frame, which computes both
+ * the linear and angular Jacobian matrices in a single traversal.
+ * Its reference is set by rkIKCellSetRefFrame(). Note that
+ * rkIKCellSetRef() only sets the position of the reference.
+ */
+__EXPORT rkIKCell *rkIKCellRegWldFrame(rkIK *ik, rkIKCellAttr *attr, int mask);
 
 __EXPORT rkIKCell *rkIKFindCell(rkIK *ik, int id);
 
@@ -212,15 +267,82 @@ __EXPORT zVec rkIKJointVelAD(rkIK *ik);
  * rkIKSolve() solves the invserse kinematics with numerical
  * iteration based on Levenberg=Marquardt's method, repetitively
  * calling rkIKSolveOne().
+ *
+ * rkIKSolveTimed() does the same with rkIKSolve() within a time
+ * budget \a budget in seconds. A monotonic clock is checked
+ * between iterations, and the iteration stops before the elapsed
+ * time is expected to exceed \a budget, estimating the time of
+ * the next iteration from the longest one so far. At least one
+ * iteration is always done, and exactly one if \a budget is zero
+ * unless it converges. When it stops without convergence,
+ * \a dis and the posture of the chain are set for the best
+ * iterate in terms of the residual error.
+ * The termination status, the number of iterations, the residual
+ * error and the elapsed time are stored in the internal statistics
+ * of \a ik, which is accessed by rkIKLastStat().
  * \return
  * Neither rkIKEq() nor rkIKSolveOne() return any values.
  *
  * rkIKSolve() returns the number of iteration.
+ *
+ * rkIKSolveTimed() returns the termination status.
  */
 __EXPORT void rkIKEq(rkIK *ik);
 __EXPORT zVec rkIKSolveRate(rkIK *ik);
 __EXPORT zVec rkIKSolveOne(rkIK *ik, zVec dis, double dt);
 __EXPORT int rkIKSolve(rkIK *ik, zVec dis, double tol, int iter);
+__EXPORT rkIKStatus rkIKSolveTimed(rkIK *ik, zVec dis, double tol, int iter, double budget);
+
+/*! \brief set a seed database of inverse kinematics.
+ *
+ * rkIKSetSeedDB() sets a seed database \a db (see rk_ik_seed.h)
+ * for \a ik. Then, rkIKSolve() and rkIKSolveTimed() start the
+ * iteration from the joint displacement of the nearest seed to
+ * the references of constraints in \a db, if any. Setting the null
+ * pointer, they start from the current posture of the chain.
+ */
+#define rkIKSetSeedDB(ik,db) ( (ik)->seed = (db) )
+
+/*! \brief statistics of the latest call of rkIKSolveTimed(). */
+#define rkIKLastStat(ik) ( &(ik)->stat )
+
+/*! \brief trace inverse kinematics iterations.
+ *
+ * rkIKTraceAlloc() allocates a ring buffer of \a ik to record the
+ * latest \a size iterations, and turns on the trace. The residual
+ * errors of constraint cells registered at the time are recorded,
+ * so that it should be called after registering all the cells.
+ * Since all the workspace is prepared here, no memory allocation
+ * occurs during iterations.
+ * rkIKTraceFree() frees the ring buffer and turns off the trace.
+ * rkIKTraceReset() discards all the records.
+ *
+ * rkIKTraceRec() returns a pointer to the \a i'th record from the
+ * oldest one. It is an array of RK_IK_TRACE_HEADSIZE + cellnum
+ * values (see rkIKTrace).
+ *
+ * rkIKTraceFPrintCSV() outputs the records to a file \a fp in CSV
+ * format, one line per an iteration.
+ * rkIKTraceFWrite() outputs the records to a file \a fp in binary
+ * format, namely, the number of records and the number of cells
+ * as int followed by the records as arrays of double.
+ * \return
+ * rkIKTraceAlloc() returns a pointer to the trace if succeeding,
+ * or the null pointer otherwise.
+ * rkIKTraceRec() returns the null pointer if \a i is out of range.
+ * rkIKTraceFWrite() returns the true value if succeeding, or the
+ * false value if failing to write.
+ * The others return no values.
+ */
+__EXPORT rkIKTrace *rkIKTraceAlloc(rkIK *ik, int size);
+__EXPORT void rkIKTraceFree(rkIK *ik);
+__EXPORT void rkIKTraceReset(rkIK *ik);
+#define rkIKTraceIsOn(ik) ( (ik)->trace.buf != NULL )
+#define rkIKTraceRecSize(ik) ( RK_IK_TRACE_HEADSIZE + (ik)->trace.cellnum )
+#define rkIKTraceRecNum(ik)  (ik)->trace.num
+__EXPORT double *rkIKTraceRec(rkIK *ik, int i);
+__EXPORT void rkIKTraceFPrintCSV(FILE *fp, rkIK *ik);
+__EXPORT bool rkIKTraceFWrite(FILE *fp, rkIK *ik);
 
 /* ********************************************************** */
 /* IK configuration file I/O
@@ -239,5 +361,6 @@ __END_DECLS
 
 #include <roki/rk_ik_seq.h> /* inverse kinematics sequence */
 #include <roki/rk_ik_imp.h> /* inverse kinematics impedance control */
+#include <roki/rk_ik_seed.h> /* inverse kinematics seed database */
 
 #endif /* __RK_IK_H__ */
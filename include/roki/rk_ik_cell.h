@@ -17,14 +17,19 @@ __BEGIN_DECLS
  * ********************************************************** */
 
 typedef union{
-  zVec3D pos; /*!< position reference */
-  zMat3D att; /*!< attitude reference */
+  zVec3D pos;     /*!< position reference */
+  zMat3D att;     /*!< attitude reference */
+  zFrame3D frame; /*!< frame reference, where pos is aliased to the position */
 } rkIKRef;
 
 typedef struct{
   union{
     zVec3D p; /*!< accumulated position error */
     zEP e;    /*!< accumulated attitude error by Euler parameter */
+    struct{
+      zVec3D p; /*!< accumulated position error */
+      zEP e;    /*!< accumulated attitude error by Euler parameter */
+    } f;        /*!< accumulated frame error */
   } ae, e_old; /*!< accumulated error */
   zVec3D h_old;
 } rkIKAcm;
@@ -79,6 +84,7 @@ typedef struct{
   rkIKBind_fp _bind_fp;
   rkIKAcm_fp _acm_fp;
   int index_offset;
+  int _dim;      /* number of constrained components (3 or 6) */
   double _eval;  /* weighted-squared norm of residual */
   /* void-type pointer for utility */
   void *_util;
@@ -86,6 +92,19 @@ typedef struct{
 
 zListClass( rkIKCellList, rkIKCell, rkIKCellDat );
 
+/*! \brief the maximum number of components constrained by a cell.
+ *
+ * A cell constrains three components in general. A cell for a frame
+ * constrains six components, namely, the linear ones followed by the
+ * angular ones. Its Jacobian function computes a 6xn matrix, and its
+ * residual function and error accumulation function takes a pointer
+ * to zVec3D as the head of six values (zVec6D). The constraint mode
+ * and the weight are applied both to the linear and angular ones.
+ */
+#define RK_IK_CELL_DIM_MAX 6
+
+#define rkIKCellDim(c) (c)->data._dim
+
 /* intialize a cell */
 __EXPORT void rkIKCellInit(rkIKCell *cell, rkIKCellAttr *attr, int mask, rkIKRef_fp rf, rkIKCMat_fp mf, rkIKSRV_fp vf, rkIKBind_fp bf, rkIKAcm_fp af, void *util);
 
@@ -108,6 +127,10 @@ __EXPORT void rkIKCellInit(rkIKCell *cell, rkIKCellAttr *attr, int mask, rkIKRef
 } while(0)
 #define rkIKCellSetRefVec(c,v) \
   rkIKCellSetRef(c,(v)->e[0],(v)->e[1],(v)->e[2])
+#define rkIKCellSetRefFrame(c,f) do{\
+  rkIKCellEnable( c );\
+  zFrame3DCopy( f, &(c)->data.ref.frame );\
+} while(0)
 
 #define rkIKCellSetRefForce(c,v1,v2,v3) do{\
   rkIKCellForce( c );\
@@ -143,6 +166,7 @@ __EXPORT zMat rkIKJacobiLinkL2LAng(rkChain *chain, rkIKCellAttr *attr, zMat j);
 __EXPORT zMat rkIKJacobiCOM(rkChain *chain, rkIKCellAttr *attr, zMat j);
 __EXPORT zMat rkIKJacobiAM(rkChain *chain, rkIKCellAttr *attr, zMat j);
 __EXPORT zMat rkIKJacobiAMCOM(rkChain *chain, rkIKCellAttr *attr, zMat j);
+__EXPORT zMat rkIKJacobiLinkWld(rkChain *chain, rkIKCellAttr *attr, zMat j);
 
 /* displacement error */
 __EXPORT zVec3D *rkIKLinkWldPosErr(rkChain *chain, rkIKCellAttr *attr, void *util, rkIKRef *ref, zVec3D *err);
@@ -152,6 +176,7 @@ __EXPORT zVec3D *rkIKLinkL2LAttErr(rkChain *chain, rkIKCellAttr *attr, void *uti
 __EXPORT zVec3D *rkIKCOMErr(rkChain *chain, rkIKCellAttr *attr, void *util, rkIKRef *ref, zVec3D *err);
 __EXPORT zVec3D *rkIKAMErr(rkChain *chain, rkIKCellAttr *attr, void *util, rkIKRef *ref, zVec3D *err);
 __EXPORT zVec3D *rkIKAMCOMErr(rkChain *chain, rkIKCellAttr *attr, void *util, rkIKRef *ref, zVec3D *err);
+__EXPORT zVec3D *rkIKLinkWldErr(rkChain *chain, rkIKCellAttr *attr, void *util, rkIKRef *ref, zVec3D *err);
 
 /* bind current position/attitude */
 __EXPORT void rkIKBindLinkWldPos(rkChain *chain, rkIKCellAttr *attr, void *util, rkIKRef *ref);
@@ -161,11 +186,13 @@ __EXPORT void rkIKBindLinkL2LAtt(rkChain *chain, rkIKCellAttr *attr, void *util,
 __EXPORT void rkIKBindCOM(rkChain *chain, rkIKCellAttr *attr, void *util, rkIKRef *ref);
 __EXPORT void rkIKBindAM(rkChain *chain, rkIKCellAttr *attr, void *util, rkIKRef *ref);
 __EXPORT void rkIKBindAMCOM(rkChain *chain, rkIKCellAttr *attr, void *util, rkIKRef *ref);
+__EXPORT void rkIKBindLinkWld(rkChain *chain, rkIKCellAttr *attr, void *util, rkIKRef *ref);
 
 /* error accumulation correction */
 
 __EXPORT zVec3D *rkIKAcmPos(rkChain *chain, rkIKAcm *acm, void *util, zVec3D *srv);
 __EXPORT zVec3D *rkIKAcmAtt(rkChain *chain, rkIKAcm *acm, void *util, zVec3D *srv);
+__EXPORT zVec3D *rkIKAcmFrame(rkChain *chain, rkIKAcm *acm, void *util, zVec3D *srv);
 
 __END_DECLS
 
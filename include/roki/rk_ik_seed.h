@@ -0,0 +1,115 @@
+/* RoKi - Robot Kinetics library
+ * Copyright (C) 1998 Tomomichi Sugihara (Zhidao)
+ *
+ * rk_ik_seed - inverse kinematics: seed database
+ */
+
+#ifndef __RK_IK_SEED_H__
+#define __RK_IK_SEED_H__
+
+/* NOTE: never include this header file in user programs. */
+
+__BEGIN_DECLS
+
+/* ********************************************************** */
+/* CLASS: rkIKSeedDB
+ * database of solutions of inverse kinematics to be seeds
+ * ********************************************************** */
+
+/*! \brief IK seed database.
+ *
+ * A set of pairs of a key, which is a set of the referential values
+ * of the constraint cells, and a joint displacement vector, indexed
+ * by a kd-tree for the nearest neighbor lookup.
+ * A key of a cell with position-type reference consists of the
+ * referential position (vector), and that with attitude-type
+ * reference consists of the angle-axis vector of the referential
+ * attitude. Keys of disabled cells are zero.
+ */
+typedef struct _rkIKSeedDB{
+  int keysize; /*!< size of a key */
+  int dissize; /*!< size of a joint displacement vector */
+  int num;     /*!< number of entries */
+  double radius; /*!< the maximum distance of keys to be adopted */
+  /*! \cond */
+  int _size;     /* capacity of entries */
+  double *_key;  /* keys */
+  double *_dis;  /* joint displacements */
+  int *_left;    /* left children in kd-tree */
+  int *_right;   /* right children in kd-tree */
+  double *_kbuf; /* workspace for a key */
+  /*! \endcond */
+} rkIKSeedDB;
+
+#define rkIKSeedDBKey(db,i) ( (db)->_key + (i)*(db)->keysize )
+#define rkIKSeedDBDis(db,i) ( (db)->_dis + (i)*(db)->dissize )
+
+/*! \brief create and destroy IK seed database.
+ *
+ * rkIKSeedDBCreate() creates an empty IK seed database \a db for
+ * an inverse kinematics solver \a ik. The size of keys is fixed
+ * for the constraint cells registered to \a ik at the time.
+ * rkIKSeedDBDestroy() destroys \a db.
+ * \return
+ * rkIKSeedDBCreate() returns a pointer \a db if succeeding, or
+ * the null pointer otherwise.
+ * rkIKSeedDBDestroy() returns no value.
+ */
+__EXPORT rkIKSeedDB *rkIKSeedDBCreate(rkIKSeedDB *db, rkIK *ik);
+__EXPORT void rkIKSeedDBDestroy(rkIKSeedDB *db);
+
+/*! \brief add and find a seed of inverse kinematics.
+ *
+ * rkIKSeedDBKeyIK() computes the key of the current references of
+ * constraint cells of \a ik, and stores it to \a key. A cell adds
+ * its position or the angle-axis vector of its attitude to the key,
+ * and a cell for a frame adds both of them.
+ *
+ * rkIKSeedDBAdd() adds a pair of a key \a key and a joint
+ * displacement vector \a dis to \a db.
+ * rkIKSeedDBAddIK() adds a pair of the key of the current
+ * references of \a ik and \a dis, which is typically a solution
+ * of the inverse kinematics.
+ *
+ * rkIKSeedDBNN() finds the nearest neighbor of \a key in \a db.
+ * The distance is stored in \a dist if it is not the null pointer.
+ * rkIKSeedDBFind() finds the nearest neighbor of the current
+ * references of \a ik, and copies its joint displacement to \a dis,
+ * if the distance is less than db->radius.
+ * \return
+ * rkIKSeedDBAdd() and rkIKSeedDBAddIK() return the false value if
+ * failing to allocate memory, or the true value otherwise.
+ * rkIKSeedDBNN() returns the index of the nearest neighbor, or -1
+ * if \a db is empty.
+ * rkIKSeedDBFind() returns \a dis if found, or the null pointer
+ * otherwise.
+ */
+__EXPORT double *rkIKSeedDBKeyIK(rkIKSeedDB *db, rkIK *ik, double *key);
+__EXPORT bool rkIKSeedDBAdd(rkIKSeedDB *db, double *key, zVec dis);
+__EXPORT bool rkIKSeedDBAddIK(rkIKSeedDB *db, rkIK *ik, zVec dis);
+__EXPORT int rkIKSeedDBNN(rkIKSeedDB *db, double *key, double *dist);
+__EXPORT zVec rkIKSeedDBFind(rkIKSeedDB *db, rkIK *ik, zVec dis);
+
+/*! \brief read and write IK seed database.
+ *
+ * rkIKSeedDBFWrite() writes \a db to a file \a fp in binary format.
+ * rkIKSeedDBFRead() reads entries from \a fp, and adds them to
+ * \a db, which has to be created for the same keys and joint
+ * displacement vectors in advance.
+ * rkIKSeedDBWriteFile() and rkIKSeedDBReadFile() do the same with
+ * a file named \a filename.
+ * \return
+ * All these functions return the true value if succeeding, or the
+ * false value otherwise.
+ */
+#define RK_IKSEED_MAGIC  "RKIKSEED"
+#define RK_IKSEED_SUFFIX "zik"
+
+__EXPORT bool rkIKSeedDBFWrite(FILE *fp, rkIKSeedDB *db);
+__EXPORT bool rkIKSeedDBFRead(FILE *fp, rkIKSeedDB *db);
+__EXPORT bool rkIKSeedDBWriteFile(rkIKSeedDB *db, char filename[]);
+__EXPORT bool rkIKSeedDBReadFile(rkIKSeedDB *db, char filename[]);
+
+__END_DECLS
+
+#endif /* __RK_IK_SEED_H__ */
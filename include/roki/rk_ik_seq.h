@@ -23,6 +23,7 @@ typedef struct{
   double dt;
   int nc;
   rkIKEntry *entry;
+  int _size; /* capacity of entries owned by the cell */
 } rkIKSeqCell;
 
 /*! \brief initialize IK sequence cell. */
@@ -30,8 +31,12 @@ typedef struct{
   (c)->dt = 0;\
   (c)->nc = 0;\
   (c)->entry = NULL;\
+  (c)->_size = 0;\
 } while(0)
 
+/*! \brief free entries of IK sequence cell. */
+__EXPORT void rkIKSeqCellFree(rkIKSeqCell *c);
+
 /*! \brief set IK cell to IK solver. */
 __EXPORT void rkIKSeqCellSet(rkIK *ik, rkIKSeqCell *c);
 
@@ -60,6 +65,87 @@ __EXPORT bool rkIKSeqScanFile(rkIKSeq *seq, char filename[]);
 __EXPORT rkIKSeq *rkIKSeqFScan(FILE *fp, rkIKSeq *seq);
 #define rkIKSeqScan(seq) rkIKSeqFScan( stdin, seq )
 
+/*! \brief scan and print an IK sequence cell one by one.
+ *
+ * rkIKSeqCellFScan() scans an IK sequence cell \a c from the
+ * current position of a file \a fp in the text format. It reuses
+ * the entries of \a c, and reallocates them only if the number of
+ * entries exceeds its capacity, so that an unbounded sequence is
+ * processed with a constant memory through a pipe, for instance.
+ * rkIKSeqCellFPrint() prints \a c out to \a fp in the text format.
+ * \return
+ * rkIKSeqCellFScan() returns the false value at the end of file
+ * or if failing to allocate memory. Otherwise, the true value is
+ * returned.
+ * rkIKSeqCellFPrint() returns no value.
+ */
+__EXPORT bool rkIKSeqCellFScan(FILE *fp, rkIKSeqCell *c);
+#define rkIKSeqCellScan(c) rkIKSeqCellFScan( stdin, c )
+__EXPORT void rkIKSeqCellFPrint(FILE *fp, rkIKSeqCell *c);
+
+/*! \brief binary format of an IK sequence.
+ *
+ * A binary IK sequence consists of a header RK_IKSEQ_BIN_MAGIC
+ * (8 bytes) followed by cells. Each cell is a rkIKSeqBinHead
+ * (the time interval and the number of entries) followed by the
+ * array of rkIKEntry as they are in memory, so that a memory-mapped
+ * file is accessed without copying. Note that the format depends
+ * on the byte order and the alignment of the host.
+ *
+ * rkIKSeqBinFWriteHeader() writes the header to a file \a fp, and
+ * rkIKSeqBinFReadHeader() reads and validates it.
+ * rkIKSeqCellFWrite() writes an IK sequence cell \a c to \a fp,
+ * and rkIKSeqCellFRead() reads it in the same manner with
+ * rkIKSeqCellFScan().
+ * \return
+ * rkIKSeqBinFWriteHeader() and rkIKSeqCellFWrite() return the
+ * false value if failing to write. Otherwise, the true value.
+ * rkIKSeqBinFReadHeader() returns the false value for an invalid
+ * header. Otherwise, the true value.
+ * rkIKSeqCellFRead() returns the false value at the end of file
+ * or for a broken file. Otherwise, the true value.
+ */
+#define RK_IKSEQ_BIN_MAGIC "RKIKSEQ1"
+#define RK_IKSEQ_BIN_SUFFIX "zenb"
+
+typedef struct{
+  double dt;
+  int nc;
+  int _pad; /* for alignment of entries */
+} rkIKSeqBinHead;
+
+__EXPORT bool rkIKSeqBinFWriteHeader(FILE *fp);
+__EXPORT bool rkIKSeqBinFReadHeader(FILE *fp);
+__EXPORT bool rkIKSeqCellFWrite(FILE *fp, rkIKSeqCell *c);
+__EXPORT bool rkIKSeqCellFRead(FILE *fp, rkIKSeqCell *c);
+
+/*! \brief memory-mapped binary IK sequence.
+ *
+ * rkIKSeqMapOpen() maps a binary IK sequence file \a filename
+ * onto memory \a map.
+ * rkIKSeqMapNext() sets the next cell of \a map for \a c. The
+ * entries of \a c points the mapped memory directly, which are
+ * valid until rkIKSeqMapClose() unmaps \a map. Hence, \a c must
+ * not be freed by rkIKSeqCellFree().
+ * rkIKSeqMapRewind() rewinds \a map to the first cell.
+ * \return
+ * rkIKSeqMapOpen() returns a pointer \a map if succeeding, or the
+ * null pointer otherwise.
+ * rkIKSeqMapNext() returns the false value at the end of file or
+ * for a broken file. Otherwise, the true value.
+ * The others return no values.
+ */
+typedef struct{
+  char *addr;
+  size_t size;
+  size_t cur;
+} rkIKSeqMap;
+
+__EXPORT rkIKSeqMap *rkIKSeqMapOpen(rkIKSeqMap *map, char filename[]);
+__EXPORT void rkIKSeqMapClose(rkIKSeqMap *map);
+__EXPORT bool rkIKSeqMapNext(rkIKSeqMap *map, rkIKSeqCell *c);
+#define rkIKSeqMapRewind(map) ( (map)->cur = sizeof(RK_IKSEQ_BIN_MAGIC)-1 )
+
 /*! \brief print an IK sequence out to a file. */
 __EXPORT bool rkIKSeqPrintFile(rkIKSeq *seq, char filename[]);
 /*! \brief print an IK sequence out to the current position of a file. */
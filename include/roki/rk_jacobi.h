@@ -27,16 +27,23 @@ __BEGIN_DECLS
  * of a kinematic chain \a r. The orientation of the relative velocity is with
  * respect to the world frame.
  *
+ * rkChainLinkWldJacobi() calculates 6xn Jacobian matrix which maps the
+ * whole joint velocity to the linear velocity of \a p attached to the \a id'th
+ * link (the upper three rows) and the angular velocity of the link (the lower
+ * three rows) with respect to the world frame at once in a single traversal
+ * of the path to the root.
+ *
  * For all these functions, the result is stored where is pointed by \a jacobi.
  * \return
  * rkChainLinkWldAngJacobi(), rkChainLinkWldLinJacobi(),
- * rkChainLinkToLinkAngJacobi() and
- * rkChainLinkToLinkLinJacobi()' return a pointer \a jacobi.
+ * rkChainLinkToLinkAngJacobi(), rkChainLinkToLinkLinJacobi() and
+ * rkChainLinkWldJacobi() return a pointer \a jacobi.
  */
 __EXPORT zMat rkChainLinkWldAngJacobi(rkChain *c, int id, zMat jacobi);
 __EXPORT zMat rkChainLinkWldLinJacobi(rkChain *c, int id, zVec3D *p, zMat jacobi);
 __EXPORT zMat rkChainLinkToLinkAngJacobi(rkChain *c, int from, int to, zMat jacobi);
 __EXPORT zMat rkChainLinkToLinkLinJacobi(rkChain *c, int from, int to, zVec3D *p, zMat jacobi);
+__EXPORT zMat rkChainLinkWldJacobi(rkChain *c, int id, zVec3D *p, zMat jacobi);
 
 /*! \brief COM Jacobian matrix
  *
@@ -62,6 +62,7 @@ typedef struct{
   /* axis vector */
   zVec3D* (**_angaxis)(void*,zFrame3D*,zVec3D*); /* angular */
   zVec3D* (**_linaxis)(void*,zFrame3D*,zVec3D*); /* linear */
+  void (*_axisvel)(void*,int,zVec6D*); /* motion rate of axes */
 
   /* for forward dynamics */
   void (*_setfrictionpivot)(void*,rkJointFrictionPivot*); /* set referential displacement of friction */
@@ -274,6 +275,23 @@ __EXPORT void rkJointIncRate(rkJoint *j, zVec3D *w, zVec6D *vel, zVec6D *acc);
 __EXPORT zVec3D *_rkJointAxisNull(void *prp, zFrame3D *f, zVec3D *a);
 __EXPORT zVec3D *_rkJointAxisZ(void *prp, zFrame3D *f, zVec3D *a);
 
+/*! \brief motion rate of a joint axis.
+ *
+ * rkJointAxisVel() computes the velocity of the frame to which the
+ * \a i'th axis of a joint \a j is fixed relative to the parent link.
+ * It is zero for the axes fixed to the parent link, e.g. those of
+ * revolute, prismatic, cylindrical and spherical joints, while the
+ * second axis of a universal joint and the angular axes of a free-
+ * floating joint are carried by the other components.
+ * The result is put into \a v with respect to the frame of the link
+ * with \a j and about its origin.
+ * \notes
+ * rkJointAxisVel() does not check if \a i is valid.
+ */
+#define rkJointAxisVel(j,i,v) (j)->com->_axisvel( (j)->prp, i, v )
+
+__EXPORT void _rkJointAxisVelNull(void *prp, int i, zVec6D *v);
+
 __EXPORT double rkJointRevolTorsionDis(zFrame3D *dev, zVec6D *t);
 __EXPORT double rkJointPrismTorsionDis(zFrame3D *dev, zVec6D *t);
 
@@ -30,6 +30,8 @@ typedef struct{
   zVec6D b0; /* ABbios at no rigid contact forces */
   zVec6D a0; /* link acc at no rigid contact forces */
   bool abi_backward_path;
+  bool acc_spec; /* acceleration-specified joint in hybrid dynamics */
+  int size; /* number of links of the subtree for branch-parallel computation */
   /* joint inertia */
   zMat axi, iaxi;
 } rkABIPrp;
@@ -320,6 +322,11 @@ __EXPORT zMat3D *rkLinkWldInertia(rkLink *l, zMat3D *i);
  * orientation of those velocity and acceleration are with
  * repect to the frame of \a l itself.
  *
+ * rkLinkUpdateRateStatic() updates the velocity and acceleration
+ * of \a l supposing that all the joints are at rest, namely, only
+ * the acceleration of gravity \a pacc given at the parent is
+ * propagated.
+ *
  * rkLinkUpdateForce() updates the joint force of \a l. It
  * recursively computes the joint forces of the descendants
  * of \a l, accumulating them and subtracting them from the
@@ -327,6 +334,9 @@ __EXPORT zMat3D *rkLinkWldInertia(rkLink *l, zMat3D *i);
  * Newton=Euler s method proposed by Luh, Walker and Paul(1980).
  * Note that the orientation of those force and torque are
  * with repect to the frame of \a l itself.
+ * rkLinkUpdateWrenchNoTrq() does the same computation with
+ * rkLinkUpdateWrench() except that the joint wrenches are not
+ * resolved to the joint torques.
  * \return
  * All these functions return no values.
  * \notes
@@ -341,7 +351,9 @@ __EXPORT void rkLinkUpdateFrame(rkLink *l, zFrame3D *pwf);
 __EXPORT void rkLinkUpdateVel(rkLink *l, zVec6D *pvel);
 __EXPORT void rkLinkUpdateAcc(rkLink *l, zVec6D *pvel, zVec6D *pacc);
 __EXPORT void rkLinkUpdateRate(rkLink *l, zVec6D *pvel, zVec6D *pacc);
+__EXPORT void rkLinkUpdateRateStatic(rkLink *l, zVec6D *pacc);
 __EXPORT void rkLinkUpdateWrench(rkLink *l);
+__EXPORT void rkLinkUpdateWrenchNoTrq(rkLink *l);
 
 __EXPORT void rkLinkConfToJointDis(rkLink *l);
 
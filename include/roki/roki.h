@@ -20,5 +20,7 @@
 #include <roki/rk_ik.h>
 #include <roki/rk_cd.h>
 #include <roki/rk_abi.h>
+#include <roki/rk_abi_ens.h>
+#include <roki/rk_chain_fd.h>
 
 #endif /* __ROKI_H__ */
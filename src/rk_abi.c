@@ -5,8 +5,16 @@
  * contributer: 2014-2015 Naoki Wakisaka
  */
 
+/* for POSIX threads */
+#include <unistd.h>
+
 #include <roki/rk_abi.h>
 
+#if defined(_POSIX_THREADS) && _POSIX_THREADS > 0
+#define __RK_ABI_MT
+#include <pthread.h>
+#endif
+
 /* initialize invariant mass properties. */
 static void _rkLinkABIInitInertia(rkLink *link)
 {
@@ -46,6 +54,17 @@ rkLink *rkLinkABIAlloc(rkLink *link)
   return link;
 }
 
+/* count links of a subtree for branch-parallel computation. */
+static int _rkLinkABISetSubtreeSize(rkLink *link)
+{
+  rkLink *c;
+
+  rkLinkABIPrp(link)->size = 1;
+  for( c=rkLinkChild(link); c; c=rkLinkSibl(c) )
+    rkLinkABIPrp(link)->size += _rkLinkABISetSubtreeSize( c );
+  return rkLinkABIPrp(link)->size;
+}
+
 /* allocate memory for ABI of a kinematic chain. */
 rkChain *rkChainABIAlloc(rkChain *chain)
 {
@@ -58,6 +77,8 @@ rkChain *rkChainABIAlloc(rkChain *chain)
     rkChainABIDestroy( chain );
     return NULL;
   }
+  if( rkChainLinkNum(chain) > 0 )
+    _rkLinkABISetSubtreeSize( rkChainRoot(chain) );
   return chain;
 }
 
@@ -78,19 +99,17 @@ void rkChainABIDestroy(rkChain *chain)
     rkLinkABIDestroy( rkChainLink(chain,i) );
 }
 
-/* initialize ABI of a link for recursive computation. */
-void rkLinkABIUpdateInit(rkLink *link, zVec6D *pvel)
+/* initialize bias force and acceleration of a link for recursive computation. */
+static void _rkLinkABIUpdateInitBias(rkLink *link, zVec6D *pvel)
 {
   rkABIPrp *ap;
   zVec3D tmp;
 
   ap = rkLinkABIPrp(link);
-  /* I */
-  zMat6DCopy( &ap->m, &ap->i );
   /* b */
   zVec3DTripleProd( rkLinkAngVel(link), rkLinkAngVel(link), rkLinkCOM(link), &tmp);
   zVec3DMul( &tmp, rkLinkMass(link), zVec6DLin(&ap->f) );
-  zMulMat3DVec3D( &ap->i.e[1][1], rkLinkAngVel(link), &tmp );
+  zMulMat3DVec3D( &ap->m.e[1][1], rkLinkAngVel(link), &tmp );
   zVec3DOuterProd( rkLinkAngVel(link), &tmp, zVec6DAng(&ap->f) );
   zVec6DCopy( &ap->f, &ap->b );
   /* total external forces */
@@ -111,6 +130,14 @@ void rkLinkABIUpdateInit(rkLink *link, zVec6D *pvel)
   zVec3DAddDRC( zVec6DLin(&ap->c), &tmp );
 }
 
+/* initialize ABI of a link for recursive computation. */
+void rkLinkABIUpdateInit(rkLink *link, zVec6D *pvel)
+{
+  /* I */
+  zMat6DCopy( &rkLinkABIPrp(link)->m, &rkLinkABIPrp(link)->i );
+  _rkLinkABIUpdateInitBias( link, pvel );
+}
+
 /* initialize ABI of a kinematic chain for recursive computation. */
 void rkChainABIUpdateInit(rkChain *chain)
 {
@@ -132,8 +159,8 @@ static void _rkLinkABIAddBias(rkLink *link)
   rkJointABIAddBias( rkLinkJoint(link), &rkLinkABIPrp(link)->i, &icb, rkLinkAdjFrame(link), rkLinkABIPrp(link)->iaxi, &rkLinkABIPrp(rkLinkParent(link))->b );
 }
 
-/* update ABI of a link in backward computation. */
-static void _rkLinkABIUpdateBackward(rkLink *link)
+/* update ABI of a link itself in backward computation. */
+static void _rkLinkABIUpdateBackwardOne(rkLink *link)
 {
   rkABIPrp *ap;
 
@@ -143,13 +170,23 @@ static void _rkLinkABIUpdateBackward(rkLink *link)
   /* IsIs */
   rkJointABIAxisInertia( rkLinkJoint(link), &ap->i, ap->axi, ap->iaxi );
   rkJointABIDrivingTorque( rkLinkJoint(link) );
-  if( !rkLinkParent(link) ) return;
+}
 
-  /* add ABI and bias acceleration to parent prp */
-  rkJointABIAddABI( rkLinkJoint(link), &ap->i, rkLinkAdjFrame( link ), ap->iaxi, &rkLinkABIPrp(rkLinkParent(link))->i );
+/* add ABI and bias acceleration of a link to the parent. */
+static void _rkLinkABIAddParent(rkLink *link)
+{
+  if( !rkLinkParent(link) ) return;
+  rkJointABIAddABI( rkLinkJoint(link), &rkLinkABIPrp(link)->i, rkLinkAdjFrame( link ), rkLinkABIPrp(link)->iaxi, &rkLinkABIPrp(rkLinkParent(link))->i );
   _rkLinkABIAddBias( link );
 }
 
+/* update ABI of a link in backward computation. */
+static void _rkLinkABIUpdateBackward(rkLink *link)
+{
+  _rkLinkABIUpdateBackwardOne( link );
+  _rkLinkABIAddParent( link );
+}
+
 /* backward computation to update ABI of a link. */
 void rkLinkABIUpdateBackward(rkLink *link)
 {
@@ -203,6 +240,250 @@ void rkLinkABIUpdateForwardGetWrench(rkLink *link, zVec6D *pa)
     rkLinkABIUpdateForwardGetWrench( rkLinkChild(link), rkLinkAcc(link) );
 }
 
+/* branch-parallel computation of ABI.
+ *
+ * subtrees branching from a link are computed concurrently in the
+ * backward path, and ABIs of their roots are added to the link after
+ * joining them in order to avoid write conflicts. The forward path
+ * fans out in the same way. Subtrees are passed to a pool of worker
+ * threads, which is created at the first call and kept until
+ * rkChainABIPoolDestroy() is called, so that no thread is created in
+ * each computation. The number of links of each subtree is counted at
+ * rkChainABIAlloc(). */
+
+#define RK_ABI_MT_GRAIN      8 /* the minimum number of links of a subtree for a thread */
+#define RK_ABI_MT_BRANCH_MAX 8 /* the maximum number of threads forked at a link */
+
+typedef struct{
+  rkLink *link;
+  zVec6D *pa;
+  int nthread;
+  bool getwrench;
+} _rkABITask;
+
+#ifdef __RK_ABI_MT
+#define RK_ABI_MT_MAX   32 /* the maximum number of worker threads */
+#define RK_ABI_MT_QUEUE 64 /* the maximum number of queued subtrees */
+
+typedef struct{
+  _rkABITask *task;
+  void *(*task_fp)(void*);
+  int *pending; /* number of unfinished subtrees forked at the same link */
+} _rkABIJob;
+
+/* pool of worker threads shared by all kinematic chains */
+static struct{
+  pthread_mutex_t mutex;
+  pthread_cond_t cond_job;  /* signaled when a job is queued */
+  pthread_cond_t cond_done; /* signaled when jobs forked at a link are finished */
+  pthread_t thread[RK_ABI_MT_MAX];
+  int nthread;
+  bool quit; /* workers exit when it is set */
+  _rkABIJob queue[RK_ABI_MT_QUEUE];
+  int head;
+  int num;
+} _rk_abi_pool = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER };
+
+/* pop a job from the queue of the pool, which has to be locked. */
+static bool _rkABIPoolPop(_rkABIJob *job)
+{
+  if( _rk_abi_pool.num == 0 ) return false;
+  *job = _rk_abi_pool.queue[_rk_abi_pool.head];
+  _rk_abi_pool.head = ( _rk_abi_pool.head + 1 ) % RK_ABI_MT_QUEUE;
+  _rk_abi_pool.num--;
+  return true;
+}
+
+/* push a job to the queue of the pool, which has to be locked. */
+static bool _rkABIPoolPush(_rkABITask *task, void *(*task_fp)(void*), int *pending)
+{
+  _rkABIJob *job;
+
+  if( _rk_abi_pool.num >= RK_ABI_MT_QUEUE ) return false;
+  job = &_rk_abi_pool.queue[( _rk_abi_pool.head + _rk_abi_pool.num++ ) % RK_ABI_MT_QUEUE];
+  job->task = task;
+  job->task_fp = task_fp;
+  job->pending = pending;
+  (*pending)++;
+  pthread_cond_signal( &_rk_abi_pool.cond_job );
+  return true;
+}
+
+/* run a job out of the lock of the pool. */
+static void _rkABIPoolRun(_rkABIJob *job)
+{
+  pthread_mutex_unlock( &_rk_abi_pool.mutex );
+  job->task_fp( job->task );
+  pthread_mutex_lock( &_rk_abi_pool.mutex );
+  if( --*job->pending == 0 )
+    pthread_cond_broadcast( &_rk_abi_pool.cond_done );
+}
+
+static void *_rkABIPoolWorker(void *arg)
+{
+  _rkABIJob job;
+
+  pthread_mutex_lock( &_rk_abi_pool.mutex );
+  while( 1 ){
+    while( !_rkABIPoolPop( &job ) ){
+      if( _rk_abi_pool.quit ){
+        pthread_mutex_unlock( &_rk_abi_pool.mutex );
+        return NULL;
+      }
+      pthread_cond_wait( &_rk_abi_pool.cond_job, &_rk_abi_pool.mutex );
+    }
+    _rkABIPoolRun( &job );
+  }
+}
+
+/* create worker threads of the pool to be shared with the caller, which has to be locked. */
+static void _rkABIPoolReserve(int nthread)
+{
+  nthread = zMin( nthread, RK_ABI_MT_MAX ) - 1; /* the caller works as well */
+  for( ; _rk_abi_pool.nthread<nthread; _rk_abi_pool.nthread++ )
+    if( pthread_create( &_rk_abi_pool.thread[_rk_abi_pool.nthread], NULL, _rkABIPoolWorker, NULL ) != 0 ) break;
+}
+
+/* wait for jobs forked at a link, which runs queued jobs meanwhile.
+   The pool has to be locked. */
+static void _rkABIPoolJoin(int *pending)
+{
+  _rkABIJob job;
+
+  while( *pending > 0 ){
+    if( _rkABIPoolPop( &job ) )
+      _rkABIPoolRun( &job );
+    else
+      pthread_cond_wait( &_rk_abi_pool.cond_done, &_rk_abi_pool.mutex );
+  }
+}
+#endif /* __RK_ABI_MT */
+
+/* terminate worker threads of the pool for branch-parallel ABI. */
+void rkChainABIPoolDestroy(void)
+{
+#ifdef __RK_ABI_MT
+  register int i;
+
+  pthread_mutex_lock( &_rk_abi_pool.mutex );
+  _rk_abi_pool.quit = true;
+  pthread_cond_broadcast( &_rk_abi_pool.cond_job );
+  pthread_mutex_unlock( &_rk_abi_pool.mutex );
+  for( i=0; i<_rk_abi_pool.nthread; i++ )
+    pthread_join( _rk_abi_pool.thread[i], NULL );
+  _rk_abi_pool.nthread = 0;
+  _rk_abi_pool.quit = false;
+#endif
+}
+
+/* run a task for each child subtree of a link, forking threads if possible. */
+static void _rkLinkABIForkChildren(rkLink *link, zVec6D *pa, int nthread, bool getwrench, void *(*task_fp)(void*))
+{
+  rkLink *c;
+  _rkABITask task_self;
+  int m = 0, share;
+#ifdef __RK_ABI_MT
+  _rkABITask task[RK_ABI_MT_BRANCH_MAX];
+  int nfork = 0, pending = 0;
+#endif
+
+  for( c=rkLinkChild(link); c; c=rkLinkSibl(c) ) m++;
+  if( m == 0 ) return;
+  share = zMax( nthread / m, 1 );
+  task_self.pa = pa;
+  task_self.nthread = share;
+  task_self.getwrench = getwrench;
+  for( c=rkLinkChild(link); c; c=rkLinkSibl(c) ){
+#ifdef __RK_ABI_MT
+    if( rkLinkSibl(c) && nfork+1 < nthread && nfork < RK_ABI_MT_BRANCH_MAX &&
+        rkLinkABIPrp(c)->size >= RK_ABI_MT_GRAIN ){
+      task[nfork] = task_self;
+      task[nfork].link = c;
+      pthread_mutex_lock( &_rk_abi_pool.mutex );
+      _rkABIPoolReserve( nthread );
+      if( _rk_abi_pool.nthread > 0 && _rkABIPoolPush( &task[nfork], task_fp, &pending ) ){
+        pthread_mutex_unlock( &_rk_abi_pool.mutex );
+        nfork++;
+        continue;
+      }
+      pthread_mutex_unlock( &_rk_abi_pool.mutex );
+    }
+#endif
+    task_self.link = c;
+    task_fp( &task_self );
+  }
+#ifdef __RK_ABI_MT
+  if( nfork > 0 ){
+    pthread_mutex_lock( &_rk_abi_pool.mutex );
+    _rkABIPoolJoin( &pending );
+    pthread_mutex_unlock( &_rk_abi_pool.mutex );
+  }
+#endif
+}
+
+/* add ABIs of siblings to the parent in the same order with the serial computation. */
+static void _rkLinkABIAddParentSibl(rkLink *link)
+{
+  if( rkLinkSibl(link) )
+    _rkLinkABIAddParentSibl( rkLinkSibl(link) );
+  _rkLinkABIAddParent( link );
+}
+
+static void *_rkLinkABIUpdateBackwardTask(void *arg);
+
+/* branch-parallel backward computation to update ABI of a subtree. */
+static void _rkLinkABIUpdateBackwardMT(rkLink *link, int nthread)
+{
+  _rkLinkABIForkChildren( link, NULL, nthread, false, _rkLinkABIUpdateBackwardTask );
+  if( rkLinkChild(link) )
+    _rkLinkABIAddParentSibl( rkLinkChild(link) );
+  _rkLinkABIUpdateBackwardOne( link );
+}
+
+static void *_rkLinkABIUpdateBackwardTask(void *arg)
+{
+  _rkLinkABIUpdateBackwardMT( ((_rkABITask *)arg)->link, ((_rkABITask *)arg)->nthread );
+  return NULL;
+}
+
+static void *_rkLinkABIUpdateForwardTask(void *arg);
+
+/* branch-parallel forward computation to update acceleration of a subtree. */
+static void _rkLinkABIUpdateForwardMT(rkLink *link, zVec6D *pa, int nthread, bool getwrench)
+{
+  _rkLinkABIUpdateForward( link, pa );
+  if( getwrench )
+    rkJointUpdateWrench( rkLinkJoint(link), &rkLinkABIPrp(link)->i, &rkLinkABIPrp(link)->b, rkLinkAcc(link) );
+  _rkLinkABIForkChildren( link, rkLinkAcc(link), nthread, getwrench, _rkLinkABIUpdateForwardTask );
+}
+
+static void *_rkLinkABIUpdateForwardTask(void *arg)
+{
+  _rkABITask *task;
+
+  task = arg;
+  _rkLinkABIUpdateForwardMT( task->link, task->pa, task->nthread, task->getwrench );
+  return NULL;
+}
+
+/* branch-parallel backward computation to update ABI of a kinematic chain. */
+void rkChainABIUpdateBackwardMT(rkChain *chain, int nthread)
+{
+  _rkLinkABIUpdateBackwardMT( rkChainRoot(chain), nthread );
+}
+
+/* branch-parallel forward computation to update acceleration from ABI of a kinematic chain. */
+void rkChainABIUpdateForwardMT(rkChain *chain, int nthread)
+{
+  _rkLinkABIUpdateForwardMT( rkChainRoot(chain), ZVEC6DZERO, nthread, false );
+}
+
+/* branch-parallel forward computation to update acceleration and wrench from ABI of a kinematic chain. */
+void rkChainABIUpdateForwardGetWrenchMT(rkChain *chain, int nthread)
+{
+  _rkLinkABIUpdateForwardMT( rkChainRoot(chain), ZVEC6DZERO, nthread, true );
+}
+
 /* zero velocity and acceleration of links of a kinematic chain. */
 static void _rkChainZeroLinkRate(rkChain *chain)
 {
@@ -236,6 +517,30 @@ void rkChainABIUpdateGetWrench(rkChain *chain)
   rkChainABIUpdateForwardGetWrench( chain );
 }
 
+/* update ABI and acceleration of a kinematic chain with branch-parallel computation. */
+void rkChainABIUpdateMT(rkChain *chain, int nthread)
+{
+  if( rkChainJointSize(chain) == 0 ){
+    _rkChainZeroLinkRate( chain );
+    return;
+  }
+  rkChainABIUpdateInit( chain );
+  rkChainABIUpdateBackwardMT( chain, nthread );
+  rkChainABIUpdateForwardMT( chain, nthread );
+}
+
+/* update ABI, acceleration and wrench of a kinematic chain with branch-parallel computation. */
+void rkChainABIUpdateGetWrenchMT(rkChain *chain, int nthread)
+{
+  if( rkChainJointSize(chain) == 0 ){
+    _rkChainZeroLinkRate( chain );
+    return;
+  }
+  rkChainABIUpdateInit( chain );
+  rkChainABIUpdateBackwardMT( chain, nthread );
+  rkChainABIUpdateForwardGetWrenchMT( chain, nthread );
+}
+
 /* compute accleration of a kinematic chain based on ABI method. */
 zVec rkChainABI(rkChain *chain, zVec dis, zVec vel, zVec acc)
 {
@@ -410,3 +715,419 @@ void rkChainABIUpdateAddExForceTwo(rkChain *chain, rkLink *link, rkWrench *w, rk
   _rkChainABIUpdateBackwardAddExForceTwo( chain, link, w, link2, w2 );
   rkChainABIUpdateForward( chain );
 }
+
+/* acceleration of a contact point along the contact axis. */
+static double _rkABIContactAxisAcc(rkABIContactAxis *axis)
+{
+  zVec3D a;
+
+  zVec3DOuterProd( zVec6DAng(rkLinkAcc(axis->link)), &axis->p, &a );
+  zVec3DAddDRC( &a, zVec6DLin(rkLinkAcc(axis->link)) );
+  zMulMat3DVec3DDRC( rkLinkWldAtt(axis->link), &a );
+  return zVec3DInnerProd( &a, &axis->n );
+}
+
+/* contact-space inverse inertia matrix of a kinematic chain. */
+zMat rkChainABIContactInvInertiaMat(rkChain *chain, int k, rkABIContactAxis axis[], zMat d)
+{
+  register int i, j;
+  rkWrench w;
+
+  if( zMatRowSizeNC(d) != k || zMatColSizeNC(d) != k ){
+    ZRUNERROR( RK_ERR_MAT_VEC_SIZMISMATCH );
+    return NULL;
+  }
+  /* accelerations at no rigid contact forces */
+  for( i=0; i<k; i++ )
+    zMatSetElemNC( d, i, 0, _rkABIContactAxisAcc( &axis[i] ) );
+  for( j=k-1; j>=0; j-- ){
+    rkWrenchInit( &w );
+    zMulMat3DTVec3D( rkLinkWldAtt(axis[j].link), &axis[j].n, rkWrenchForce(&w) );
+    rkWrenchSetPos( &w, &axis[j].p );
+    rkChainABIUpdateAddExForceTwo( chain, axis[j].link, &w, NULL, NULL );
+    for( i=0; i<k; i++ ) /* the first column keeps the biases until the end */
+      zMatElemNC(d,i,j) = _rkABIContactAxisAcc( &axis[i] ) - zMatElemNC(d,i,0);
+    rkChainABIPopPrpAccBiasAddExForceTwo( chain, axis[j].link, NULL );
+  }
+  return d;
+}
+
+/******************************************************************************/
+/* joint-space inverse inertia matrix
+ *
+ * a generalized force of a joint is equivalent to a pair of the wrench
+ * along the joint axes applied to the link and its reaction applied to
+ * the parent link. The response of the joint accelerations to them is
+ * computed by recomputing ABbias and the forward path with the
+ * articulated inertias kept.
+ */
+
+/* generalized force of a joint as a wrench with respect to the link frame. */
+static zVec6D *_rkLinkABIJointWrench(rkLink *link, double *v, int idx, zVec6D *w)
+{
+  register int k;
+  double val;
+  zVec3D a;
+
+  zVec6DZero( w );
+  for( k=0; k<rkLinkJointSize(link); k++ ){
+    val = v ? v[rkLinkOffset(link)+k] : ( rkLinkOffset(link)+k == idx ? 1 : 0 );
+    if( val == 0 ) continue;
+    if( rkJointLinAxis( rkLinkJoint(link), k, ZFRAME3DIDENT, &a ) )
+      zVec3DCatDRC( zVec6DLin(w), val, &a );
+    if( rkJointAngAxis( rkLinkJoint(link), k, ZFRAME3DIDENT, &a ) )
+      zVec3DCatDRC( zVec6DAng(w), val, &a );
+  }
+  return w;
+}
+
+/* backward computation to update ABbias of a link with generalized forces. */
+static void _rkLinkABIUpdateBackwardBiasJointForce(rkLink *link, double *v, int idx)
+{
+  rkLink *c;
+  zVec6D w, wp;
+
+  zVec6DSub( &rkLinkABIPrp(link)->f, &rkLinkABIPrp(link)->w, &rkLinkABIPrp(link)->b );
+  zVec6DSubDRC( &rkLinkABIPrp(link)->b, _rkLinkABIJointWrench( link, v, idx, &w ) );
+  for( c=rkLinkChild(link); c; c=rkLinkSibl(c) ){
+    _rkLinkABIUpdateBackwardBiasJointForce( c, v, idx );
+    /* reaction force from the child link */
+    zMulMat3DVec6D( rkLinkAdjAtt(c), _rkLinkABIJointWrench( c, v, idx, &w ), &wp );
+    zVec6DAngShiftDRC( &wp, rkLinkAdjPos(c) );
+    zVec6DAddDRC( &rkLinkABIPrp(link)->b, &wp );
+    _rkLinkABIAddBias( c );
+  }
+}
+
+/* response of joint accelerations to generalized forces. */
+static void _rkChainInvInertiaMulVec(rkChain *chain, double *v, int idx, double *a)
+{
+  register int i, k;
+  double acc[6];
+  rkLink *link;
+
+  for( i=0; i<rkChainLinkNum(chain); i++ )
+    if( rkChainLinkOffset(chain,i) >= 0 )
+      rkJointGetAcc( rkChainLinkJoint(chain,i), &a[rkChainLinkOffset(chain,i)] );
+  rkChainABIPushPrpAccBias( chain );
+  _rkLinkABIUpdateBackwardBiasJointForce( rkChainRoot(chain), v, idx );
+  rkChainABIUpdateForward( chain );
+  for( i=0; i<rkChainLinkNum(chain); i++ ){
+    link = rkChainLink(chain,i);
+    if( rkLinkOffset(link) < 0 ) continue;
+    rkJointGetAcc( rkLinkJoint(link), acc );
+    for( k=0; k<rkLinkJointSize(link); k++ ){
+      acc[k] -= a[rkLinkOffset(link)+k];
+      zSwap( double, acc[k], a[rkLinkOffset(link)+k] );
+    }
+    rkJointSetAcc( rkLinkJoint(link), acc ); /* restore joint accelerations */
+  }
+  rkChainABIPopPrpAccBias( chain );
+}
+
+/* multiply the inverse inertia matrix of a kinematic chain by a vector. */
+zVec rkChainInvInertiaMulVec(rkChain *chain, zVec v, zVec a)
+{
+  if( !zVecSizeIsEqual( v, a ) || zVecSizeNC(v) != rkChainJointSize(chain) ){
+    ZRUNERROR( RK_ERR_MAT_VEC_SIZMISMATCH );
+    return NULL;
+  }
+  if( rkChainJointSize(chain) == 0 ) return a;
+  _rkChainInvInertiaMulVec( chain, zVecBufNC(v), -1, zVecBufNC(a) );
+  return a;
+}
+
+/* joint-space inverse inertia matrix of a kinematic chain. */
+zMat rkChainInvInertiaMat(rkChain *chain, zMat m)
+{
+  register int j;
+
+  if( !zMatIsSqr( m ) || zMatRowSizeNC(m) != rkChainJointSize(chain) ){
+    ZRUNERROR( RK_ERR_MAT_VEC_SIZMISMATCH );
+    return NULL;
+  }
+  /* the matrix is symmetric, so that each column is stored in a row */
+  for( j=0; j<rkChainJointSize(chain); j++ )
+    _rkChainInvInertiaMulVec( chain, NULL, j, zMatRowBufNC(m,j) );
+  return m;
+}
+
+/******************************************************************************/
+/* operational-space inertia matrix */
+
+/* acceleration of a point on a link with respect to the world frame. */
+static zVec6D *_rkABILinkPointAcc(rkLink *link, zVec3D *p, zVec6D *a)
+{
+  zVec3D tmp;
+
+  zVec3DOuterProd( zVec6DAng(rkLinkAcc(link)), p, &tmp );
+  zVec3DAddDRC( &tmp, zVec6DLin(rkLinkAcc(link)) );
+  zMulMat3DVec3D( rkLinkWldAtt(link), &tmp, zVec6DLin(a) );
+  zMulMat3DVec3D( rkLinkWldAtt(link), zVec6DAng(rkLinkAcc(link)), zVec6DAng(a) );
+  return a;
+}
+
+/* inverse of operational-space inertia matrix of points on links. */
+zMat rkChainLinkOpSpaceInvInertia(rkChain *chain, int n, rkLink *link[], zVec3D p[], zMat m)
+{
+  register int i, j, k;
+  rkWrench w;
+  zVec3D e;
+  zVec6D a;
+
+  if( zMatRowSizeNC(m) != 6*n || zMatColSizeNC(m) != 6*n ){
+    ZRUNERROR( RK_ERR_MAT_VEC_SIZMISMATCH );
+    return NULL;
+  }
+  /* accelerations at no additional wrenches */
+  for( i=0; i<n; i++ ){
+    _rkABILinkPointAcc( link[i], &p[i], &a );
+    for( k=0; k<6; k++ )
+      zMatSetElemNC( m, 6*i+k, 0, a.e[k] );
+  }
+  for( j=6*n-1; j>=0; j-- ){
+    rkWrenchInit( &w );
+    zVec3DZero( &e );
+    e.e[j%3] = 1;
+    zMulMat3DTVec3D( rkLinkWldAtt(link[j/6]), &e, j%6 < 3 ? rkWrenchForce(&w) : rkWrenchTorque(&w) );
+    rkWrenchSetPos( &w, &p[j/6] );
+    rkChainABIUpdateAddExForceTwo( chain, link[j/6], &w, NULL, NULL );
+    for( i=0; i<n; i++ ){ /* the first column keeps the biases until the end */
+      _rkABILinkPointAcc( link[i], &p[i], &a );
+      for( k=0; k<6; k++ )
+        zMatElemNC(m,6*i+k,j) = a.e[k] - zMatElemNC(m,6*i+k,0);
+    }
+    rkChainABIPopPrpAccBiasAddExForceTwo( chain, link[j/6], NULL );
+  }
+  return m;
+}
+
+/* operational-space inertia matrix of points on links. */
+zMat rkChainLinkOpSpaceInertia(rkChain *chain, int n, rkLink *link[], zVec3D p[], zMat m, zMat lambda)
+{
+  if( !rkChainLinkOpSpaceInvInertia( chain, n, link, p, m ) ) return NULL;
+  return zMatInv( m, lambda );
+}
+
+/******************************************************************************/
+/* hybrid dynamics
+ *
+ * links with acceleration-specified joints pass their articulated body
+ * inertias to the parents without projection as well as fixed joints,
+ * and the bias accelerations include the specified joint accelerations.
+ */
+
+/* backward computation to update ABI of a link in hybrid dynamics. */
+static void _rkLinkHDUpdateBackward(rkLink *link)
+{
+  rkABIPrp *ap;
+  zMat6D tmpm;
+  zVec6D tmpv, icb;
+
+  if( rkLinkSibl(link) )
+    _rkLinkHDUpdateBackward( rkLinkSibl(link) );
+  if( rkLinkChild(link) )
+    _rkLinkHDUpdateBackward( rkLinkChild(link) );
+  ap = rkLinkABIPrp(link);
+  if( !ap->acc_spec ){
+    _rkLinkABIUpdateBackward( link );
+    return;
+  }
+  zVec6DSubDRC( &ap->b, &ap->w );
+  if( !rkLinkParent(link) ) return;
+  /* add ABI and bias acceleration to parent prp */
+  rkJointXformMat6D( rkLinkAdjFrame(link), &ap->i, &tmpm );
+  zMat6DAddDRC( &rkLinkABIPrp(rkLinkParent(link))->i, &tmpm );
+  zVec6DCopy( &ap->c, &tmpv );
+  rkJointIncAcc( rkLinkJoint(link), &tmpv );
+  zMulMat6DVec6D( &ap->i, &tmpv, &icb );
+  zVec6DAddDRC( &icb, &ap->b );
+  zMulMat3DVec6D( rkLinkAdjAtt(link), &icb, &tmpv );
+  zVec6DAngShiftDRC( &tmpv, rkLinkAdjPos(link) );
+  zVec6DAddDRC( &rkLinkABIPrp(rkLinkParent(link))->b, &tmpv );
+}
+
+/* forward computation to update acceleration and wrench of a link in hybrid dynamics. */
+static void _rkLinkHDUpdateForward(rkLink *link, zVec6D *pa)
+{
+  rkABIPrp *ap;
+
+  ap = rkLinkABIPrp(link);
+  if( !ap->acc_spec ){
+    _rkLinkABIUpdateForward( link, pa );
+    rkJointUpdateWrench( rkLinkJoint(link), &ap->i, &ap->b, rkLinkAcc(link) );
+  } else{
+    zVec6DLinShift( pa, rkLinkAdjPos(link), rkLinkAcc(link) );
+    zMulMat3DTVec6DDRC( rkLinkAdjAtt(link), rkLinkAcc(link) );
+    zVec6DAddDRC( rkLinkAcc(link), &ap->c );
+    rkJointIncAcc( rkLinkJoint(link), rkLinkAcc(link) );
+    rkJointUpdateWrench( rkLinkJoint(link), &ap->i, &ap->b, rkLinkAcc(link) );
+    rkJointCalcTrq( rkLinkJoint(link), rkJointWrench(rkLinkJoint(link)) );
+  }
+  if( rkLinkSibl(link) )
+    _rkLinkHDUpdateForward( rkLinkSibl(link), pa );
+  if( rkLinkChild(link) )
+    _rkLinkHDUpdateForward( rkLinkChild(link), rkLinkAcc(link) );
+}
+
+/* update ABI, acceleration, wrench and torque of a kinematic chain in hybrid dynamics. */
+void rkChainHDUpdate(rkChain *chain)
+{
+  if( rkChainJointSize(chain) == 0 ){
+    _rkChainZeroLinkRate( chain );
+    return;
+  }
+  rkChainABIUpdateInit( chain );
+  _rkLinkHDUpdateBackward( rkChainRoot(chain) );
+  _rkLinkHDUpdateForward( rkChainRoot(chain), ZVEC6DZERO );
+}
+
+/* motor input torques of a joint in hybrid dynamics. */
+static void _rkLinkHDMotorInputTrq(rkLink *link, double *trq)
+{
+  register int i;
+  double u[6], t[6], d[6];
+
+  for( i=0; i<6; i++ ) u[i] = t[i] = d[i] = 0;
+  rkJointMotorInputTrq( rkLinkJoint(link), u );
+  if( !rkLinkABIPrp(link)->acc_spec ){
+    memcpy( trq, u, sizeof(double)*rkLinkJointSize(link) );
+    return;
+  }
+  /* required input torque = (current input) + (required torque) - (current driving torque) */
+  rkJointGetTrq( rkLinkJoint(link), t );
+  rkJointMotorDrivingTrq( rkLinkJoint(link), d );
+  for( i=0; i<rkLinkJointSize(link); i++ )
+    trq[i] = u[i] + t[i] - d[i];
+}
+
+/* hybrid dynamics of a kinematic chain. */
+zVec rkChainHD(rkChain *chain, zVec dis, zVec vel, zVec acc, zVec trq)
+{
+  register int i;
+
+  if( rkChainJointSize(chain) == 0 ){
+    _rkChainZeroLinkRate( chain );
+    return NULL;
+  }
+  rkChainSetJointDisAll( chain, dis );
+  rkChainSetJointVelAll( chain, vel );
+  rkChainSetJointAccAll( chain, acc );
+  rkChainUpdateFK( chain );
+  rkChainUpdateVel( chain );
+  rkChainHDUpdate( chain );
+  rkChainGetJointAccAll( chain, acc );
+  if( trq )
+    for( i=0; i<rkChainLinkNum(chain); i++ )
+      if( rkChainLinkOffset(chain,i) >= 0 )
+        _rkLinkHDMotorInputTrq( rkChainLink(chain,i), &zVecElemNC(trq,rkChainLinkOffset(chain,i)) );
+  return acc;
+}
+
+/******************************************************************************/
+/* ABI method with frozen articulated inertias
+ *
+ * the articulated inertias and the axis inertias of the last regular
+ * update are reused, and only the velocity-dependent terms and ABbias
+ * are recomputed.
+ */
+
+/* backward computation to update ABbias of a link with frozen ABI. */
+static void _rkLinkABIUpdateBackwardFrozen(rkLink *link)
+{
+  if( rkLinkSibl(link) )
+    _rkLinkABIUpdateBackwardFrozen( rkLinkSibl(link) );
+  if( rkLinkChild(link) )
+    _rkLinkABIUpdateBackwardFrozen( rkLinkChild(link) );
+  zVec6DSubDRC( &rkLinkABIPrp(link)->b, &rkLinkABIPrp(link)->w );
+  rkJointABIDrivingTorque( rkLinkJoint(link) );
+  if( rkLinkParent(link) )
+    _rkLinkABIAddBias( link );
+}
+
+/* update ABbias and acceleration of a kinematic chain with frozen ABI. */
+static bool _rkChainABIUpdateFrozen(rkChain *chain)
+{
+  register int i;
+
+  if( rkChainJointSize(chain) == 0 ){
+    _rkChainZeroLinkRate( chain );
+    return false;
+  }
+  for( i=0; i<rkChainLinkNum(chain); i++ )
+    _rkLinkABIUpdateInitBias( rkChainLink(chain,i), rkChainLinkParent(chain,i) ?
+      rkLinkVel(rkChainLinkParent(chain,i)) : ZVEC6DZERO );
+  _rkLinkABIUpdateBackwardFrozen( rkChainRoot(chain) );
+  return true;
+}
+
+/* update ABbias and acceleration of a kinematic chain with frozen ABI. */
+void rkChainABIUpdateFrozen(rkChain *chain)
+{
+  if( _rkChainABIUpdateFrozen( chain ) )
+    rkChainABIUpdateForward( chain );
+}
+
+/* update ABbias, acceleration and wrench of a kinematic chain with frozen ABI. */
+void rkChainABIUpdateFrozenGetWrench(rkChain *chain)
+{
+  if( _rkChainABIUpdateFrozen( chain ) )
+    rkChainABIUpdateForwardGetWrench( chain );
+}
+
+/* create a refresh policy of frozen ABI. */
+rkABIFreeze *rkABIFreezeCreate(rkABIFreeze *fz, rkChain *chain, int interval, double tol)
+{
+  fz->interval = interval;
+  fz->tol = tol;
+  fz->count = fz->refresh = 0;
+  fz->err = fz->acc_err = 0;
+  fz->_dis = zVecAlloc( rkChainJointSize(chain) );
+  fz->_acc = zVecAlloc( rkChainJointSize(chain) );
+  if( !fz->_dis || !fz->_acc ){
+    rkABIFreezeDestroy( fz );
+    return NULL;
+  }
+  return fz;
+}
+
+/* destroy a refresh policy of frozen ABI. */
+void rkABIFreezeDestroy(rkABIFreeze *fz)
+{
+  zVecFreeAO( 2, fz->_dis, fz->_acc );
+  fz->_dis = fz->_acc = NULL;
+}
+
+/* compute acceleration of a kinematic chain based on ABI method with frozen ABI. */
+zVec rkChainABIFreeze(rkChain *chain, rkABIFreeze *fz, zVec dis, zVec vel, zVec acc)
+{
+  if( rkChainJointSize(chain) == 0 ){
+    _rkChainZeroLinkRate( chain );
+    return NULL;
+  }
+  rkChainSetJointDisAll( chain, dis );
+  rkChainSetJointVelAll( chain, vel );
+  rkChainUpdateFK( chain );
+  rkChainUpdateVel( chain );
+  if( fz->refresh > 0 )
+    fz->err = zVecDist( dis, fz->_dis );
+  if( fz->refresh == 0 || fz->count >= fz->interval || fz->err > fz->tol ){
+    if( fz->refresh > 0 ){ /* error monitor */
+      rkChainABIUpdateFrozenGetWrench( chain );
+      rkChainGetJointAccAll( chain, fz->_acc );
+    }
+    rkChainABIUpdateGetWrench( chain );
+    rkChainGetJointAccAll( chain, acc );
+    if( fz->refresh > 0 )
+      fz->acc_err = zVecDist( acc, fz->_acc );
+    zVecCopyNC( dis, fz->_dis );
+    fz->err = 0;
+    fz->count = 0;
+    fz->refresh++;
+  } else{
+    rkChainABIUpdateFrozenGetWrench( chain );
+    rkChainGetJointAccAll( chain, acc );
+    fz->count++;
+  }
+  return acc;
+}
@@ -0,0 +1,556 @@
+/* RoKi - Robot Kinetics library
+ * Copyright (C) 1998 Tomomichi Sugihara (Zhidao)
+ *
+ * rk_abi_ens - ensemble of articulated body inertia method
+ */
+
+#include <roki/rk_abi_ens.h>
+
+/* ********************************************************** */
+/* CLASS: rkABIEns
+ * ensemble of ABI method for multiple instances of a kinematic chain
+ * ********************************************************** */
+
+/* model data of a link */
+#define RK_ABIENS_MODEL_R0   0 /* original attitude (row-major) */
+#define RK_ABIENS_MODEL_P0   9 /* original position */
+#define RK_ABIENS_MODEL_M   12 /* mass */
+#define RK_ABIENS_MODEL_COM 13 /* center of mass */
+#define RK_ABIENS_MODEL_IO  16 /* inertia tensor about the origin (row-major) */
+#define RK_ABIENS_MODEL_SIZE 25
+
+/* workspace of a link; each component is an array over instances */
+#define RK_ABIENS_WS_R    0 /* attitude with respect to the parent (row-major) */
+#define RK_ABIENS_WS_P    9 /* position with respect to the parent */
+#define RK_ABIENS_WS_W   12 /* angular velocity */
+#define RK_ABIENS_WS_V   15 /* linear velocity */
+#define RK_ABIENS_WS_C   18 /* bias acceleration */
+#define RK_ABIENS_WS_I   24 /* ABI (row-major, linear-angular order) */
+#define RK_ABIENS_WS_B   60 /* ABbias */
+#define RK_ABIENS_WS_A   66 /* acceleration */
+#define RK_ABIENS_WS_U   72 /* joint torque subtracted by bias */
+#define RK_ABIENS_WS_SIZE 73
+
+#define _rkABIEnsWS(e,l)    ( (e)->_ws + (l)*RK_ABIENS_WS_SIZE*(e)->num )
+#define _rkABIEnsModel(e,l) ( (e)->_model + (l)*RK_ABIENS_MODEL_SIZE )
+
+/* temporary arrays over instances */
+#define RK_ABIENS_TMP_IA    0 /* ABI projected along the joint axis */
+#define RK_ABIENS_TMP_PA   36 /* ABbias projected along the joint axis */
+#define RK_ABIENS_TMP_V0   42 /* 3D vectors */
+#define RK_ABIENS_TMP_V1   45
+#define RK_ABIENS_TMP_V2   48
+#define RK_ABIENS_TMP_V3   51
+#define RK_ABIENS_TMP_M0   54 /* 3x3 matrices */
+#define RK_ABIENS_TMP_M1   63
+#define RK_ABIENS_TMP_M2   72
+#define RK_ABIENS_TMP_M3   81
+#define RK_ABIENS_TMP_M4   90
+#define RK_ABIENS_TMP_M5   99
+#define RK_ABIENS_TMP_M6  108
+#define RK_ABIENS_TMP_S   117 /* scalars */
+#define RK_ABIENS_TMP_SIZE 119
+
+/* The following operations work on arrays over instances, where the
+ * i-th component of a vector v and the (i,j)-component of a matrix m
+ * with a row stride s of the n-th instance are v[i*num+n] and
+ * m[(i*s+j)*num+n], respectively. Instances are on the innermost loops.
+ */
+
+/* c = a x b */
+static void _rkABIEnsCross(int num, double *a, double *b, double *c)
+{
+  register int n;
+
+  for( n=0; n<num; n++ ){
+    c[n]       = a[num+n]*b[2*num+n] - a[2*num+n]*b[num+n];
+    c[num+n]   = a[2*num+n]*b[n] - a[n]*b[2*num+n];
+    c[2*num+n] = a[n]*b[num+n] - a[num+n]*b[n];
+  }
+}
+
+/* c = a x b for a vector b common to all instances */
+static void _rkABIEnsCrossConst(int num, double *a, double b[], double *c)
+{
+  register int n;
+
+  for( n=0; n<num; n++ ){
+    c[n]       = a[num+n]*b[2] - a[2*num+n]*b[1];
+    c[num+n]   = a[2*num+n]*b[0] - a[n]*b[2];
+    c[2*num+n] = a[n]*b[1] - a[num+n]*b[0];
+  }
+}
+
+/* c = m a for a row-major matrix m common to all instances */
+static void _rkABIEnsMulConst(int num, double m[], double *a, double *c)
+{
+  register int i, n;
+
+  for( i=0; i<3; i++ )
+    for( n=0; n<num; n++ )
+      c[i*num+n] = m[i*3]*a[n] + m[i*3+1]*a[num+n] + m[i*3+2]*a[2*num+n];
+}
+
+/* c = r a */
+static void _rkABIEnsMulVec(int num, double *r, double *a, double *c)
+{
+  register int i, n;
+
+  for( i=0; i<3; i++ )
+    for( n=0; n<num; n++ )
+      c[i*num+n] = r[i*3*num+n]*a[n] + r[(i*3+1)*num+n]*a[num+n] + r[(i*3+2)*num+n]*a[2*num+n];
+}
+
+/* c = r^T a */
+static void _rkABIEnsMulTVec(int num, double *r, double *a, double *c)
+{
+  register int i, n;
+
+  for( i=0; i<3; i++ )
+    for( n=0; n<num; n++ )
+      c[i*num+n] = r[i*num+n]*a[n] + r[(3+i)*num+n]*a[num+n] + r[(6+i)*num+n]*a[2*num+n];
+}
+
+/* c = a b, where a and b have row strides as and bs, respectively */
+static void _rkABIEnsMul3(int num, double *a, int as, double *b, int bs, double *c)
+{
+  register int i, j, n;
+
+  for( i=0; i<3; i++ )
+    for( j=0; j<3; j++ )
+      for( n=0; n<num; n++ )
+        c[(i*3+j)*num+n] = a[i*as*num+n]*b[j*num+n] + a[(i*as+1)*num+n]*b[(bs+j)*num+n] + a[(i*as+2)*num+n]*b[(2*bs+j)*num+n];
+}
+
+/* c = a b^T */
+static void _rkABIEnsMul3T(int num, double *a, double *b, double *c)
+{
+  register int i, j, n;
+
+  for( i=0; i<3; i++ )
+    for( j=0; j<3; j++ )
+      for( n=0; n<num; n++ )
+        c[(i*3+j)*num+n] = a[i*3*num+n]*b[j*3*num+n] + a[(i*3+1)*num+n]*b[(j*3+1)*num+n] + a[(i*3+2)*num+n]*b[(j*3+2)*num+n];
+}
+
+/* c = a^T b */
+static void _rkABIEnsMulT3(int num, double *a, double *b, double *c)
+{
+  register int i, j, n;
+
+  for( i=0; i<3; i++ )
+    for( j=0; j<3; j++ )
+      for( n=0; n<num; n++ )
+        c[(i*3+j)*num+n] = a[i*num+n]*b[j*num+n] + a[(3+i)*num+n]*b[(3+j)*num+n] + a[(6+i)*num+n]*b[(6+j)*num+n];
+}
+
+/* b = r a r^T, where a has a row stride s */
+static void _rkABIEnsRot3(int num, double *r, double *a, int s, double *tmp, double *b)
+{
+  _rkABIEnsMul3( num, r, 3, a, s, tmp );
+  _rkABIEnsMul3T( num, tmp, r, b );
+}
+
+/* skew-symmetric matrix of a vector */
+static void _rkABIEnsSkew(int num, double *v, double *m)
+{
+  register int n;
+
+  for( n=0; n<num; n++ ){
+    m[n]       = 0;            m[num+n]   =-v[2*num+n]; m[2*num+n] = v[num+n];
+    m[3*num+n] = v[2*num+n];   m[4*num+n] = 0;          m[5*num+n] =-v[n];
+    m[6*num+n] =-v[num+n];     m[7*num+n] = v[n];       m[8*num+n] = 0;
+  }
+}
+
+/* skew-symmetric matrix of a vector common to all instances */
+static void _rkABIEnsSkewConst(double v[], double m[])
+{
+  m[0] = 0;     m[1] =-v[2]; m[2] = v[1];
+  m[3] = v[2];  m[4] = 0;    m[5] =-v[0];
+  m[6] =-v[1];  m[7] = v[0]; m[8] = 0;
+}
+
+/* list links in preorder */
+static void _rkABIEnsOrder(rkChain *chain, rkLink *link, int *order, int *n)
+{
+  rkLink *c;
+
+  order[(*n)++] = link - rkChainRoot(chain);
+  for( c=rkLinkChild(link); c; c=rkLinkSibl(c) )
+    _rkABIEnsOrder( chain, c, order, n );
+}
+
+/* set model data of a link */
+static void _rkABIEnsSetModel(rkLink *link, double *md)
+{
+  register int i, j;
+  double m;
+  zVec3D *c;
+
+  for( i=0; i<3; i++ ){
+    for( j=0; j<3; j++ )
+      md[RK_ABIENS_MODEL_R0+i*3+j] = rkLinkOrgAtt(link)->e[j][i];
+    md[RK_ABIENS_MODEL_P0+i] = rkLinkOrgPos(link)->e[i];
+    md[RK_ABIENS_MODEL_COM+i] = rkLinkCOM(link)->e[i];
+  }
+  md[RK_ABIENS_MODEL_M] = m = rkLinkMass(link);
+  c = rkLinkCOM(link);
+  /* parallel axis theorem */
+  for( i=0; i<3; i++ )
+    for( j=0; j<3; j++ )
+      md[RK_ABIENS_MODEL_IO+i*3+j] = rkLinkInertia(link)->e[j][i]
+        + m * ( ( i == j ? zVec3DSqrNorm(c) : 0 ) - c->e[i]*c->e[j] );
+}
+
+/* check if a joint is driven only by the input torque. */
+static bool _rkABIEnsJointIsDriven(rkLink *link)
+{
+  rkJoint *joint;
+  rkMotor *motor;
+  double s, v, c;
+
+  joint = rkLinkJoint(link);
+  if( joint->com == &rk_joint_revol ){
+    s = ((rkJointRevolPrp *)joint->prp)->stiffness;
+    v = ((rkJointRevolPrp *)joint->prp)->viscosity;
+    c = ((rkJointRevolPrp *)joint->prp)->coulomb;
+  } else{
+    s = ((rkJointPrismPrp *)joint->prp)->stiffness;
+    v = ((rkJointPrismPrp *)joint->prp)->viscosity;
+    c = ((rkJointPrismPrp *)joint->prp)->coulomb;
+  }
+  if( !zIsTiny( s ) || !zIsTiny( v ) || !zIsTiny( c ) ){
+    ZRUNERROR( RK_ERR_ABIENS_PASSIVE, zName(link) );
+    return false;
+  }
+  motor = rkJointGetMotor( joint );
+  if( motor->com != &rk_motor_none && motor->com != &rk_motor_trq ){
+    ZRUNERROR( RK_ERR_ABIENS_INVMOTOR, zName(link), rkMotorTypeStr(motor) );
+    return false;
+  }
+  return true;
+}
+
+/* create an ensemble of ABI method. */
+rkABIEns *rkABIEnsCreate(rkABIEns *ens, rkChain *chain, int num)
+{
+  register int i;
+  int n = 0, nj;
+  rkLink *link;
+
+  ens->chain = chain;
+  ens->num = num;
+  nj = zMax( rkChainJointSize(chain), 1 );
+  ens->dis = zAlloc( double, nj*num );
+  ens->vel = zAlloc( double, nj*num );
+  ens->trq = zAlloc( double, nj*num );
+  ens->acc = zAlloc( double, nj*num );
+  ens->_order = zAlloc( int, rkChainLinkNum(chain) );
+  ens->_parent = zAlloc( int, rkChainLinkNum(chain) );
+  ens->_axis = zAlloc( int, rkChainLinkNum(chain) );
+  ens->_model = zAlloc( double, rkChainLinkNum(chain)*RK_ABIENS_MODEL_SIZE );
+  ens->_ws = zAlloc( double, rkChainLinkNum(chain)*RK_ABIENS_WS_SIZE*num );
+  ens->_tmp = zAlloc( double, RK_ABIENS_TMP_SIZE*num );
+  if( !ens->dis || !ens->vel || !ens->trq || !ens->acc ||
+      !ens->_order || !ens->_parent || !ens->_axis || !ens->_model || !ens->_ws || !ens->_tmp ){
+    ZALLOCERROR();
+    goto FAILURE;
+  }
+  for( i=0; i<rkChainLinkNum(chain); i++ ){
+    link = rkChainLink(chain,i);
+    if( rkLinkJoint(link)->com == &rk_joint_revol )
+      ens->_axis[i] = zZA;
+    else if( rkLinkJoint(link)->com == &rk_joint_prism )
+      ens->_axis[i] = zZ;
+    else if( rkLinkJoint(link)->com == &rk_joint_fixed )
+      ens->_axis[i] = -1;
+    else{
+      ZRUNERROR( RK_ERR_ABIENS_INVJOINT, zName(link), rkLinkJointTypeStr(link) );
+      goto FAILURE;
+    }
+    if( ens->_axis[i] >= 0 && !_rkABIEnsJointIsDriven( link ) ) goto FAILURE;
+    ens->_parent[i] = rkLinkParent(link) ? rkLinkParent(link) - rkChainRoot(chain) : -1;
+    _rkABIEnsSetModel( link, _rkABIEnsModel(ens,i) );
+  }
+  _rkABIEnsOrder( chain, rkChainRoot(chain), ens->_order, &n );
+  return ens;
+
+ FAILURE:
+  rkABIEnsDestroy( ens );
+  return NULL;
+}
+
+/* destroy an ensemble of ABI method. */
+void rkABIEnsDestroy(rkABIEns *ens)
+{
+  zFree( ens->dis );
+  zFree( ens->vel );
+  zFree( ens->trq );
+  zFree( ens->acc );
+  zFree( ens->_order );
+  zFree( ens->_parent );
+  zFree( ens->_axis );
+  zFree( ens->_model );
+  zFree( ens->_ws );
+  zFree( ens->_tmp );
+  ens->chain = NULL;
+  ens->num = 0;
+}
+
+/* set state of an instance. */
+void rkABIEnsSetState(rkABIEns *ens, int n, zVec dis, zVec vel, zVec trq)
+{
+  register int i;
+
+  for( i=0; i<rkChainJointSize(ens->chain); i++ ){
+    rkABIEnsDis(ens,i,n) = zVecElemNC(dis,i);
+    rkABIEnsVel(ens,i,n) = zVecElemNC(vel,i);
+    rkABIEnsTrq(ens,i,n) = trq ? zVecElemNC(trq,i) : 0;
+  }
+}
+
+/* get acceleration of an instance. */
+zVec rkABIEnsGetAcc(rkABIEns *ens, int n, zVec acc)
+{
+  register int i;
+
+  for( i=0; i<rkChainJointSize(ens->chain); i++ )
+    zVecElemNC(acc,i) = rkABIEnsAcc(ens,i,n);
+  return acc;
+}
+
+/* initialize velocity, bias acceleration, ABI and ABbias of a link. */
+static void _rkABIEnsUpdateInit(rkABIEns *ens, int l)
+{
+  double *md, *ws, *pws, *q = NULL, *dq = NULL, *cq, *sq;
+  double *r, *p, *w, *v, *c, *b, *wp, *vp, *t0, *t1;
+  int num, k;
+  register int i, j, n;
+  double m, x[9];
+
+  num = ens->num;
+  md = _rkABIEnsModel(ens,l);
+  ws = _rkABIEnsWS(ens,l);
+  k = ens->_axis[l];
+  if( k >= 0 ){
+    q  = ens->dis + rkChainLinkOffset(ens->chain,l)*num;
+    dq = ens->vel + rkChainLinkOffset(ens->chain,l)*num;
+  }
+  r = ws + RK_ABIENS_WS_R*num;
+  p = ws + RK_ABIENS_WS_P*num;
+  w = ws + RK_ABIENS_WS_W*num;
+  v = ws + RK_ABIENS_WS_V*num;
+  c = ws + RK_ABIENS_WS_C*num;
+  b = ws + RK_ABIENS_WS_B*num;
+  t0 = ens->_tmp + RK_ABIENS_TMP_V0*num;
+  t1 = ens->_tmp + RK_ABIENS_TMP_V1*num;
+  if( ens->_parent[l] >= 0 ){
+    pws = _rkABIEnsWS(ens,ens->_parent[l]);
+    wp = pws + RK_ABIENS_WS_W*num;
+    vp = pws + RK_ABIENS_WS_V*num;
+  } else{ /* the base is at rest */
+    wp = ens->_tmp + RK_ABIENS_TMP_V2*num;
+    vp = ens->_tmp + RK_ABIENS_TMP_V3*num;
+    memset( wp, 0, sizeof(double)*6*num );
+  }
+  /* frame with respect to the parent */
+  if( k == zZA ){
+    cq = ens->_tmp + RK_ABIENS_TMP_S*num;
+    sq = cq + num;
+    for( n=0; n<num; n++ ){
+      cq[n] = cos( q[n] );
+      sq[n] = sin( q[n] );
+    }
+    for( i=0; i<3; i++ )
+      for( n=0; n<num; n++ ){
+        r[i*3*num+n]     = cq[n]*md[RK_ABIENS_MODEL_R0+i*3] + sq[n]*md[RK_ABIENS_MODEL_R0+i*3+1];
+        r[(i*3+1)*num+n] =-sq[n]*md[RK_ABIENS_MODEL_R0+i*3] + cq[n]*md[RK_ABIENS_MODEL_R0+i*3+1];
+        r[(i*3+2)*num+n] = md[RK_ABIENS_MODEL_R0+i*3+2];
+      }
+  } else
+    for( i=0; i<9; i++ )
+      for( n=0; n<num; n++ ) r[i*num+n] = md[RK_ABIENS_MODEL_R0+i];
+  for( i=0; i<3; i++ )
+    for( n=0; n<num; n++ ) p[i*num+n] = md[RK_ABIENS_MODEL_P0+i];
+  if( k == zZ )
+    for( i=0; i<3; i++ )
+      for( n=0; n<num; n++ ) p[i*num+n] += q[n] * md[RK_ABIENS_MODEL_R0+i*3+2];
+  /* velocity */
+  _rkABIEnsCross( num, wp, p, t0 );
+  for( i=0; i<3*num; i++ ) t0[i] += vp[i];
+  _rkABIEnsMulTVec( num, r, wp, w );
+  _rkABIEnsMulTVec( num, r, t0, v );
+  /* bias acceleration */
+  _rkABIEnsCross( num, wp, p, t0 );
+  _rkABIEnsCross( num, wp, t0, t1 );
+  _rkABIEnsMulTVec( num, r, t1, c );
+  memset( c+3*num, 0, sizeof(double)*3*num );
+  if( k == zZA ){
+    for( n=0; n<num; n++ ){
+      c[zXA*num+n] = w[zY*num+n]*dq[n];
+      c[zYA*num+n] =-w[zX*num+n]*dq[n];
+      w[zZ*num+n] += dq[n];
+    }
+  } else if( k == zZ ){
+    for( n=0; n<num; n++ ){
+      c[zX*num+n] += 2*w[zY*num+n]*dq[n];
+      c[zY*num+n] -= 2*w[zX*num+n]*dq[n];
+      v[zZ*num+n] += dq[n];
+    }
+  }
+  /* ABI initialized by the mass matrix */
+  m = md[RK_ABIENS_MODEL_M];
+  _rkABIEnsSkewConst( &md[RK_ABIENS_MODEL_COM], x );
+  for( i=0; i<3; i++ )
+    for( j=0; j<3; j++ )
+      for( n=0; n<num; n++ ){
+        ws[(RK_ABIENS_WS_I+i*6+j)*num+n] = i == j ? m : 0;
+        ws[(RK_ABIENS_WS_I+i*6+j+3)*num+n] =-m * x[i*3+j];
+        ws[(RK_ABIENS_WS_I+(i+3)*6+j)*num+n] = m * x[i*3+j];
+        ws[(RK_ABIENS_WS_I+(i+3)*6+j+3)*num+n] = md[RK_ABIENS_MODEL_IO+i*3+j];
+      }
+  /* ABbias initialized by the bias force */
+  _rkABIEnsCrossConst( num, w, &md[RK_ABIENS_MODEL_COM], t0 );
+  _rkABIEnsCross( num, w, t0, b );
+  for( i=0; i<3*num; i++ ) b[i] *= m;
+  _rkABIEnsMulConst( num, &md[RK_ABIENS_MODEL_IO], w, t0 );
+  _rkABIEnsCross( num, w, t0, b+3*num );
+}
+
+/* backward computation to update ABI of a link and add it to the parent. */
+static void _rkABIEnsUpdateBackward(rkABIEns *ens, int l)
+{
+  double *ws, *pws, *ia, *pa, *u, *d, *ud, *trq, *c, *r, *p;
+  double *f, *mm, *t, *ar, *br, *cr, *x, *b, *t0, *t1;
+  int num, k;
+  register int i, j, n;
+
+  num = ens->num;
+  ws = _rkABIEnsWS(ens,l);
+  k = ens->_axis[l];
+  ia = ens->_tmp + RK_ABIENS_TMP_IA*num;
+  pa = ens->_tmp + RK_ABIENS_TMP_PA*num;
+  if( k >= 0 ){ /* projection along the joint axis */
+    trq = ens->trq + rkChainLinkOffset(ens->chain,l)*num;
+    ud = ws + RK_ABIENS_WS_U*num;
+    d = ens->_tmp + RK_ABIENS_TMP_S*num; /* reciprocal of the diagonal element */
+    u = ws + (RK_ABIENS_WS_I+k)*num; /* k-th column with a row stride 6 */
+    for( n=0; n<num; n++ ){
+      ud[n] = trq[n] - ws[(RK_ABIENS_WS_B+k)*num+n];
+      d[n] = 1.0 / ws[(RK_ABIENS_WS_I+k*6+k)*num+n];
+    }
+    for( i=0; i<6; i++ )
+      for( j=0; j<6; j++ )
+        for( n=0; n<num; n++ )
+          ia[(i*6+j)*num+n] = ws[(RK_ABIENS_WS_I+i*6+j)*num+n] - u[i*6*num+n]*u[j*6*num+n]*d[n];
+    for( i=0; i<6; i++ )
+      for( n=0; n<num; n++ )
+        pa[i*num+n] = ws[(RK_ABIENS_WS_B+i)*num+n] + u[i*6*num+n]*ud[n]*d[n];
+  } else{
+    memcpy( ia, ws+RK_ABIENS_WS_I*num, sizeof(double)*36*num );
+    memcpy( pa, ws+RK_ABIENS_WS_B*num, sizeof(double)*6*num );
+  }
+  c = ws + RK_ABIENS_WS_C*num;
+  for( i=0; i<6; i++ )
+    for( j=0; j<6; j++ )
+      for( n=0; n<num; n++ )
+        pa[i*num+n] += ia[(i*6+j)*num+n]*c[j*num+n];
+  if( ens->_parent[l] < 0 ) return;
+  pws = _rkABIEnsWS(ens,ens->_parent[l]);
+  r = ws + RK_ABIENS_WS_R*num;
+  p = ws + RK_ABIENS_WS_P*num;
+  /* transform to the parent frame */
+  f  = ens->_tmp + RK_ABIENS_TMP_V0*num;
+  mm = ens->_tmp + RK_ABIENS_TMP_V1*num;
+  t  = ens->_tmp + RK_ABIENS_TMP_V2*num;
+  _rkABIEnsMulVec( num, r, pa, f );
+  _rkABIEnsMulVec( num, r, pa+3*num, mm );
+  _rkABIEnsCross( num, p, f, t );
+  for( i=0; i<3*num; i++ ){
+    pws[RK_ABIENS_WS_B*num+i] += f[i];
+    pws[(RK_ABIENS_WS_B+3)*num+i] += mm[i] + t[i];
+  }
+  ar = ens->_tmp + RK_ABIENS_TMP_M0*num;
+  br = ens->_tmp + RK_ABIENS_TMP_M1*num;
+  cr = ens->_tmp + RK_ABIENS_TMP_M2*num;
+  x  = ens->_tmp + RK_ABIENS_TMP_M3*num;
+  b  = ens->_tmp + RK_ABIENS_TMP_M4*num;
+  t0 = ens->_tmp + RK_ABIENS_TMP_M5*num;
+  t1 = ens->_tmp + RK_ABIENS_TMP_M6*num;
+  _rkABIEnsRot3( num, r, ia, 6, t0, ar );
+  _rkABIEnsRot3( num, r, ia+3*num, 6, t0, br );
+  _rkABIEnsRot3( num, r, ia+21*num, 6, t0, cr );
+  _rkABIEnsSkew( num, p, x );
+  /* B' - A'X */
+  _rkABIEnsMul3( num, ar, 3, x, 3, t0 );
+  for( i=0; i<9*num; i++ ) b[i] = br[i] - t0[i];
+  /* C' - B'^T X + X B' - X A' X */
+  _rkABIEnsMulT3( num, br, x, t0 );
+  _rkABIEnsMul3( num, x, 3, br, 3, t1 );
+  for( i=0; i<9*num; i++ ) cr[i] += t1[i] - t0[i];
+  _rkABIEnsMul3( num, x, 3, ar, 3, t0 );
+  _rkABIEnsMul3( num, t0, 3, x, 3, t1 );
+  for( i=0; i<9*num; i++ ) cr[i] -= t1[i];
+  for( i=0; i<3; i++ )
+    for( j=0; j<3; j++ )
+      for( n=0; n<num; n++ ){
+        pws[(RK_ABIENS_WS_I+i*6+j)*num+n] += ar[(i*3+j)*num+n];
+        pws[(RK_ABIENS_WS_I+i*6+j+3)*num+n] += b[(i*3+j)*num+n];
+        pws[(RK_ABIENS_WS_I+(i+3)*6+j)*num+n] += b[(j*3+i)*num+n];
+        pws[(RK_ABIENS_WS_I+(i+3)*6+j+3)*num+n] += cr[(i*3+j)*num+n];
+      }
+}
+
+/* forward computation to update acceleration of a link. */
+static void _rkABIEnsUpdateForward(rkABIEns *ens, int l)
+{
+  double *ws, *ap, *r, *p, *c, *a, *t, *u, *acc;
+  int num, k;
+  register int i, n;
+
+  num = ens->num;
+  ws = _rkABIEnsWS(ens,l);
+  k = ens->_axis[l];
+  if( ens->_parent[l] >= 0 )
+    ap = _rkABIEnsWS(ens,ens->_parent[l]) + RK_ABIENS_WS_A*num;
+  else{ /* the gravity is given as the acceleration of the base */
+    ap = ens->_tmp + RK_ABIENS_TMP_V0*num;
+    memset( ap, 0, sizeof(double)*6*num );
+    for( n=0; n<num; n++ ) ap[zZ*num+n] = RK_G;
+  }
+  r = ws + RK_ABIENS_WS_R*num;
+  p = ws + RK_ABIENS_WS_P*num;
+  c = ws + RK_ABIENS_WS_C*num;
+  a = ws + RK_ABIENS_WS_A*num;
+  t = ens->_tmp + RK_ABIENS_TMP_V2*num;
+  _rkABIEnsCross( num, ap+3*num, p, t );
+  for( i=0; i<3*num; i++ ) t[i] += ap[i];
+  _rkABIEnsMulTVec( num, r, t, a );
+  _rkABIEnsMulTVec( num, r, ap+3*num, a+3*num );
+  for( i=0; i<6*num; i++ ) a[i] += c[i];
+  if( k < 0 ) return;
+  u = ws + RK_ABIENS_WS_U*num;
+  acc = ens->acc + rkChainLinkOffset(ens->chain,l)*num;
+  for( n=0; n<num; n++ ) acc[n] = u[n];
+  for( i=0; i<6; i++ )
+    for( n=0; n<num; n++ )
+      acc[n] -= ws[(RK_ABIENS_WS_I+k*6+i)*num+n] * a[i*num+n];
+  for( n=0; n<num; n++ ){
+    acc[n] /= ws[(RK_ABIENS_WS_I+k*6+k)*num+n];
+    a[k*num+n] += acc[n];
+  }
+}
+
+/* ABI method for all instances. */
+void rkABIEnsUpdate(rkABIEns *ens)
+{
+  register int i;
+
+  for( i=0; i<rkChainLinkNum(ens->chain); i++ )
+    _rkABIEnsUpdateInit( ens, ens->_order[i] );
+  for( i=rkChainLinkNum(ens->chain)-1; i>=0; i-- )
+    _rkABIEnsUpdateBackward( ens, ens->_order[i] );
+  for( i=0; i<rkChainLinkNum(ens->chain); i++ )
+    _rkABIEnsUpdateForward( ens, ens->_order[i] );
+}
@@ -6,8 +6,207 @@
  * contributer: 2014-2015 Naoki Wakisaka
  */
 
+/* for POSIX threads */
+#include <unistd.h>
+
 #include <roki/rk_cd.h>
 
+#if defined(_POSIX_THREADS) && _POSIX_THREADS > 0
+#define __RK_CD_MT
+#include <pthread.h>
+#endif
+
+/* maximum number of threads */
+#define RK_CD_MT_MAX 32
+
+/* maximum number of primitives in a leaf of a bounding volume hierarchy */
+#define RK_CD_BVH_LEAF_SIZE 4
+/* size of the stack to traverse a bounding volume hierarchy */
+#define RK_CD_BVH_STACK_SIZE 128
+
+/* initialize a bounding volume hierarchy. */
+static void _rkCDBVHInit(rkCDBVH *bvh)
+{
+  bvh->nodenum = 0;
+  bvh->node = NULL;
+  bvh->idx = NULL;
+}
+
+/* destroy a bounding volume hierarchy. */
+static void _rkCDBVHDestroy(rkCDBVH *bvh)
+{
+  zFree( bvh->node );
+  zFree( bvh->idx );
+  _rkCDBVHInit( bvh );
+}
+
+/* merge an axis-aligned box to another. */
+static void _rkCDBoxMerge(zAABox3D *box, zAABox3D *src)
+{
+  register int i;
+
+  for( i=zX; i<=zZ; i++ ){
+    if( src->min.e[i] < box->min.e[i] ) box->min.e[i] = src->min.e[i];
+    if( src->max.e[i] > box->max.e[i] ) box->max.e[i] = src->max.e[i];
+  }
+}
+
+/* squared distance from a point to an axis-aligned box. */
+static double _rkCDBoxSqrDist(zAABox3D *box, zVec3D *p)
+{
+  double d, sd = 0;
+  register int i;
+
+  for( i=zX; i<=zZ; i++ ){
+    if( ( d = box->min.e[i] - p->e[i] ) > 0 ) sd += d*d;
+    else
+    if( ( d = p->e[i] - box->max.e[i] ) > 0 ) sd += d*d;
+  }
+  return sd;
+}
+
+/* axis-aligned box in a frame which bounds an axis-aligned box in the world frame. */
+static void _rkCDBoxXformInv(zAABox3D *box, zFrame3D *f, zAABox3D *lbox)
+{
+  zVec3D c, lc;
+  register int i, j;
+
+  for( i=0; i<8; i++ ){
+    for( j=zX; j<=zZ; j++ )
+      c.e[j] = ( i >> j ) & 1 ? box->max.e[j] : box->min.e[j];
+    zXform3DInv( f, &c, &lc );
+    if( i == 0 ){
+      zVec3DCopy( &lc, &lbox->min );
+      zVec3DCopy( &lc, &lbox->max );
+      continue;
+    }
+    for( j=zX; j<=zZ; j++ ){
+      if( lc.e[j] < lbox->min.e[j] ) lbox->min.e[j] = lc.e[j];
+      if( lc.e[j] > lbox->max.e[j] ) lbox->max.e[j] = lc.e[j];
+    }
+  }
+}
+
+/* check if a point is inside an axis-aligned box. */
+static bool _rkCDBoxPointIsInside(zAABox3D *box, zVec3D *p)
+{
+  return p->e[zX] >= box->min.e[zX] && p->e[zX] <= box->max.e[zX] &&
+         p->e[zY] >= box->min.e[zY] && p->e[zY] <= box->max.e[zY] &&
+         p->e[zZ] >= box->min.e[zZ] && p->e[zZ] <= box->max.e[zZ];
+}
+
+/* partially sort primitives so that the k-th one comes to its place along an axis. */
+static void _rkCDBVHSelect(int *idx, zAABox3D *pbox, int axis, int head, int tail, int k)
+{
+  double pivot;
+  register int i, j;
+
+#define __rk_cd_bvh_center(p) ( pbox[p].min.e[axis] + pbox[p].max.e[axis] )
+  while( tail - head > 1 ){
+    pivot = __rk_cd_bvh_center( idx[(head+tail)/2] );
+    for( i=head, j=tail-1; i<=j; ){
+      while( __rk_cd_bvh_center( idx[i] ) < pivot ) i++;
+      while( __rk_cd_bvh_center( idx[j] ) > pivot ) j--;
+      if( i <= j ){
+        zSwap( int, idx[i], idx[j] );
+        i++; j--;
+      }
+    }
+    if( k <= j ) tail = j + 1;
+    else if( k >= i ) head = i;
+    else break;
+  }
+#undef __rk_cd_bvh_center
+}
+
+/* build a node of a bounding volume hierarchy recursively. */
+static int _rkCDBVHBuildNode(rkCDBVH *bvh, zAABox3D *pbox, int head, int num)
+{
+  rkCDBVHNode *node;
+  zAABox3D cbox;
+  zVec3D c;
+  int id, axis, mid;
+  register int i;
+
+  node = &bvh->node[( id = bvh->nodenum++ )];
+  node->head = head;
+  node->num = num;
+  node->child[0] = node->child[1] = -1;
+  node->box = pbox[bvh->idx[head]];
+  for( i=1; i<num; i++ )
+    _rkCDBoxMerge( &node->box, &pbox[bvh->idx[head+i]] );
+  if( num <= RK_CD_BVH_LEAF_SIZE ) return id;
+  /* split at the median of centers along the axis where they spread the most */
+  for( i=0; i<num; i++ ){
+    zVec3DMid( &pbox[bvh->idx[head+i]].min, &pbox[bvh->idx[head+i]].max, &c );
+    if( i == 0 ){
+      zVec3DCopy( &c, &cbox.min );
+      zVec3DCopy( &c, &cbox.max );
+    } else{
+      cbox.min.e[zX] = zMin( cbox.min.e[zX], c.e[zX] ); cbox.max.e[zX] = zMax( cbox.max.e[zX], c.e[zX] );
+      cbox.min.e[zY] = zMin( cbox.min.e[zY], c.e[zY] ); cbox.max.e[zY] = zMax( cbox.max.e[zY], c.e[zY] );
+      cbox.min.e[zZ] = zMin( cbox.min.e[zZ], c.e[zZ] ); cbox.max.e[zZ] = zMax( cbox.max.e[zZ], c.e[zZ] );
+    }
+  }
+  zVec3DSub( &cbox.max, &cbox.min, &c );
+  axis = c.e[zX] >= c.e[zY] ? ( c.e[zX] >= c.e[zZ] ? zX : zZ ) : ( c.e[zY] >= c.e[zZ] ? zY : zZ );
+  mid = num / 2;
+  _rkCDBVHSelect( bvh->idx, pbox, axis, head, head+num, head+mid );
+  bvh->node[id].child[0] = _rkCDBVHBuildNode( bvh, pbox, head, mid );
+  bvh->node[id].child[1] = _rkCDBVHBuildNode( bvh, pbox, head+mid, num-mid );
+  return id;
+}
+
+/* build a bounding volume hierarchy from bounding boxes of primitives. */
+static bool _rkCDBVHBuild(rkCDBVH *bvh, zAABox3D *pbox, int num)
+{
+  register int i;
+
+  _rkCDBVHInit( bvh );
+  if( num <= 0 ) return true;
+  bvh->node = zAlloc( rkCDBVHNode, 2*num );
+  bvh->idx = zAlloc( int, num );
+  if( !bvh->node || !bvh->idx ){
+    ZALLOCERROR();
+    _rkCDBVHDestroy( bvh );
+    return false;
+  }
+  for( i=0; i<num; i++ ) bvh->idx[i] = i;
+  _rkCDBVHBuildNode( bvh, pbox, 0, num );
+  return true;
+}
+
+/* build bounding volume hierarchies of vertices and faces of a polyhedron. */
+static bool _rkCDBVHBuildPH(rkCDBVH *vbvh, rkCDBVH *fbvh, zPH3D *ph)
+{
+  zAABox3D *pbox;
+  register int i, j;
+  bool ret = false;
+
+  if( !( pbox = zAlloc( zAABox3D, zMax( zMax( zPH3DVertNum(ph), zPH3DFaceNum(ph) ), 1 ) ) ) ){
+    ZALLOCERROR();
+    return false;
+  }
+  for( i=0; i<zPH3DVertNum(ph); i++ ){
+    zVec3DCopy( zPH3DVert(ph,i), &pbox[i].min );
+    zVec3DCopy( zPH3DVert(ph,i), &pbox[i].max );
+  }
+  if( !_rkCDBVHBuild( vbvh, pbox, zPH3DVertNum(ph) ) ) goto TERMINATE;
+  for( i=0; i<zPH3DFaceNum(ph); i++ ){
+    zVec3DCopy( zTri3DVert(zPH3DFace(ph,i),0), &pbox[i].min );
+    zVec3DCopy( zTri3DVert(zPH3DFace(ph,i),0), &pbox[i].max );
+    for( j=zX; j<=zZ; j++ ){
+      pbox[i].min.e[j] = zMin( pbox[i].min.e[j], zMin( zTri3DVert(zPH3DFace(ph,i),1)->e[j], zTri3DVert(zPH3DFace(ph,i),2)->e[j] ) );
+      pbox[i].max.e[j] = zMax( pbox[i].max.e[j], zMax( zTri3DVert(zPH3DFace(ph,i),1)->e[j], zTri3DVert(zPH3DFace(ph,i),2)->e[j] ) );
+    }
+  }
+  if( !( ret = _rkCDBVHBuild( fbvh, pbox, zPH3DFaceNum(ph) ) ) )
+    _rkCDBVHDestroy( vbvh );
+ TERMINATE:
+  zFree( pbox );
+  return ret;
+}
+
 /* initialize a collision detection cell. */
 static void _rkCDCellInit(rkCDCell *cell)
 {
@@ -18,6 +217,79 @@ static void _rkCDCellInit(rkCDCell *cell)
   zAABox3DInit( &cell->data.aabb );
   zBox3DInit( &cell->data.obb );
   zPH3DInit( &cell->data.ph );
+  _rkCDBVHInit( &cell->data.vbvh );
+  _rkCDBVHInit( &cell->data.fbvh );
+  cell->data.prim.type = RK_CD_PRIM_NONE;
+}
+
+/* keep the primitive of a shape, which is lost in the conversion to a polyhedron. */
+static void _rkCDPrimCreate(rkCDPrim *prim, zShape3D *shape)
+{
+  zBox3D *box;
+
+  prim->type = RK_CD_PRIM_NONE;
+  if( shape->com == &zeo_shape3d_sphere_com ){
+    prim->type = RK_CD_PRIM_SPHERE;
+    zVec3DCopy( zSphere3DCenter(zShape3DSphere(shape)), &prim->center[0] );
+    zVec3DCopy( &prim->center[0], &prim->center[1] );
+    prim->radius = zSphere3DRadius(zShape3DSphere(shape));
+  } else
+  if( shape->com == &zeo_shape3d_capsule_com ){
+    prim->type = RK_CD_PRIM_CAPSULE;
+    zVec3DCopy( zCapsule3DCenter(zShape3DCapsule(shape),0), &prim->center[0] );
+    zVec3DCopy( zCapsule3DCenter(zShape3DCapsule(shape),1), &prim->center[1] );
+    prim->radius = zCapsule3DRadius(zShape3DCapsule(shape));
+  } else
+  if( shape->com == &zeo_shape3d_cyl_com ){
+    zVec3DCopy( zCyl3DCenter(zShape3DCyl(shape),0), &prim->center[0] );
+    zVec3DCopy( zCyl3DCenter(zShape3DCyl(shape),1), &prim->center[1] );
+    prim->radius = zCyl3DRadius(zShape3DCyl(shape));
+    /* a flat cylinder without the axis is checked as a polyhedron */
+    if( !zVec3DEqual( &prim->center[0], &prim->center[1] ) )
+      prim->type = RK_CD_PRIM_CYLINDER;
+  } else
+  if( shape->com == &zeo_shape3d_box_com ){
+    prim->type = RK_CD_PRIM_BOX;
+    box = zShape3DBox(shape);
+    zVec3DCopy( zBox3DCenter(box), &prim->center[0] );
+    zVec3DCopy( &prim->center[0], &prim->center[1] );
+    zVec3DCopy( zBox3DAxis(box,zX), &prim->axis[zX] );
+    zVec3DCopy( zBox3DAxis(box,zY), &prim->axis[zY] );
+    zVec3DCopy( zBox3DAxis(box,zZ), &prim->axis[zZ] );
+    prim->dia[zX] = 0.5 * zBox3DDepth(box);
+    prim->dia[zY] = 0.5 * zBox3DWidth(box);
+    prim->dia[zZ] = 0.5 * zBox3DHeight(box);
+  }
+}
+
+/* bounding box of a primitive in the local frame, which encloses the curved
+   surface as well. A sphere, a capsule and a cylinder are along the z-axis. */
+static void _rkCDPrimBB(rkCDPrim *prim, zBox3D *bb)
+{
+  zVec3D c, ax, ay, az;
+  double l;
+
+  zVec3DAdd( &prim->center[0], &prim->center[1], &c );
+  zVec3DMulDRC( &c, 0.5 );
+  if( prim->type == RK_CD_PRIM_BOX ){
+    zBox3DCreate( bb, &c, &prim->axis[zX], &prim->axis[zY], &prim->axis[zZ],
+      2*prim->dia[zX], 2*prim->dia[zY], 2*prim->dia[zZ] );
+    return;
+  }
+  zVec3DSub( &prim->center[1], &prim->center[0], &az );
+  if( zIsTiny( l = zVec3DNorm( &az ) ) )
+    zVec3DCreate( &az, 0, 0, 1 );
+  else
+    zVec3DDivDRC( &az, l );
+  if( fabs( az.e[zX] ) < 0.5 )
+    zVec3DCreate( &ax, 1, 0, 0 );
+  else
+    zVec3DCreate( &ax, 0, 1, 0 );
+  zVec3DCatDRC( &ax, -zVec3DInnerProd( &ax, &az ), &az );
+  zVec3DNormalizeDRC( &ax );
+  zVec3DOuterProd( &az, &ax, &ay );
+  zBox3DCreate( bb, &c, &ax, &ay, &az, 2*prim->radius, 2*prim->radius,
+    prim->type == RK_CD_PRIM_CYLINDER ? l : l + 2*prim->radius );
 }
 
 /* create a collision detection cell. */
@@ -30,13 +302,23 @@ static rkCDCell *_rkCDCellCreate(rkCDCell *cell, rkChain *chain, rkLink *link, z
   cell->data.type = type;
   cell->data._ph_update_flag = false;
   cell->data._bb_update_flag = false;
+  cell->data._id = -1;
+  cell->data._defer = false;
+  cell->data._noself = false;
   /* for a fake-crawler */
   cell->data.slide_mode = false;
   cell->data.slide_vel = 0.0;
   /* convert the original shape to a polyhedron */
+  _rkCDPrimCreate( &cell->data.prim, cell->data.shape );
   if( !zShape3DToPH( cell->data.shape ) ) return NULL;
+  /* create the bounding volume hierarchies in the local frame */
+  if( !_rkCDBVHBuildPH( &cell->data.vbvh, &cell->data.fbvh, zShape3DPH(cell->data.shape) ) )
+    return NULL;
   /* create the bounding box of the shape */
-  zOBB3D( &cell->data.bb, zShape3DVertBuf(cell->data.shape), zShape3DVertNum(cell->data.shape) );
+  if( cell->data.prim.type != RK_CD_PRIM_NONE )
+    _rkCDPrimBB( &cell->data.prim, &cell->data.bb );
+  else
+    zOBB3D( &cell->data.bb, zShape3DVertBuf(cell->data.shape), zShape3DVertNum(cell->data.shape) );
 
   if( !zPH3DClone( zShape3DPH(cell->data.shape), &cell->data.ph ) )
     return NULL;
@@ -44,6 +326,9 @@ static rkCDCell *_rkCDCellCreate(rkCDCell *cell, rkChain *chain, rkLink *link, z
 
   zBox3DXform( &cell->data.bb, rkLinkWldFrame(cell->data.link), &cell->data.obb );
   zBox3DToAABox3D( &cell->data.obb, &cell->data.aabb );
+  /* posture for the continuous check */
+  zFrame3DCopy( rkLinkWldFrame(cell->data.link), &cell->data._f0 );
+  cell->data._aabb0 = cell->data.aabb;
   return cell;
 }
 
@@ -51,6 +336,8 @@ static rkCDCell *_rkCDCellCreate(rkCDCell *cell, rkChain *chain, rkLink *link, z
 static void _rkCDCellDestroy(rkCDCell *cell)
 {
   zPH3DDestroy( &cell->data.ph );
+  _rkCDBVHDestroy( &cell->data.vbvh );
+  _rkCDBVHDestroy( &cell->data.fbvh );
   _rkCDCellInit( cell );
 }
 
@@ -102,6 +389,273 @@ void rkCDCellUpdate(rkCDCell *cell)
   }
 }
 
+/* initialize the sweep-and-prune broad phase. */
+static void _rkCDSAPInit(rkCDSAP *sap)
+{
+  sap->axis = zX;
+  sap->cellnum = 0;
+  sap->cell = NULL;
+  sap->ep = NULL;
+  sap->pairnum = sap->tablesize = sap->entrynum = 0;
+  sap->table = NULL;
+  sap->_active = sap->_activepos = NULL;
+  sap->_dirty = true;
+}
+
+/* destroy the sweep-and-prune broad phase. */
+static void _rkCDSAPDestroy(rkCDSAP *sap)
+{
+  zFree( sap->cell );
+  zFree( sap->ep );
+  zFree( sap->table );
+  zFree( sap->_active );
+  zFree( sap->_activepos );
+  _rkCDSAPInit( sap );
+}
+
+/* invalidate the broad phase when cells or pairs are modified. */
+static void _rkCDSAPInvalidate(rkCD *cd)
+{
+  cd->sap._dirty = true;
+  cd->candnum = cd->_prevnum = 0;
+}
+
+/* initialize statistics. */
+static void _rkCDStatInit(rkCDStat *stat)
+{
+  stat->vert_cand = stat->vert_test = 0;
+  stat->face_cand = stat->face_test = 0;
+  stat->gjk_test = stat->gjk_warm = 0;
+  stat->prim_test = 0;
+}
+
+/* accumulate statistics. */
+static void _rkCDStatAdd(rkCDStat *stat, rkCDStat *src)
+{
+  stat->vert_cand += src->vert_cand;
+  stat->vert_test += src->vert_test;
+  stat->face_cand += src->face_cand;
+  stat->face_test += src->face_test;
+  stat->gjk_test += src->gjk_test;
+  stat->gjk_warm += src->gjk_warm;
+  stat->prim_test += src->prim_test;
+}
+
+/* narrow phase test of a candidate pair, which returns the number of collisions. */
+typedef int (* _rkCDPairFunc)(rkCD*,rkCDPair*,rkCDStat*);
+
+#ifdef __RK_CD_MT
+/* pool of worker threads for the narrow phase */
+typedef struct _rkCDPool _rkCDPool;
+
+typedef struct{
+  _rkCDPool *pool;
+  int id;
+} _rkCDWorker;
+
+struct _rkCDPool{
+  int nthread; /* number of workers including the caller */
+  pthread_t thread[RK_CD_MT_MAX];
+  _rkCDWorker worker[RK_CD_MT_MAX];
+  rkCDStat stat[RK_CD_MT_MAX];
+  pthread_mutex_t mutex;
+  pthread_cond_t cond_start;
+  pthread_cond_t cond_done;
+  int generation; /* incremented for every job */
+  int running;    /* number of workers running the job */
+  bool quit;
+  /* job */
+  rkCD *cd;
+  _rkCDPairFunc pair_fp;
+  int next;       /* the next pair to be processed */
+};
+
+/* process candidate pairs until none remains. */
+static void _rkCDPoolRun(_rkCDPool *pool, int id)
+{
+  rkCD *cd;
+  int k;
+
+  cd = pool->cd;
+  while( 1 ){
+    pthread_mutex_lock( &pool->mutex );
+    k = pool->next++;
+    pthread_mutex_unlock( &pool->mutex );
+    if( k >= cd->candnum ) break;
+    cd->_res[k] = pool->pair_fp( cd, cd->cand[k], &pool->stat[id] );
+  }
+}
+
+static void *_rkCDPoolWorker(void *arg)
+{
+  _rkCDWorker *worker;
+  _rkCDPool *pool;
+  int generation = 0;
+
+  worker = arg;
+  pool = worker->pool;
+  pthread_mutex_lock( &pool->mutex );
+  while( 1 ){
+    while( !pool->quit && pool->generation == generation )
+      pthread_cond_wait( &pool->cond_start, &pool->mutex );
+    if( pool->quit ) break;
+    generation = pool->generation;
+    pthread_mutex_unlock( &pool->mutex );
+    _rkCDPoolRun( pool, worker->id );
+    pthread_mutex_lock( &pool->mutex );
+    if( --pool->running == 0 )
+      pthread_cond_signal( &pool->cond_done );
+  }
+  pthread_mutex_unlock( &pool->mutex );
+  return NULL;
+}
+
+/* create a pool of worker threads. */
+static _rkCDPool *_rkCDPoolCreate(int nthread)
+{
+  _rkCDPool *pool;
+
+  if( !( pool = zAlloc( _rkCDPool, 1 ) ) ){
+    ZALLOCERROR();
+    return NULL;
+  }
+  pthread_mutex_init( &pool->mutex, NULL );
+  pthread_cond_init( &pool->cond_start, NULL );
+  pthread_cond_init( &pool->cond_done, NULL );
+  pool->generation = pool->running = 0;
+  pool->quit = false;
+  /* the caller works as the first worker */
+  for( pool->nthread=1; pool->nthread<nthread; pool->nthread++ ){
+    pool->worker[pool->nthread].pool = pool;
+    pool->worker[pool->nthread].id = pool->nthread;
+    if( pthread_create( &pool->thread[pool->nthread], NULL, _rkCDPoolWorker, &pool->worker[pool->nthread] ) != 0 )
+      break;
+  }
+  return pool;
+}
+
+/* destroy a pool of worker threads. */
+static void _rkCDPoolDestroy(_rkCDPool *pool)
+{
+  register int i;
+
+  pthread_mutex_lock( &pool->mutex );
+  pool->quit = true;
+  pthread_cond_broadcast( &pool->cond_start );
+  pthread_mutex_unlock( &pool->mutex );
+  for( i=1; i<pool->nthread; i++ )
+    pthread_join( pool->thread[i], NULL );
+  pthread_cond_destroy( &pool->cond_start );
+  pthread_cond_destroy( &pool->cond_done );
+  pthread_mutex_destroy( &pool->mutex );
+  zFree( pool );
+}
+
+/* process candidate pairs on a pool of worker threads. */
+static void _rkCDPoolExec(_rkCDPool *pool, rkCD *cd, _rkCDPairFunc pair_fp)
+{
+  register int i;
+
+  for( i=0; i<pool->nthread; i++ )
+    _rkCDStatInit( &pool->stat[i] );
+  pthread_mutex_lock( &pool->mutex );
+  pool->cd = cd;
+  pool->pair_fp = pair_fp;
+  pool->next = 0;
+  pool->running = pool->nthread - 1;
+  pool->generation++;
+  pthread_cond_broadcast( &pool->cond_start );
+  pthread_mutex_unlock( &pool->mutex );
+  _rkCDPoolRun( pool, 0 );
+  pthread_mutex_lock( &pool->mutex );
+  while( pool->running > 0 )
+    pthread_cond_wait( &pool->cond_done, &pool->mutex );
+  pthread_mutex_unlock( &pool->mutex );
+  for( i=0; i<pool->nthread; i++ )
+    _rkCDStatAdd( &cd->stat, &pool->stat[i] );
+}
+#endif /* __RK_CD_MT */
+
+/* destroy the pool of worker threads of a collision detector. */
+static void _rkCDPoolFree(rkCD *cd)
+{
+#ifdef __RK_CD_MT
+  if( cd->_pool ) _rkCDPoolDestroy( cd->_pool );
+#endif
+  cd->_pool = NULL;
+}
+
+/* lock the pools of a collision detector shared by worker threads. */
+static void _rkCDLock(rkCD *cd)
+{
+#ifdef __RK_CD_MT
+  if( cd->_pool ) pthread_mutex_lock( &((_rkCDPool *)cd->_pool)->mutex );
+#endif
+}
+
+/* unlock the pools of a collision detector. */
+static void _rkCDUnlock(rkCD *cd)
+{
+#ifdef __RK_CD_MT
+  if( cd->_pool ) pthread_mutex_unlock( &((_rkCDPool *)cd->_pool)->mutex );
+#endif
+}
+
+/* release all contact vertices in a list to a pool. */
+static void _rkCDVertListRelease(rkCDVertList *list, rkCDVertList *pool)
+{
+  rkCDVert *v;
+
+  while( !zListIsEmpty( list ) ){
+    zListDeleteHead( list, &v );
+    zListInsertHead( pool, v );
+  }
+}
+
+/* release all contact planes in a list to a pool. */
+static void _rkCDPlaneListRelease(rkCDPlaneList *list, rkCDPlaneList *pool)
+{
+  rkCDPlane *p;
+
+  while( !zListIsEmpty( list ) ){
+    zListDeleteHead( list, &p );
+    zListInsertHead( pool, p );
+  }
+}
+
+/* allocate a contact vertex of a pair, which is recycled from those of the
+   pair released at the previous step, or from the pool of the detector. */
+static rkCDVert *_rkCDVertAlloc(rkCD *cd, rkCDPair *pair)
+{
+  rkCDVert *v = NULL;
+
+  if( !zListIsEmpty( &pair->data._vspare ) ){
+    zListDeleteHead( &pair->data._vspare, &v );
+    return v;
+  }
+  _rkCDLock( cd );
+  if( !zListIsEmpty( &cd->_vpool ) )
+    zListDeleteHead( &cd->_vpool, &v );
+  _rkCDUnlock( cd );
+  if( !v && !( v = zAlloc( rkCDVert, 1 ) ) )
+    ZALLOCERROR();
+  return v;
+}
+
+/* allocate a contact plane. */
+rkCDPlane *rkCDPlaneAlloc(rkCD *cd)
+{
+  rkCDPlane *p = NULL;
+
+  _rkCDLock( cd );
+  if( !zListIsEmpty( &cd->_ppool ) )
+    zListDeleteHead( &cd->_ppool, &p );
+  _rkCDUnlock( cd );
+  if( !p && !( p = zAlloc( rkCDPlane, 1 ) ) )
+    ZALLOCERROR();
+  return p;
+}
+
 /* create a collision detector. */
 rkCD *rkCDCreate(rkCD *cd)
 {
@@ -109,6 +663,19 @@ rkCD *rkCDCreate(rkCD *cd)
   zListInit( &cd->plist );
   cd->colnum = 0;
   cd->def_type = RK_CONTACT_KF;
+  _rkCDSAPInit( &cd->sap );
+  cd->cand = cd->_prev = NULL;
+  cd->candnum = cd->_prevnum = 0;
+  cd->_candsize = cd->_prevsize = 0;
+  cd->nthread = 1;
+  cd->_excl = NULL;
+  cd->_exclnum = cd->_exclsize = 0;
+  cd->_res = NULL;
+  cd->_ressize = 0;
+  cd->_pool = NULL;
+  zListInit( &cd->_vpool );
+  zListInit( &cd->_ppool );
+  rkCDStatReset( cd );
   return cd;
 }
 
@@ -116,8 +683,13 @@ rkCD *rkCDCreate(rkCD *cd)
 static void _rkCDPairDestroy(rkCDPair *pair)
 {
   zListDestroy( rkCDVert, &pair->data.vlist );
+  zListDestroy( rkCDVert, &pair->data._vspare );
   zListDestroy( rkCDPlane, &pair->data.cplane );
   zPH3DDestroy( &pair->data.colvol );
+  zFree( pair->data._idx );
+  pair->data._idxsize = 0;
+  zFree( pair->data._hist );
+  pair->data._histcap = pair->data._histsize = 0;
 }
 
 /* destroy a collision detector. */
@@ -136,10 +708,22 @@ void rkCDDestroy(rkCD *cd)
     _rkCDPairDestroy( pair );
     zFree( pair );
   }
+  _rkCDSAPDestroy( &cd->sap );
+  zFree( cd->cand );
+  zFree( cd->_prev );
+  cd->candnum = cd->_prevnum = 0;
+  cd->_candsize = cd->_prevsize = 0;
+  zFree( cd->_excl );
+  cd->_exclnum = cd->_exclsize = 0;
+  zFree( cd->_res );
+  cd->_ressize = 0;
+  _rkCDPoolFree( cd );
+  zListDestroy( rkCDVert, &cd->_vpool );
+  zListDestroy( rkCDPlane, &cd->_ppool );
 }
 
-/* register a pair of collision detection cells. */
-static rkCDPair *_rkCDPairReg(rkCD *cd, rkCDCell *c1, rkCDCell *c2)
+/* create a pair of collision detection cells. */
+static rkCDPair *_rkCDPairCreate(rkCDCell *c1, rkCDCell *c2)
 {
   rkCDPair *pair;
 
@@ -150,13 +734,85 @@ static rkCDPair *_rkCDPairReg(rkCD *cd, rkCDCell *c1, rkCDCell *c2)
   pair->data.cell[0] = c1;
   pair->data.cell[1] = c2;
   pair->data.is_col = false;
+  pair->data.toi = 1.0;
+  zVec3DZero( &pair->data.wit[0] );
+  zVec3DZero( &pair->data.wit[1] );
+  zVec3DZero( &pair->data._sep );
   zListInit( &pair->data.vlist );
   zListInit( &pair->data.cplane );
-  zListInsertHead( &cd->plist, pair );
   zPH3DInit( &pair->data.colvol );
+  zListInit( &pair->data._vspare );
+  pair->data._idx = NULL;
+  pair->data._idxsize = 0;
+  pair->data._hist = NULL;
+  pair->data._histcap = pair->data._histsize = 0;
+  return pair;
+}
+
+/* register a pair of collision detection cells. */
+static rkCDPair *_rkCDPairReg(rkCD *cd, rkCDCell *c1, rkCDCell *c2)
+{
+  rkCDPair *pair;
+
+  if( !( pair = _rkCDPairCreate( c1, c2 ) ) ) return NULL;
+  zListInsertHead( &cd->plist, pair );
+  _rkCDSAPInvalidate( cd );
   return pair;
 }
 
+/* exclude a pair of deferred cells from the check. */
+static bool _rkCDExclAdd(rkCD *cd, rkCDCell *c1, rkCDCell *c2)
+{
+  rkCDSAPEntry *excl;
+  int size;
+
+  if( cd->_exclnum == cd->_exclsize ){
+    size = zMax( 2*cd->_exclsize, 16 );
+    if( !( excl = zRealloc( cd->_excl, rkCDSAPEntry, size ) ) ){
+      ZALLOCERROR();
+      return false;
+    }
+    cd->_excl = excl;
+    cd->_exclsize = size;
+  }
+  cd->_excl[cd->_exclnum].cell[0] = c1;
+  cd->_excl[cd->_exclnum].cell[1] = c2;
+  cd->_excl[cd->_exclnum++].pair = NULL;
+  _rkCDSAPInvalidate( cd );
+  return true;
+}
+
+/* check if an excluded pair is between two links. */
+static bool _rkCDExclIsLink(rkCDSAPEntry *excl, rkLink *link1, rkLink *link2)
+{
+  return ( excl->cell[0]->data.link == link1 && excl->cell[1]->data.link == link2 ) ||
+         ( excl->cell[0]->data.link == link2 && excl->cell[1]->data.link == link1 );
+}
+
+/* purge excluded pairs between two links. */
+static void _rkCDExclPurgeLink(rkCD *cd, rkLink *link1, rkLink *link2)
+{
+  register int i, j;
+
+  for( i=j=0; i<cd->_exclnum; i++ )
+    if( !_rkCDExclIsLink( &cd->_excl[i], link1, link2 ) )
+      cd->_excl[j++] = cd->_excl[i];
+  if( j < cd->_exclnum ) _rkCDSAPInvalidate( cd );
+  cd->_exclnum = j;
+}
+
+/* purge excluded pairs which involve a chain. */
+static void _rkCDExclPurgeChain(rkCD *cd, rkChain *chain)
+{
+  register int i, j;
+
+  for( i=j=0; i<cd->_exclnum; i++ )
+    if( cd->_excl[i].cell[0]->data.chain != chain &&
+        cd->_excl[i].cell[1]->data.chain != chain )
+      cd->_excl[j++] = cd->_excl[i];
+  cd->_exclnum = j;
+}
+
 /* register all pairs of collision detection cells. */
 static rkCD *_rkCDPairCellReg(rkCD *cd, rkCDCell *cell)
 {
@@ -180,17 +836,28 @@ static rkCD *_rkCDPairCellReg(rkCD *cd, rkCDCell *cell)
 }
 
 /* reset a collision detector. */
+static void _rkCDPairReset(rkCD *cd, rkCDPair *pair)
+{
+  pair->data.is_col = false;
+  _rkCDPlaneListRelease( &pair->data.cplane, &cd->_ppool );
+  zPH3DDestroy( &pair->data.colvol );
+}
+
 void rkCDReset(rkCD *cd)
 {
   rkCDPair *pair;
   rkCDCell *cell;
+  register int i;
 
-  zListForEach( &cd->plist, pair ){
-    pair->data.is_col = false;
-    zListDestroy( rkCDPlane, &pair->data.cplane );
-    zPH3DDestroy( &pair->data.colvol );
+  /* only the candidate pairs can be in collision unless the broad phase is to be rebuilt */
+  if( cd->sap._dirty ){
+    zListForEach( &cd->plist, pair )
+      _rkCDPairReset( cd, pair );
+  } else{
+    for( i=0; i<cd->candnum; i++ )
+      _rkCDPairReset( cd, cd->cand[i] );
   }
-   zListForEach(&cd->clist, cell){
+  zListForEach(&cd->clist, cell){
     cell->data._ph_update_flag = false;
     cell->data._bb_update_flag = false;
   }
@@ -201,12 +868,37 @@ void rkCDSetDefaultFricType(rkCD *cd, rkContactFricType type)
   cd->def_type = type;
 }
 
+/* reset statistics of a collision detector. */
+void rkCDStatReset(rkCD *cd)
+{
+  _rkCDStatInit( &cd->stat );
+}
+
+/* print statistics of a collision detector. */
+void rkCDStatFPrint(FILE *fp, rkCD *cd)
+{
+  fprintf( fp, "vertices: %ld/%ld tested\n", cd->stat.vert_test, cd->stat.vert_cand );
+  fprintf( fp, "faces   : %ld/%ld tested\n", cd->stat.face_test, cd->stat.face_cand );
+  fprintf( fp, "GJK     : %ld/%ld warm-started\n", cd->stat.gjk_warm, cd->stat.gjk_test );
+  fprintf( fp, "closed  : %ld pairs of primitives\n", cd->stat.prim_test );
+}
+
+/* set the number of threads of a collision detector. */
+void rkCDSetThreadNum(rkCD *cd, int nthread)
+{
+  if( ( nthread = zLimit( nthread, 1, RK_CD_MT_MAX ) ) != cd->nthread )
+    _rkCDPoolFree( cd );
+  cd->nthread = nthread;
+}
+
 /* register a pair of links in a collision detector. */
 rkCD *rkCDPairReg(rkCD *cd, rkLink *link1, rkLink *link2)
 {
   rkCDCell *cp0, *cp1;
   rkCDPair *pair;
 
+  /* deferred cells of the links are to be paired in the broad phase */
+  _rkCDExclPurgeLink( cd, link1, link2 );
   zListForEach( &cd->plist, pair )
     if( ( pair->data.cell[0]->data.link == link1 &&
           pair->data.cell[1]->data.link == link2 ) ||
@@ -226,7 +918,16 @@ rkCD *rkCDPairReg(rkCD *cd, rkLink *link1, rkLink *link2)
 void rkCDPairUnreg(rkCD *cd, rkLink *link1, rkLink *link2)
 {
   rkCDPair *cp, *temp;
+  rkCDCell *cp0, *cp1;
 
+  /* prevent deferred cells of the links from being paired */
+  _rkCDExclPurgeLink( cd, link1, link2 );
+  zListForEach( &cd->clist, cp0 )
+    for( cp1=zListCellNext(cp0); cp1!=zListRoot(&cd->clist); cp1=zListCellNext(cp1) )
+      if( ( cp0->data._defer || cp1->data._defer ) &&
+          ( ( cp0->data.link == link1 && cp1->data.link == link2 ) ||
+            ( cp0->data.link == link2 && cp1->data.link == link1 ) ) )
+        _rkCDExclAdd( cd, cp0, cp1 );
   if( zListIsEmpty( &cd->plist ) ) return;
   zListForEach( &cd->plist, cp ){
     if( ( cp->data.cell[0]->data.link == link1 &&
@@ -240,12 +941,16 @@ void rkCDPairUnreg(rkCD *cd, rkLink *link1, rkLink *link2)
       cp = temp;
     }
   }
+  _rkCDSAPInvalidate( cd );
 }
 
 void rkCDPairChainUnreg(rkCD *cd, rkChain *chain)
 {
   rkCDPair *cp, *temp;
+  rkCDCell *cell;
 
+  zListForEach( &cd->clist, cell )
+    if( cell->data.chain == chain ) cell->data._noself = true;
   if( zListIsEmpty( &cd->plist ) ) return;
   zListForEach( &cd->plist, cp ){
     if( ( cp->data.cell[0]->data.chain == chain &&
@@ -257,6 +962,7 @@ void rkCDPairChainUnreg(rkCD *cd, rkChain *chain)
       cp = temp;
     }
   }
+  _rkCDSAPInvalidate( cd );
 }
 
 void rkCDPairPrint(rkCD *cd)
@@ -312,81 +1018,1213 @@ rkCD *rkCDChainReg(rkCD *cd, rkChain *chain, rkCDCellType type)
     zListForEach( &rkChainLink(chain,i)->body.shapelist, sc ){
       if( !rkCDCellReg( &cd->clist, chain, rkChainLink(chain,i), sc->data, type ) )
         return NULL;
+      _rkCDSAPInvalidate( cd );
       if( zListSize(&cd->clist) > 1 )
         _rkCDPairCellReg( cd, zListHead(&cd->clist) );
     }
   return cd;
 }
 
-void rkCDChainUnreg(rkCD *cd, rkChain *chain)
+/* a pair of cells to be tested for permanent collision. */
+typedef struct{
+  rkCDCell *cell[2];
+  bool is_col;
+} _rkCDFilterPair;
+
+/* a task of the permanent collision test. */
+typedef struct{
+  _rkCDFilterPair *pair;
+  int head, tail;
+} _rkCDFilterTask;
+
+static void *_rkCDFilterTaskRun(void *arg)
 {
-  rkCDPair *pair, *ptemp;
-  rkCDCell *cell, *ctemp;
+  _rkCDFilterTask *task;
+  zVec3D v1, v2;
+  register int i;
 
-  zListForEach( &cd->plist, pair ){
-    if( ( pair->data.cell[0]->data.chain == chain ) ||
-        ( pair->data.cell[1]->data.chain == chain ) ){
-      ptemp = zListCellPrev(pair);
-      _rkCDPairDestroy(pair);
-      zListPurge( &cd->plist, pair );
-      zFree( pair );
-      pair = ptemp;
-    }
-  }
-  zListForEach( &cd->clist, cell ){
-    if( cell->data.chain == chain ){
-      ctemp = zListCellPrev(cell);
-      _rkCDCellDestroy(cell);
-      zListPurge( &cd->clist, cell );
-      zFree( cell );
-      cell = ctemp;
-    }
-  }
+  task = arg;
+  for( i=task->head; i<task->tail; i++ )
+    task->pair[i].is_col =
+      zColChkBox3D( &task->pair[i].cell[0]->data.obb, &task->pair[i].cell[1]->data.obb ) &&
+      zColChkPH3D( &task->pair[i].cell[0]->data.ph, &task->pair[i].cell[1]->data.ph, &v1, &v2 );
+  return NULL;
 }
 
-static void _rkCDColChkAABB(rkCD *cd)
+/* test pairs of cells for permanent collision in parallel. */
+static void _rkCDFilterRun(_rkCDFilterPair *pair, int num, int nthread)
 {
-  rkCDPair *cp;
+  _rkCDFilterTask task[RK_CD_MT_MAX];
+#ifdef __RK_CD_MT
+  pthread_t thread[RK_CD_MT_MAX];
+  int nfork = 0;
+#endif
+  register int i;
 
-  zListForEach( &cd->plist, cp ){
-    /* TO BE MODIFIED */
-    rkCDCellUpdateBB( cp->data.cell[0] );
-    rkCDCellUpdateBB( cp->data.cell[1] );
-    if( zColChkAABox3D( &cp->data.cell[0]->data.aabb, &cp->data.cell[1]->data.aabb ) )
-      cp->data.is_col = true;
+  if( num <= 0 ) return;
+  nthread = zLimit( nthread, 1, zMin( num, RK_CD_MT_MAX ) );
+  for( i=0; i<nthread; i++ ){
+    task[i].pair = pair;
+    task[i].head = num * i / nthread;
+    task[i].tail = num * ( i + 1 ) / nthread;
+  }
+  for( i=1; i<nthread; i++ ){
+#ifdef __RK_CD_MT
+    if( pthread_create( &thread[nfork], NULL, _rkCDFilterTaskRun, &task[i] ) == 0 ){
+      nfork++;
+      continue;
+    }
+#endif
+    _rkCDFilterTaskRun( &task[i] );
   }
+  _rkCDFilterTaskRun( &task[0] );
+#ifdef __RK_CD_MT
+  for( i=0; i<nfork; i++ )
+    pthread_join( thread[i], NULL );
+#endif
 }
 
-static void _rkCDColChkOBB(rkCD *cd)
+/* an end point of a cell along x-axis to enumerate overlapping cells. */
+typedef struct{
+  double val;
+  int id;
+} _rkCDFilterEndPoint;
+
+static int _rkCDFilterEndPointCmp(const void *p1, const void *p2)
 {
-  rkCDPair *cp;
+  const _rkCDFilterEndPoint *ep1 = p1, *ep2 = p2;
 
-  zListForEach( &cd->plist, cp )
-    if( cp->data.is_col == true &&
-        !zColChkBox3D( &cp->data.cell[0]->data.obb, &cp->data.cell[1]->data.obb ) )
-      cp->data.is_col = false;
+  if( ep1->val < ep2->val ) return -1;
+  if( ep1->val > ep2->val ) return 1;
+  return ep1->id - ep2->id;
 }
 
-static void _rkCDColChkGJK(rkCD *cd)
+/* enumerate pairs of cells of a chain which are subject to the permanent collision test. */
+static _rkCDFilterPair *_rkCDFilterEnum(rkCDCell **cell, int n, int *num)
 {
-  rkCDPair *cp;
-  zVec3D v1, v2;
+  _rkCDFilterEndPoint *ep;
+  _rkCDFilterPair *pair = NULL, *p;
+  rkCDCell *c1, *c2;
+  int size = 0;
+  register int i, j;
 
-  zListForEach( &cd->plist, cp ){
-    if( cp->data.is_col == true ){
-      /* TO BE MODIFIED */
-      rkCDCellUpdatePH( cp->data.cell[0] );
-      rkCDCellUpdatePH( cp->data.cell[1] );
-      if( !zColChkPH3D( &cp->data.cell[0]->data.ph, &cp->data.cell[1]->data.ph,
-          &v1, &v2 ) )
-        cp->data.is_col = false;
+  *num = 0;
+  if( !( ep = zAlloc( _rkCDFilterEndPoint, zMax( n, 1 ) ) ) ){
+    ZALLOCERROR();
+    *num = -1;
+    return NULL;
+  }
+  for( i=0; i<n; i++ ){
+    ep[i].val = cell[i]->data.aabb.min.e[zX];
+    ep[i].id = i;
+  }
+  qsort( ep, n, sizeof(_rkCDFilterEndPoint), _rkCDFilterEndPointCmp );
+  for( i=0; i<n; i++ ){
+    c1 = cell[ep[i].id];
+    for( j=i+1; j<n && ep[j].val <= c1->data.aabb.max.e[zX]; j++ ){
+      c2 = cell[ep[j].id];
+      if( c1->data.link == c2->data.link ) continue;
+      if( c1->data.type == RK_CD_CELL_STAT && c2->data.type == RK_CD_CELL_STAT ) continue;
+      if( !zColChkAABox3D( &c1->data.aabb, &c2->data.aabb ) ) continue;
+      if( *num == size ){
+        size = zMax( 2*size, 16 );
+        if( !( p = zRealloc( pair, _rkCDFilterPair, size ) ) ){
+          ZALLOCERROR();
+          zFree( pair );
+          *num = -1;
+          goto TERMINATE;
+        }
+        pair = p;
+      }
+      /* the pair is ordered in the registration order for the cache */
+      pair[*num].cell[0] = ep[i].id < ep[j].id ? c1 : c2;
+      pair[*num].cell[1] = ep[i].id < ep[j].id ? c2 : c1;
+      pair[(*num)++].is_col = false;
     }
   }
+ TERMINATE:
+  zFree( ep );
+  return pair;
+}
+
+/* index of a cell in the registration order. */
+static int _rkCDFilterCellIndex(rkCDCell **cell, int n, rkCDCell *c)
+{
+  register int i;
+
+  for( i=0; i<n; i++ )
+    if( cell[i] == c ) return i;
+  return -1;
+}
+
+/* the name of a chain in the cache of the permanent collision test. */
+#define _rkCDFilterChainName(chain) ( zName(chain) ? zName(chain) : "noname" )
+
+/* bounding box of a cell in the link frame. */
+static void _rkCDFilterCellBox(rkCDCell *cell, zVec3D *min, zVec3D *max)
+{
+  zPH3D *ph;
+  register int i, k;
+
+  ph = zShape3DPH( cell->data.shape );
+  zVec3DZero( min );
+  zVec3DZero( max );
+  for( i=0; i<zPH3DVertNum(ph); i++ )
+    for( k=zX; k<=zZ; k++ ){
+      if( i == 0 || zPH3DVert(ph,i)->e[k] < min->e[k] ) min->e[k] = zPH3DVert(ph,i)->e[k];
+      if( i == 0 || zPH3DVert(ph,i)->e[k] > max->e[k] ) max->e[k] = zPH3DVert(ph,i)->e[k];
+    }
+}
+
+/* fingerprint of cells and a chain in the cache of the permanent collision test,
+   namely, the number of vertices and the bounding box in the link frame of each
+   cell, and the joint displacement of the chain at the test. */
+static void _rkCDFilterFingerprintWrite(FILE *fp, rkChain *chain, rkCDCell **cell, int n)
+{
+  zVec3D min, max;
+  double dis[6];
+  register int i, k;
+
+  for( i=0; i<n; i++ ){
+    _rkCDFilterCellBox( cell[i], &min, &max );
+    fprintf( fp, "%d %.17g %.17g %.17g %.17g %.17g %.17g\n", zPH3DVertNum(zShape3DPH(cell[i]->data.shape)),
+      min.e[zX], min.e[zY], min.e[zZ], max.e[zX], max.e[zY], max.e[zZ] );
+  }
+  fprintf( fp, "%d", rkChainJointSize(chain) );
+  for( i=0; i<rkChainLinkNum(chain); i++ ){
+    rkChainLinkJointGetDis( chain, i, dis );
+    for( k=0; k<rkChainLinkJointSize(chain,i); k++ )
+      fprintf( fp, " %.17g", dis[k] );
+  }
+  fprintf( fp, "\n" );
+}
+
+/* check if the fingerprint in the cache matches with the current cells and chain. */
+static bool _rkCDFilterFingerprintRead(FILE *fp, rkChain *chain, rkCDCell **cell, int n)
+{
+  zVec3D min, max;
+  double val[6], dis[6];
+  int vn;
+  register int i, k;
+
+  for( i=0; i<n; i++ ){
+    if( fscanf( fp, "%d %lf %lf %lf %lf %lf %lf", &vn, &val[0], &val[1], &val[2], &val[3], &val[4], &val[5] ) != 7 ||
+        vn != zPH3DVertNum(zShape3DPH(cell[i]->data.shape)) ) return false;
+    _rkCDFilterCellBox( cell[i], &min, &max );
+    for( k=zX; k<=zZ; k++ )
+      if( !zIsTiny( val[k] - min.e[k] ) || !zIsTiny( val[k+3] - max.e[k] ) ) return false;
+  }
+  if( fscanf( fp, "%d", &vn ) != 1 || vn != rkChainJointSize(chain) ) return false;
+  for( i=0; i<rkChainLinkNum(chain); i++ ){
+    rkChainLinkJointGetDis( chain, i, dis );
+    for( k=0; k<rkChainLinkJointSize(chain,i); k++ )
+      if( fscanf( fp, "%lf", &val[0] ) != 1 || !zIsTiny( val[0] - dis[k] ) ) return false;
+  }
+  return true;
+}
+
+/* read the cache of the permanent collision test. */
+static bool _rkCDFilterCacheRead(rkCD *cd, const char *cachefile, rkChain *chain, rkCDCell **cell, int n)
+{
+  FILE *fp;
+  char name[256];
+  int cn, num, i1, i2, exclnum;
+  register int i;
+  bool ret = false;
+
+  if( !( fp = fopen( cachefile, "r" ) ) ) return false;
+  exclnum = cd->_exclnum;
+  if( fscanf( fp, "%255s %d %d", name, &cn, &num ) != 3 ||
+      strcmp( name, _rkCDFilterChainName(chain) ) != 0 || cn != n ||
+      !_rkCDFilterFingerprintRead( fp, chain, cell, n ) ) goto TERMINATE;
+  for( i=0; i<num; i++ ){
+    if( fscanf( fp, "%d %d", &i1, &i2 ) != 2 ||
+        i1 < 0 || i1 >= n || i2 < 0 || i2 >= n || i1 == i2 ) goto TERMINATE;
+    if( !_rkCDExclAdd( cd, cell[i1], cell[i2] ) ) goto TERMINATE;
+  }
+  ret = true;
+ TERMINATE:
+  if( !ret ) cd->_exclnum = exclnum;
+  fclose( fp );
+  return ret;
+}
+
+/* write the cache of the permanent collision test. */
+static void _rkCDFilterCacheWrite(const char *cachefile, rkChain *chain, rkCDCell **cell, int n, _rkCDFilterPair *pair, int num)
+{
+  FILE *fp;
+  int colnum = 0;
+  register int i;
+
+  if( !( fp = fopen( cachefile, "w" ) ) ){
+    ZOPENERROR( cachefile );
+    return;
+  }
+  for( i=0; i<num; i++ )
+    if( pair[i].is_col ) colnum++;
+  fprintf( fp, "%s %d %d\n", _rkCDFilterChainName(chain), n, colnum );
+  _rkCDFilterFingerprintWrite( fp, chain, cell, n );
+  for( i=0; i<num; i++ )
+    if( pair[i].is_col )
+      fprintf( fp, "%d %d\n",
+        _rkCDFilterCellIndex( cell, n, pair[i].cell[0] ),
+        _rkCDFilterCellIndex( cell, n, pair[i].cell[1] ) );
+  fclose( fp );
+}
+
+/* register a chain to a collision detector with deferred pair creation. */
+rkCD *rkCDChainRegDefer(rkCD *cd, rkChain *chain, rkCDCellType type, const char *cachefile)
+{
+  zShapeListCell *sc;
+  rkCDCell **cell, *cp;
+  _rkCDFilterPair *pair;
+  int n = 0, num;
+  register int i;
+  int exclnum;
+  rkCD *ret = NULL;
+
+  exclnum = cd->_exclnum;
+  for( i=0; i<rkChainLinkNum(chain); i++ )
+    n += zListSize( &rkChainLink(chain,i)->body.shapelist );
+  if( !( cell = zAlloc( rkCDCell*, zMax( n, 1 ) ) ) ){
+    ZALLOCERROR();
+    return NULL;
+  }
+  for( n=0, i=0; i<rkChainLinkNum(chain); i++ )
+    zListForEach( &rkChainLink(chain,i)->body.shapelist, sc ){
+      if( !( cp = rkCDCellReg( &cd->clist, chain, rkChainLink(chain,i), sc->data, type ) ) )
+        goto TERMINATE;
+      cp->data._defer = true;
+      cell[n++] = cp;
+    }
+  _rkCDSAPInvalidate( cd );
+  /* ignore pairs in permanent collision */
+  if( !cachefile || !_rkCDFilterCacheRead( cd, cachefile, chain, cell, n ) ){
+    if( !( pair = _rkCDFilterEnum( cell, n, &num ) ) && num < 0 ) goto TERMINATE;
+    _rkCDFilterRun( pair, num, cd->nthread );
+    for( i=0; i<num; i++ )
+      if( pair[i].is_col && !_rkCDExclAdd( cd, pair[i].cell[0], pair[i].cell[1] ) ) break;
+    if( i == num && cachefile )
+      _rkCDFilterCacheWrite( cachefile, chain, cell, n, pair, num );
+    zFree( pair );
+    if( i < num ) goto TERMINATE;
+  }
+  ret = cd;
+ TERMINATE:
+  if( !ret ){ /* undo the registration, where no pairs of the cells have been created yet */
+    cd->_exclnum = exclnum;
+    for( i=0; i<n; i++ ){
+      zListPurge( &cd->clist, cell[i] );
+      _rkCDCellDestroy( cell[i] );
+      zFree( cell[i] );
+    }
+    _rkCDSAPInvalidate( cd );
+  }
+  zFree( cell );
+  return ret;
+}
+
+void rkCDChainUnreg(rkCD *cd, rkChain *chain)
+{
+  rkCDPair *pair, *ptemp;
+  rkCDCell *cell, *ctemp;
+
+  _rkCDExclPurgeChain( cd, chain );
+  zListForEach( &cd->plist, pair ){
+    if( ( pair->data.cell[0]->data.chain == chain ) ||
+        ( pair->data.cell[1]->data.chain == chain ) ){
+      ptemp = zListCellPrev(pair);
+      _rkCDPairDestroy(pair);
+      zListPurge( &cd->plist, pair );
+      zFree( pair );
+      pair = ptemp;
+    }
+  }
+  zListForEach( &cd->clist, cell ){
+    if( cell->data.chain == chain ){
+      ctemp = zListCellPrev(cell);
+      _rkCDCellDestroy(cell);
+      zListPurge( &cd->clist, cell );
+      zFree( cell );
+      cell = ctemp;
+    }
+  }
+  _rkCDSAPInvalidate( cd );
+}
+
+/* hash value of a pair of cells. */
+static int _rkCDSAPHash(rkCDSAP *sap, int id0, int id1)
+{
+  unsigned long key;
+
+  if( id0 > id1 ) zSwap( int, id0, id1 );
+  key = (unsigned long)id0 * 2654435761UL ^ (unsigned long)id1 * 40503UL;
+  return (int)( key & ( sap->tablesize - 1 ) );
+}
+
+/* find an entry of a pair of cells from the hash table of the broad phase. */
+static rkCDSAPEntry *_rkCDSAPTableFind(rkCDSAP *sap, rkCDCell *c1, rkCDCell *c2)
+{
+  rkCDSAPEntry *e;
+  int h;
+
+  for( h=_rkCDSAPHash( sap, c1->data._id, c2->data._id ); ( e = &sap->table[h] )->cell[0];
+       h=( h + 1 ) & ( sap->tablesize - 1 ) )
+    if( ( e->cell[0] == c1 && e->cell[1] == c2 ) ||
+        ( e->cell[0] == c2 && e->cell[1] == c1 ) )
+      return e;
+  return NULL;
+}
+
+/* add an entry of a pair of cells to the hash table of the broad phase. */
+static void _rkCDSAPTableAdd(rkCDSAP *sap, rkCDCell *c1, rkCDCell *c2, rkCDPair *pair)
+{
+  int h;
+
+  h = _rkCDSAPHash( sap, c1->data._id, c2->data._id );
+  while( sap->table[h].cell[0] )
+    h = ( h + 1 ) & ( sap->tablesize - 1 );
+  sap->table[h].cell[0] = c1;
+  sap->table[h].cell[1] = c2;
+  sap->table[h].pair = pair;
+  sap->entrynum++;
+}
+
+/* enlarge the hash table of the broad phase so as to keep its load factor below a half. */
+static bool _rkCDSAPTableReserve(rkCDSAP *sap, int num)
+{
+  rkCDSAPEntry *table;
+  int size;
+  register int i;
+
+  for( size=zMax( sap->tablesize, 16 ); size<2*num; size<<=1 );
+  if( size == sap->tablesize ) return true;
+  if( !( table = zAlloc( rkCDSAPEntry, size ) ) ){
+    ZALLOCERROR();
+    return false;
+  }
+  zSwap( rkCDSAPEntry*, sap->table, table );
+  zSwap( int, sap->tablesize, size );
+  sap->entrynum = 0;
+  for( i=0; i<size; i++ )
+    if( table[i].cell[0] )
+      _rkCDSAPTableAdd( sap, table[i].cell[0], table[i].cell[1], table[i].pair );
+  zFree( table );
+  return true;
+}
+
+/* enlarge an array of candidate pairs. */
+static bool _rkCDCandReserve(rkCDPair ***cand, int *size, int num)
+{
+  rkCDPair **p;
+  int newsize;
+
+  if( num <= *size ) return true;
+  for( newsize=zMax( *size, 16 ); newsize<num; newsize<<=1 );
+  if( !( p = zRealloc( *cand, rkCDPair*, newsize ) ) ){
+    ZALLOCERROR();
+    return false;
+  }
+  *cand = p;
+  *size = newsize;
+  return true;
+}
+
+/* comparison of end points; lower bounds precede upper bounds at the same coordinate. */
+static int _rkCDSAPEndPointCmp(const void *p1, const void *p2)
+{
+  const rkCDSAPEndPoint *ep1 = p1, *ep2 = p2;
+
+  if( ep1->val < ep2->val ) return -1;
+  if( ep1->val > ep2->val ) return 1;
+  return (int)ep1->is_max - (int)ep2->is_max;
+}
+
+/* coordinate of an end point on the sweep axis. */
+static double _rkCDSAPEndPointVal(rkCDSAP *sap, rkCDSAPEndPoint *ep)
+{
+  zAABox3D *aabb;
+
+  aabb = &sap->cell[ep->id]->data.aabb;
+  return ep->is_max ? aabb->max.e[sap->axis] : aabb->min.e[sap->axis];
+}
+
+/* rebuild the broad phase from the current cells and pairs. */
+static bool _rkCDSAPBuild(rkCD *cd)
+{
+  rkCDSAP *sap;
+  rkCDCell *cell;
+  rkCDPair *pair;
+  zVec3D c, sum, sum2;
+  register int i;
+  int n, m;
+
+  sap = &cd->sap;
+  _rkCDSAPDestroy( sap );
+  cd->candnum = cd->_prevnum = 0;
+  sap->cellnum = zListSize( &cd->clist );
+  sap->pairnum = zListSize( &cd->plist );
+  n = zMax( sap->cellnum, 1 );
+  m = zMax( sap->pairnum, 1 );
+  sap->cell = zAlloc( rkCDCell*, n );
+  sap->ep = zAlloc( rkCDSAPEndPoint, 2*n );
+  sap->_active = zAlloc( int, n );
+  sap->_activepos = zAlloc( int, n );
+  if( !sap->cell || !sap->ep || !sap->_active || !sap->_activepos ){
+    ZALLOCERROR();
+    _rkCDSAPDestroy( sap );
+    return false;
+  }
+  if( !_rkCDSAPTableReserve( sap, sap->pairnum + cd->_exclnum ) ||
+      !_rkCDCandReserve( &cd->cand, &cd->_candsize, m ) ||
+      !_rkCDCandReserve( &cd->_prev, &cd->_prevsize, m ) ){
+    _rkCDSAPDestroy( sap );
+    return false;
+  }
+  /* identify cells and choose the axis along which they spread the most */
+  zVec3DZero( &sum );
+  zVec3DZero( &sum2 );
+  i = 0;
+  zListForEach( &cd->clist, cell ){
+    rkCDCellUpdateBB( cell );
+    cell->data._id = i;
+    sap->cell[i++] = cell;
+    zVec3DMid( &cell->data.aabb.min, &cell->data.aabb.max, &c );
+    zVec3DAddDRC( &sum, &c );
+    c.e[zX] *= c.e[zX]; c.e[zY] *= c.e[zY]; c.e[zZ] *= c.e[zZ];
+    zVec3DAddDRC( &sum2, &c );
+  }
+  for( i=zX; i<=zZ; i++ )
+    c.e[i] = sap->cellnum > 0 ? sum2.e[i] - sum.e[i]*sum.e[i]/sap->cellnum : 0;
+  sap->axis = c.e[zX] >= c.e[zY] ? ( c.e[zX] >= c.e[zZ] ? zX : zZ ) : ( c.e[zY] >= c.e[zZ] ? zY : zZ );
+  for( i=0; i<sap->cellnum; i++ ){
+    sap->ep[2*i].id = sap->ep[2*i+1].id = i;
+    sap->ep[2*i].is_max = false;
+    sap->ep[2*i+1].is_max = true;
+    sap->ep[2*i].val = _rkCDSAPEndPointVal( sap, &sap->ep[2*i] );
+    sap->ep[2*i+1].val = _rkCDSAPEndPointVal( sap, &sap->ep[2*i+1] );
+  }
+  qsort( sap->ep, 2*sap->cellnum, sizeof(rkCDSAPEndPoint), _rkCDSAPEndPointCmp );
+  /* all pairs are regarded as the previous candidates so that stale contacts are released */
+  zListForEach( &cd->plist, pair ){
+    _rkCDSAPTableAdd( sap, pair->data.cell[0], pair->data.cell[1], pair );
+    cd->_prev[cd->_prevnum++] = pair;
+  }
+  /* explicitly registered pairs take precedence over exclusions */
+  for( i=0; i<cd->_exclnum; i++ )
+    if( !_rkCDSAPTableFind( sap, cd->_excl[i].cell[0], cd->_excl[i].cell[1] ) )
+      _rkCDSAPTableAdd( sap, cd->_excl[i].cell[0], cd->_excl[i].cell[1], NULL );
+  sap->_dirty = false;
+  return true;
+}
+
+/* prepare the broad phase for a new step. */
+static bool _rkCDSAPUpdate(rkCD *cd)
+{
+  rkCDPair **tmp;
+
+  if( cd->sap._dirty ||
+      cd->sap.cellnum != zListSize(&cd->clist) ||
+      cd->sap.pairnum != zListSize(&cd->plist) ){
+    if( !_rkCDSAPBuild( cd ) ) return false;
+  } else{
+    tmp = cd->_prev;
+    cd->_prev = cd->cand;
+    cd->cand = tmp;
+    zSwap( int, cd->_prevsize, cd->_candsize );
+    cd->_prevnum = cd->candnum;
+  }
+  cd->candnum = 0;
+  return true;
+}
+
+/* check if a pair of cells is to be created in the broad phase. */
+static bool _rkCDSAPIsDeferred(rkCDCell *c1, rkCDCell *c2)
+{
+  if( !c1->data._defer && !c2->data._defer ) return false;
+  if( c1->data.link == c2->data.link ) return false;
+  if( c1->data.chain == c2->data.chain &&
+      ( c1->data._noself || c2->data._noself ) ) return false;
+  return true;
+}
+
+/* check if any cells of a collision detector are registered with deferred pair creation. */
+static bool _rkCDHasDeferred(rkCD *cd)
+{
+  rkCDCell *cell;
+
+  zListForEach( &cd->clist, cell )
+    if( cell->data._defer ) return true;
+  return false;
+}
+
+/* create a deferred pair of cells in the broad phase. */
+static rkCDPair *_rkCDSAPPairCreate(rkCD *cd, rkCDCell *c1, rkCDCell *c2)
+{
+  rkCDPair *pair;
+
+  if( !_rkCDSAPTableReserve( &cd->sap, cd->sap.entrynum + 1 ) ||
+      !( pair = _rkCDPairCreate( c1, c2 ) ) ) return NULL;
+  zListInsertHead( &cd->plist, pair );
+  _rkCDSAPTableAdd( &cd->sap, c1, c2, pair );
+  cd->sap.pairnum++;
+  return pair;
+}
+
+/* sweep-and-prune broad phase. */
+static void _rkCDColChkAABB(rkCD *cd)
+{
+  rkCDSAP *sap;
+  rkCDSAPEndPoint ep;
+  rkCDSAPEntry *e;
+  rkCDCell *cell, *cp;
+  rkCDPair *pair;
+  register int i, j;
+  int activenum = 0;
+
+  if( !_rkCDSAPUpdate( cd ) ) return;
+  sap = &cd->sap;
+  /* update end points and sort them by insertion, which runs in almost
+     linear time owing to the temporal coherence */
+  for( i=0; i<2*sap->cellnum; i++ ){
+    rkCDCellUpdateBB( sap->cell[sap->ep[i].id] );
+    sap->ep[i].val = _rkCDSAPEndPointVal( sap, &sap->ep[i] );
+  }
+  for( i=1; i<2*sap->cellnum; i++ ){
+    ep = sap->ep[i];
+    for( j=i-1; j>=0 && _rkCDSAPEndPointCmp( &sap->ep[j], &ep ) > 0; j-- )
+      sap->ep[j+1] = sap->ep[j];
+    sap->ep[j+1] = ep;
+  }
+  /* sweep */
+  for( i=0; i<2*sap->cellnum; i++ ){
+    cell = sap->cell[sap->ep[i].id];
+    if( sap->ep[i].is_max ){ /* remove the cell from the active list */
+      j = sap->_activepos[cell->data._id];
+      sap->_active[j] = sap->_active[--activenum];
+      sap->_activepos[sap->_active[j]] = j;
+      continue;
+    }
+    for( j=0; j<activenum; j++ ){
+      cp = sap->cell[sap->_active[j]];
+      if( cell->data.type == RK_CD_CELL_STAT && cp->data.type == RK_CD_CELL_STAT ) continue;
+      if( !zColChkAABox3D( &cell->data.aabb, &cp->data.aabb ) ) continue;
+      if( ( e = _rkCDSAPTableFind( sap, cell, cp ) ) ){
+        if( !( pair = e->pair ) ) continue; /* excluded */
+      } else{
+        if( !_rkCDSAPIsDeferred( cell, cp ) ||
+            !( pair = _rkCDSAPPairCreate( cd, cp, cell ) ) ) continue;
+      }
+      if( !pair->data.is_col &&
+          _rkCDCandReserve( &cd->cand, &cd->_candsize, cd->candnum+1 ) ){
+        pair->data.is_col = true;
+        cd->cand[cd->candnum++] = pair;
+      }
+    }
+    sap->_activepos[cell->data._id] = activenum;
+    sap->_active[activenum++] = cell->data._id;
+  }
+  /* release contact vertices of pairs which left the candidates to the pool */
+  for( i=0; i<cd->_prevnum; i++ )
+    if( !cd->_prev[i]->data.is_col ){
+      _rkCDVertListRelease( &cd->_prev[i]->data.vlist, &cd->_vpool );
+      _rkCDVertListRelease( &cd->_prev[i]->data._vspare, &cd->_vpool );
+    }
+}
+
+/* minimum number of candidate pairs to be processed in parallel */
+#define RK_CD_MT_GRAIN 4
+
+/* check if a pair is in rigid contact. */
+static bool _rkCDPairIsRigid(rkCDPair *cp)
+{
+  return cp->data.ci && rkContactInfoType(cp->data.ci) == RK_CONTACT_RIGID;
+}
+
+/* update polyhedra of cells in candidate pairs once before the narrow phase,
+   which are shared by the pairs processed in parallel. */
+static void _rkCDCandUpdatePH(rkCD *cd, bool rigid)
+{
+  rkCDPair *cp;
+  register int k;
+
+  for( k=0; k<cd->candnum; k++ ){
+    cp = cd->cand[k];
+    if( cp->data.is_col == false || ( rigid && !_rkCDPairIsRigid( cp ) ) ) continue;
+    rkCDCellUpdatePH( cp->data.cell[0] );
+    rkCDCellUpdatePH( cp->data.cell[1] );
+  }
+}
+
+#ifdef __RK_CD_MT
+/* prepare results of the narrow phase for candidate pairs. */
+static bool _rkCDResReserve(rkCD *cd)
+{
+  int *res;
+
+  if( cd->candnum <= cd->_ressize ) return true;
+  if( !( res = zRealloc( cd->_res, int, cd->_candsize ) ) ){
+    ZALLOCERROR();
+    return false;
+  }
+  cd->_res = res;
+  cd->_ressize = cd->_candsize;
+  return true;
+}
+#endif /* __RK_CD_MT */
+
+/* narrow phase over candidate pairs. The number of collisions is summed
+   up in the order of pairs, so that it does not depend on threads. */
+static void _rkCDNarrowPhase(rkCD *cd, _rkCDPairFunc pair_fp, bool count)
+{
+  int colnum = 0;
+  register int k;
+
+#ifdef __RK_CD_MT
+  if( cd->nthread > 1 && cd->candnum >= RK_CD_MT_GRAIN && _rkCDResReserve( cd ) &&
+      ( cd->_pool || ( cd->_pool = _rkCDPoolCreate( cd->nthread ) ) ) ){
+    _rkCDPoolExec( cd->_pool, cd, pair_fp );
+    for( k=0; k<cd->candnum; k++ )
+      colnum += cd->_res[k];
+  } else
+#endif /* __RK_CD_MT */
+  for( k=0; k<cd->candnum; k++ )
+    colnum += pair_fp( cd, cd->cand[k], &cd->stat );
+  if( count ) cd->colnum = colnum;
+}
+
+static int _rkCDColChkOBBPair(rkCD *cd, rkCDPair *cp, rkCDStat *stat)
+{
+  if( cp->data.is_col == true &&
+      !zColChkBox3D( &cp->data.cell[0]->data.obb, &cp->data.cell[1]->data.obb ) )
+    cp->data.is_col = false;
+  return 0;
+}
+
+static void _rkCDColChkOBB(rkCD *cd)
+{
+  _rkCDNarrowPhase( cd, _rkCDColChkOBBPair, false );
+}
+
+/* relative frame of a frame with respect to another. */
+static void _rkCDRelFrame(zFrame3D *f0, zFrame3D *f1, zFrame3D *f)
+{
+  zMulMat3DTMat3D( zFrame3DAtt(f1), zFrame3DAtt(f0), zFrame3DAtt(f) );
+  zXform3DInv( f1, zFrame3DPos(f0), zFrame3DPos(f) );
+}
+
+/* relative frame of a cell with respect to another. */
+static void _rkCDCellRelFrame(rkCDCell *c0, rkCDCell *c1, zFrame3D *f)
+{
+  _rkCDRelFrame( rkLinkWldFrame(c0->data.link), rkLinkWldFrame(c1->data.link), f );
+}
+
+/* maximum number of iterations of GJK algorithm */
+#define RK_CD_GJK_ITER_MAX 64
+/* tolerance of squared distance to regard two shapes in contact */
+#define RK_CD_GJK_TOL      ( zTOL )
+/* relative tolerance of the convergence of the distance */
+#define RK_CD_GJK_EPS      ( 1.0e-6 )
+
+/* a vertex of a simplex in GJK algorithm. */
+typedef struct{
+  zVec3D w;    /* point on the Minkowski difference */
+  zVec3D p[2]; /* support points of two shapes */
+} _rkCDGJKVert;
+
+/* support point of a polyhedron in a direction. */
+static zVec3D *_rkCDSupport(zPH3D *ph, zVec3D *d)
+{
+  double s, smax;
+  int imax = 0;
+  register int i;
+
+  smax = zVec3DInnerProd( zPH3DVert(ph,0), d );
+  for( i=1; i<zPH3DVertNum(ph); i++ )
+    if( ( s = zVec3DInnerProd( zPH3DVert(ph,i), d ) ) > smax ){
+      smax = s;
+      imax = i;
+    }
+  return zPH3DVert(ph,imax);
+}
+
+/* support point of the Minkowski difference of two polyhedra in the frame
+   of the latter, where the former is transformed by a relative frame. */
+static void _rkCDGJKSupport(zPH3D *ph0, zFrame3D *f, zPH3D *ph1, zVec3D *d, _rkCDGJKVert *v)
+{
+  zVec3D d0, d1;
+
+  zMulMat3DTVec3D( zFrame3DAtt(f), d, &d0 );
+  zXform3D( f, _rkCDSupport( ph0, &d0 ), &v->p[0] );
+  zVec3DRev( d, &d1 );
+  zVec3DCopy( _rkCDSupport( ph1, &d1 ), &v->p[1] );
+  zVec3DSub( &v->p[0], &v->p[1], &v->w );
+}
+
+/* projection of the origin onto the affine hull of a subset of a simplex;
+   returns false if the subset is degenerate or the projection is out of it. */
+static bool _rkCDGJKProj(_rkCDGJKVert *s, int *idx, int n, double *l)
+{
+  double g[3][4], r, scale = 0;
+  zVec3D e[3];
+  register int i, j, k;
+
+  for( i=1; i<n; i++ )
+    zVec3DSub( &s[idx[i]].w, &s[idx[0]].w, &e[i-1] );
+  /* Gram system augmented by the right-hand side */
+  for( i=0; i<n-1; i++ ){
+    for( j=0; j<n-1; j++ )
+      g[i][j] = zVec3DInnerProd( &e[i], &e[j] );
+    g[i][n-1] = -zVec3DInnerProd( &e[i], &s[idx[0]].w );
+    scale += g[i][i];
+  }
+  /* Gaussian elimination with partial pivoting */
+  for( i=0; i<n-1; i++ ){
+    for( k=i, j=i+1; j<n-1; j++ )
+      if( fabs( g[j][i] ) > fabs( g[k][i] ) ) k = j;
+    if( fabs( g[k][i] ) <= zTOL * scale ) return false;
+    if( k != i )
+      for( j=i; j<n; j++ ) zSwap( double, g[i][j], g[k][j] );
+    for( k=i+1; k<n-1; k++ ){
+      r = g[k][i] / g[i][i];
+      for( j=i; j<n; j++ ) g[k][j] -= r * g[i][j];
+    }
+  }
+  for( l[0]=1, i=n-2; i>=0; i-- ){
+    for( r=g[i][n-1], j=i+1; j<n-1; j++ ) r -= g[i][j] * l[j+1];
+    if( ( l[i+1] = r / g[i][i] ) < 0 ) return false;
+  }
+  for( i=1; i<n; i++ ) l[0] -= l[i];
+  return l[0] >= 0;
+}
+
+/* closest point of a simplex to the origin, which reduces the simplex to the
+   smallest face that contains the point. */
+static void _rkCDGJKClosest(_rkCDGJKVert *s, int *n, double *l, zVec3D *v)
+{
+  _rkCDGJKVert ss[4];
+  int idx[4], bestidx[4], m, c, bestm = 0;
+  double sl[4], bestl[4], d, dmin = HUGE_VAL;
+  zVec3D sv;
+  register int i, b;
+
+  /* examine all subsets in ascending order of the size */
+  for( m=1; m<=*n; m++ )
+    for( b=1; b<(1<<*n); b++ ){
+      for( c=0, i=0; i<*n; i++ )
+        if( ( b >> i ) & 1 ) idx[c++] = i;
+      if( c != m || !_rkCDGJKProj( s, idx, m, sl ) ) continue;
+      zVec3DZero( &sv );
+      for( i=0; i<m; i++ )
+        zVec3DCatDRC( &sv, sl[i], &s[idx[i]].w );
+      if( ( d = zVec3DSqrNorm( &sv ) ) < dmin ){
+        dmin = d;
+        bestm = m;
+        for( i=0; i<m; i++ ){
+          bestidx[i] = idx[i];
+          bestl[i] = sl[i];
+        }
+      }
+    }
+  for( i=0; i<bestm; i++ ){
+    ss[i] = s[bestidx[i]];
+    l[i] = bestl[i];
+  }
+  zVec3DZero( v );
+  for( *n=bestm, i=0; i<bestm; i++ ){
+    s[i] = ss[i];
+    zVec3DCatDRC( v, l[i], &s[i].w );
+  }
+}
+
+/* GJK algorithm on two polyhedra, which runs in the frame of the latter
+   with the former transformed by a relative frame, so that only support
+   points are transformed. The search starts from a direction \a v0 if
+   given, or the relative position of the polyhedra otherwise. Unless
+   \a dist is true, it immediately returns if the direction separates the
+   polyhedra. If \a dist is true, it continues until the distance converges
+   even after a separating axis is found. The closest vector from the latter
+   to the former (or the initial direction if it separates them) and the
+   witness points are stored in \a v, \a p0 and \a p1 in the frame of the
+   latter, respectively. */
+static bool _rkCDGJK(zPH3D *ph0, zFrame3D *f, zPH3D *ph1, zVec3D *v0, bool dist, zVec3D *v, zVec3D *p0, zVec3D *p1)
+{
+  _rkCDGJKVert s[4];
+  double l[4], vv, vw;
+  zVec3D d;
+  int n = 1, iter;
+  register int i;
+  bool ret = true;
+
+  if( !v0 ) v0 = zFrame3DPos(f);
+  zVec3DRev( v0, &d );
+  _rkCDGJKSupport( ph0, f, ph1, &d, &s[0] );
+  l[0] = 1;
+  if( !dist && zVec3DInnerProd( v0, &s[0].w ) > 0 ){ /* the initial direction separates */
+    zVec3DCopy( v0, v );
+    zVec3DCopy( &s[0].p[0], p0 );
+    zVec3DCopy( &s[0].p[1], p1 );
+    return false;
+  }
+  zVec3DCopy( &s[0].w, v );
+  for( iter=0; iter<RK_CD_GJK_ITER_MAX; iter++ ){
+    if( ( vv = zVec3DSqrNorm( v ) ) <= RK_CD_GJK_TOL ) break;
+    zVec3DRev( v, &d );
+    _rkCDGJKSupport( ph0, f, ph1, &d, &s[n] );
+    vw = zVec3DInnerProd( v, &s[n].w );
+    if( ( !dist && vw > 0 ) || /* separating axis found */
+        vv - vw <= RK_CD_GJK_EPS * vv ){ /* distance converged */
+      ret = false;
+      break;
+    }
+    n++;
+    _rkCDGJKClosest( s, &n, l, v );
+  }
+  /* witness points */
+  zVec3DZero( p0 );
+  zVec3DZero( p1 );
+  for( i=0; i<n; i++ ){
+    zVec3DCatDRC( p0, l[i], &s[i].p[0] );
+    zVec3DCatDRC( p1, l[i], &s[i].p[1] );
+  }
+  return ret;
+}
+
+/* tolerance to ignore a cross product of nearly parallel edges of boxes */
+#define RK_CD_PRIM_EPS ( 1.0e-6 )
+
+/* transform a primitive to the world frame. */
+static void _rkCDPrimXform(rkCDPrim *src, zFrame3D *f, rkCDPrim *dest)
+{
+  register int i;
+
+  dest->type = src->type;
+  zXform3D( f, &src->center[0], &dest->center[0] );
+  zXform3D( f, &src->center[1], &dest->center[1] );
+  for( i=zX; i<=zZ; i++ ){
+    zMulMat3DVec3D( zFrame3DAtt(f), &src->axis[i], &dest->axis[i] );
+    dest->dia[i] = src->dia[i];
+  }
+  dest->radius = src->radius;
+}
+
+/* closest points between two segments. */
+static void _rkCDSegClosest(zVec3D *p0, zVec3D *q0, zVec3D *p1, zVec3D *q1, zVec3D *c0, zVec3D *c1)
+{
+  zVec3D d0, d1, r;
+  double a, b, c, e, f, den, s, t;
+
+  zVec3DSub( q0, p0, &d0 );
+  zVec3DSub( q1, p1, &d1 );
+  zVec3DSub( p0, p1, &r );
+  a = zVec3DSqrNorm( &d0 );
+  e = zVec3DSqrNorm( &d1 );
+  f = zVec3DInnerProd( &d1, &r );
+  if( a <= zTOL && e <= zTOL ){
+    s = t = 0;
+  } else
+  if( a <= zTOL ){
+    s = 0;
+    t = zLimit( f / e, 0, 1 );
+  } else{
+    c = zVec3DInnerProd( &d0, &r );
+    if( e <= zTOL ){
+      t = 0;
+      s = zLimit( -c / a, 0, 1 );
+    } else{
+      b = zVec3DInnerProd( &d0, &d1 );
+      den = a * e - b * b;
+      s = den > zTOL ? zLimit( ( b * f - c * e ) / den, 0, 1 ) : 0;
+      if( ( t = ( b * s + f ) / e ) < 0 ){
+        t = 0;
+        s = zLimit( -c / a, 0, 1 );
+      } else
+      if( t > 1 ){
+        t = 1;
+        s = zLimit( ( b - c ) / a, 0, 1 );
+      }
+    }
+  }
+  zVec3DCat( p0, s, &d0, c0 );
+  zVec3DCat( p1, t, &d1, c1 );
+}
+
+/* closed-form test of spheres and capsules, namely, spheres swept along segments. */
+static bool _rkCDPrimSwept(rkCDPrim *p0, rkCDPrim *p1, zVec3D *n, zVec3D *w0, zVec3D *w1)
+{
+  zVec3D c0, c1;
+  double d;
+
+  _rkCDSegClosest( &p0->center[0], &p0->center[1], &p1->center[0], &p1->center[1], &c0, &c1 );
+  zVec3DSub( &c0, &c1, n );
+  if( zIsTiny( d = zVec3DNorm( n ) ) ) /* concentric */
+    zVec3DCopy( ZVEC3DZ, n );
+  else
+    zVec3DDivDRC( n, d );
+  zVec3DCat( &c0,-p0->radius, n, w0 );
+  zVec3DCat( &c1, p1->radius, n, w1 );
+  return d <= p0->radius + p1->radius;
+}
+
+/* signed distance from a point to a box, where the closest point on the
+   surface and the outward normal vector there are stored in q and n. */
+static double _rkCDPrimBoxDist(rkCDPrim *box, zVec3D *p, zVec3D *q, zVec3D *n)
+{
+  zVec3D d;
+  double l[3], dmin = HUGE_VAL, dist;
+  register int i;
+  int imin = zX;
+  bool inside = true;
+
+  zVec3DSub( p, &box->center[0], &d );
+  for( i=zX; i<=zZ; i++ ){
+    l[i] = zVec3DInnerProd( &d, &box->axis[i] );
+    if( l[i] > box->dia[i] ){
+      l[i] = box->dia[i];
+      inside = false;
+    } else
+    if( l[i] < -box->dia[i] ){
+      l[i] = -box->dia[i];
+      inside = false;
+    } else
+    if( box->dia[i] - fabs( l[i] ) < dmin ){
+      dmin = box->dia[i] - fabs( l[i] );
+      imin = i;
+    }
+  }
+  if( inside ) /* pushed out to the nearest face */
+    l[imin] = l[imin] >= 0 ? box->dia[imin] : -box->dia[imin];
+  zVec3DCopy( &box->center[0], q );
+  for( i=zX; i<=zZ; i++ )
+    zVec3DCatDRC( q, l[i], &box->axis[i] );
+  if( inside ){
+    zVec3DMul( &box->axis[imin], l[imin] >= 0 ? 1 : -1, n );
+    return -dmin;
+  }
+  zVec3DSub( p, q, n );
+  dist = zVec3DNorm( n );
+  zVec3DDivDRC( n, dist );
+  return dist;
+}
+
+/* signed distance from a point to a cylinder, where the closest point on
+   the surface and the outward normal vector there are stored in q and n. */
+static double _rkCDPrimCylDist(rkCDPrim *cyl, zVec3D *p, zVec3D *q, zVec3D *n)
+{
+  zVec3D a, d, r, tmp;
+  double len, t, rho, tq, rq, dist;
+
+  zVec3DSub( &cyl->center[1], &cyl->center[0], &a );
+  len = zVec3DNorm( &a );
+  zVec3DDivDRC( &a, len );
+  zVec3DSub( p, &cyl->center[0], &d );
+  t = zVec3DInnerProd( &d, &a );
+  zVec3DCat( &d, -t, &a, &r );
+  if( zIsTiny( rho = zVec3DNorm( &r ) ) ) /* on the axis */
+    zVec3DOrthoSpace( &a, &r, &tmp );
+  else
+    zVec3DDivDRC( &r, rho );
+  if( t >= 0 && t <= len && rho <= cyl->radius ){ /* pushed out to the nearest surface */
+    if( cyl->radius - rho <= t && cyl->radius - rho <= len - t ){
+      tq = t; rq = cyl->radius;
+      zVec3DCopy( &r, n );
+      dist = rho - cyl->radius;
+    } else
+    if( t <= len - t ){
+      tq = 0; rq = rho;
+      zVec3DRev( &a, n );
+      dist = -t;
+    } else{
+      tq = len; rq = rho;
+      zVec3DCopy( &a, n );
+      dist = t - len;
+    }
+    zVec3DCat( &cyl->center[0], tq, &a, q );
+    zVec3DCatDRC( q, rq, &r );
+    return dist;
+  }
+  zVec3DCat( &cyl->center[0], zLimit( t, 0, len ), &a, q );
+  zVec3DCatDRC( q, zMin( rho, cyl->radius ), &r );
+  zVec3DSub( p, q, n );
+  dist = zVec3DNorm( n );
+  zVec3DDivDRC( n, dist );
+  return dist;
+}
+
+/* closed-form test of a sphere and a box or a cylinder. */
+static bool _rkCDPrimSphereSolid(rkCDPrim *sphere, rkCDPrim *solid, zVec3D *n, zVec3D *ws, zVec3D *wo)
+{
+  double d;
+
+  d = solid->type == RK_CD_PRIM_BOX ?
+    _rkCDPrimBoxDist( solid, &sphere->center[0], wo, n ) :
+    _rkCDPrimCylDist( solid, &sphere->center[0], wo, n );
+  zVec3DCat( &sphere->center[0], -sphere->radius, n, ws );
+  return d <= sphere->radius;
+}
+
+/* test if an axis separates two boxes, and update the axis of the minimum overlap. */
+static bool _rkCDPrimBoxSAT(rkCDPrim *b0, rkCDPrim *b1, zVec3D *t, zVec3D *axis, int id, double *depth, int *minid, zVec3D *n)
+{
+  double r = 0, s, d;
+  register int i;
+
+  for( i=zX; i<=zZ; i++ )
+    r += b0->dia[i] * fabs( zVec3DInnerProd( &b0->axis[i], axis ) )
+       + b1->dia[i] * fabs( zVec3DInnerProd( &b1->axis[i], axis ) );
+  s = zVec3DInnerProd( t, axis );
+  if( ( d = r - fabs( s ) ) < 0 ) return false;
+  if( d < *depth ){
+    *depth = d;
+    *minid = id;
+    zVec3DMul( axis, s >= 0 ? 1 : -1, n );
+  }
+  return true;
+}
+
+/* the vertex of a box farthest along a direction. */
+static void _rkCDPrimBoxVert(rkCDPrim *b, zVec3D *dir, zVec3D *v)
+{
+  register int k;
+
+  zVec3DCopy( &b->center[0], v );
+  for( k=zX; k<=zZ; k++ )
+    zVec3DCatDRC( v, zVec3DInnerProd( &b->axis[k], dir ) > 0 ? b->dia[k] : -b->dia[k], &b->axis[k] );
+}
+
+/* the edge of a box along the i-th axis farthest along a direction. */
+static void _rkCDPrimBoxEdge(rkCDPrim *b, int i, zVec3D *dir, zVec3D *p, zVec3D *q)
+{
+  zVec3D c;
+  register int k;
+
+  zVec3DCopy( &b->center[0], &c );
+  for( k=zX; k<=zZ; k++ )
+    if( k != i )
+      zVec3DCatDRC( &c, zVec3DInnerProd( &b->axis[k], dir ) > 0 ? b->dia[k] : -b->dia[k], &b->axis[k] );
+  zVec3DCat( &c, b->dia[i], &b->axis[i], p );
+  zVec3DCat( &c,-b->dia[i], &b->axis[i], q );
+}
+
+/* closed-form test of two boxes by the separating axis theorem. */
+static bool _rkCDPrimBoxBox(rkCDPrim *b0, rkCDPrim *b1, zVec3D *n, zVec3D *w0, zVec3D *w1)
+{
+  zVec3D t, axis, p0, q0, p1, q1;
+  double depth = HUGE_VAL, l;
+  int minid = 0;
+  register int i, j;
+
+  /* axes are identified by 0-2 for faces of the former box, 3-5 for
+     faces of the latter, and 6-14 for pairs of edges */
+  zVec3DSub( &b0->center[0], &b1->center[0], &t );
+  for( i=zX; i<=zZ; i++ )
+    if( !_rkCDPrimBoxSAT( b0, b1, &t, &b0->axis[i], i, &depth, &minid, n ) ||
+        !_rkCDPrimBoxSAT( b0, b1, &t, &b1->axis[i], 3+i, &depth, &minid, n ) ) return false;
+  for( i=zX; i<=zZ; i++ )
+    for( j=zX; j<=zZ; j++ ){
+      zVec3DOuterProd( &b0->axis[i], &b1->axis[j], &axis );
+      if( ( l = zVec3DNorm( &axis ) ) < RK_CD_PRIM_EPS ) continue;
+      zVec3DDivDRC( &axis, l );
+      if( !_rkCDPrimBoxSAT( b0, b1, &t, &axis, 6+3*i+j, &depth, &minid, n ) ) return false;
+    }
+  zVec3DRev( n, &axis );
+  if( minid < 3 ){ /* the deepest vertex of the latter box on a face of the former */
+    _rkCDPrimBoxVert( b1, n, w1 );
+    zVec3DCat( w1, -depth, n, w0 );
+  } else
+  if( minid < 6 ){ /* the deepest vertex of the former box on a face of the latter */
+    _rkCDPrimBoxVert( b0, &axis, w0 );
+    zVec3DCat( w0, depth, n, w1 );
+  } else{ /* the closest points of the deepest edges */
+    _rkCDPrimBoxEdge( b0, ( minid - 6 ) / 3, &axis, &p0, &q0 );
+    _rkCDPrimBoxEdge( b1, ( minid - 6 ) % 3, n, &p1, &q1 );
+    _rkCDSegClosest( &p0, &q0, &p1, &q1, w0, w1 );
+  }
+  return true;
+}
+
+#define _rkCDPrimIsSwept(p) ( (p)->type == RK_CD_PRIM_SPHERE || (p)->type == RK_CD_PRIM_CAPSULE )
+#define _rkCDPrimIsSolid(p) ( (p)->type == RK_CD_PRIM_BOX || (p)->type == RK_CD_PRIM_CYLINDER )
+
+/* check if a pair of primitives collide by a closed-form test. The result
+   is stored in ret, and the false value is returned if no closed-form test
+   is available for the pair. The deepest points of the cells are stored in
+   the pair, and so is the normal vector from the latter to the former. */
+static bool _rkCDPairPrim(rkCDPair *cp, bool *ret)
+{
+  rkCDPrim p[2];
+  register int i;
+
+  for( i=0; i<2; i++ )
+    if( cp->data.cell[i]->data.prim.type == RK_CD_PRIM_NONE ) return false;
+  for( i=0; i<2; i++ )
+    _rkCDPrimXform( &cp->data.cell[i]->data.prim, rkLinkWldFrame(cp->data.cell[i]->data.link), &p[i] );
+  if( _rkCDPrimIsSwept( &p[0] ) && _rkCDPrimIsSwept( &p[1] ) )
+    *ret = _rkCDPrimSwept( &p[0], &p[1], &cp->data.norm, &cp->data.wit[0], &cp->data.wit[1] );
+  else
+  if( p[0].type == RK_CD_PRIM_SPHERE && _rkCDPrimIsSolid( &p[1] ) )
+    *ret = _rkCDPrimSphereSolid( &p[0], &p[1], &cp->data.norm, &cp->data.wit[0], &cp->data.wit[1] );
+  else
+  if( _rkCDPrimIsSolid( &p[0] ) && p[1].type == RK_CD_PRIM_SPHERE ){
+    *ret = _rkCDPrimSphereSolid( &p[1], &p[0], &cp->data.norm, &cp->data.wit[1], &cp->data.wit[0] );
+    zVec3DRevDRC( &cp->data.norm );
+  } else
+  if( p[0].type == RK_CD_PRIM_BOX && p[1].type == RK_CD_PRIM_BOX )
+    *ret = _rkCDPrimBoxBox( &p[0], &p[1], &cp->data.norm, &cp->data.wit[0], &cp->data.wit[1] );
+  else
+    return false;
+  return true;
+}
+
+/* check if a pair of cells collide by GJK algorithm, which is warm-started
+   from the separating direction at the previous query. Witness points on
+   the cells are stored in the pair in the world frame, which are support
+   points along the separating axis if the cells are apart. A pair of
+   primitives is checked by a closed-form test instead if available. */
+static bool _rkCDPairGJK(rkCDPair *cp, rkCDStat *stat)
+{
+  zPH3D *ph0, *ph1;
+  zFrame3D f;
+  zVec3D v, p0, p1;
+  bool warm, ret;
+
+  if( _rkCDPairPrim( cp, &ret ) ){
+    stat->prim_test++;
+    return ret;
+  }
+  ph0 = zShape3DPH(cp->data.cell[0]->data.shape);
+  ph1 = zShape3DPH(cp->data.cell[1]->data.shape);
+  if( zPH3DVertNum(ph0) == 0 || zPH3DVertNum(ph1) == 0 ) return false;
+  _rkCDCellRelFrame( cp->data.cell[0], cp->data.cell[1], &f );
+  stat->gjk_test++;
+  warm = !zVec3DIsTiny( &cp->data._sep );
+  ret = _rkCDGJK( ph0, &f, ph1, warm ? &cp->data._sep : NULL, false, &v, &p0, &p1 );
+  if( ret ) /* no separating direction */
+    zVec3DZero( &cp->data._sep );
+  else{
+    if( warm && zVec3DEqual( &v, &cp->data._sep ) ) stat->gjk_warm++;
+    zVec3DCopy( &v, &cp->data._sep );
+  }
+  zXform3D( rkLinkWldFrame(cp->data.cell[1]->data.link), &p0, &cp->data.wit[0] );
+  zXform3D( rkLinkWldFrame(cp->data.cell[1]->data.link), &p1, &cp->data.wit[1] );
+  return ret;
+}
+
+static int _rkCDColChkGJKPair(rkCD *cd, rkCDPair *cp, rkCDStat *stat)
+{
+  if( cp->data.is_col == true && !_rkCDPairGJK( cp, stat ) )
+    cp->data.is_col = false;
+  return 0;
+}
+
+static void _rkCDColChkGJK(rkCD *cd)
+{
+  _rkCDNarrowPhase( cd, _rkCDColChkGJKPair, false );
 }
 
 void rkCDColChkAABB(rkCD *cd)
 {
-  if( zListIsEmpty( &cd->plist ) ) return;
+  if( zListIsEmpty( &cd->clist ) ) return;
   rkCDReset( cd );
   _rkCDColChkAABB( cd );
 }
@@ -406,22 +2244,96 @@ void rkCDColChkGJK(rkCD *cd)
 void rkCDColChkGJKOnly(rkCD *cd)
 {
   rkCDPair *cp;
-  zVec3D v1, v2;
-
-  if( zListIsEmpty( &cd->plist ) ) return;
-  rkCDReset( cd );
+  register int k;
+
+  if( _rkCDHasDeferred( cd ) ){
+    rkCDReset( cd );
+    /* deferred pairs of overlapping cells are created in the broad phase */
+    _rkCDColChkAABB( cd );
+    for( k=0; k<cd->candnum; k++ )
+      cd->cand[k]->data.is_col = false;
+    cd->candnum = 0;
+  } else{
+    if( zListIsEmpty( &cd->plist ) ) return;
+    rkCDReset( cd );
+    if( !_rkCDSAPUpdate( cd ) ) return;
+  }
   zListForEach( &cd->plist, cp ){
-    /* TO BE MODIFIED */
-    rkCDCellUpdatePH( cp->data.cell[0] );
-    rkCDCellUpdatePH( cp->data.cell[1] );
-    if( zColChkPH3D( &cp->data.cell[0]->data.ph, &cp->data.cell[1]->data.ph, &v1, &v2 ) )
+    if( _rkCDPairGJK( cp, &cd->stat ) &&
+        _rkCDCandReserve( &cd->cand, &cd->_candsize, cd->candnum+1 ) ){
       cp->data.is_col = true;
+      cd->cand[cd->candnum++] = cp;
+    }
   }
 }
 
-static bool _rkCDVertNorm(zPH3D *ph, zVec3D *vert, zVec3D *norm, zVec3D *pro)
+/* check if the polyhedron of a cell in the world frame is that of the shape,
+   which is replaced by the bounding box in rkCDColChkOBBVert(). */
+static bool _rkCDCellPHIsShape(rkCDCell *cell)
+{
+  return zPH3DVertNum(&cell->data.ph) == zPH3DVertNum(zShape3DPH(cell->data.shape)) &&
+         zPH3DFaceNum(&cell->data.ph) == zPH3DFaceNum(zShape3DPH(cell->data.shape));
+}
+
+/* closest point on the surface of the polyhedron of a cell to a point, which
+   traverses the hierarchy of faces in the nearest-first order. The query is
+   done in the local frame, since the polyhedron in the world frame is not
+   necessarily updated. */
+static void _rkCDCellClosest(rkCDStat *stat, rkCDCell *cell, zVec3D *p, zVec3D *cp)
 {
-  zPH3DClosest( ph, vert, pro );
+  rkCDBVH *bvh;
+  rkCDBVHNode *node;
+  zPH3D *ph;
+  zVec3D pl, c, cl;
+  double d, dmin = HUGE_VAL;
+  int stack[RK_CD_BVH_STACK_SIZE], sp = 0, near;
+  register int i;
+
+  if( !_rkCDCellPHIsShape( cell ) ){ /* the bounding box updated in rkCDColChkOBBVert() */
+    stat->face_cand += zPH3DFaceNum(&cell->data.ph);
+    stat->face_test += zPH3DFaceNum(&cell->data.ph);
+    zPH3DClosest( &cell->data.ph, p, cp );
+    return;
+  }
+  bvh = &cell->data.fbvh;
+  ph = zShape3DPH(cell->data.shape);
+  stat->face_cand += zPH3DFaceNum(ph);
+  zXform3DInv( rkLinkWldFrame(cell->data.link), p, &pl );
+  zVec3DCopy( &pl, &cl );
+  if( bvh->nodenum > 0 )
+    stack[sp++] = 0;
+  else{
+    stat->face_test += zPH3DFaceNum(ph);
+    zPH3DClosest( ph, &pl, &cl );
+  }
+  while( sp > 0 ){
+    node = &bvh->node[stack[--sp]];
+    if( _rkCDBoxSqrDist( &node->box, &pl ) >= dmin ) continue;
+    if( node->child[0] < 0 || sp + 2 > RK_CD_BVH_STACK_SIZE ){
+      /* a leaf, or faces under a node too deep, which never happens for a balanced tree */
+      for( i=node->head; i<node->head+node->num; i++ ){
+        stat->face_test++;
+        zTri3DClosest( zPH3DFace(ph,bvh->idx[i]), &pl, &c );
+        zVec3DSubDRC( &c, &pl );
+        if( ( d = zVec3DSqrNorm( &c ) ) < dmin ){
+          dmin = d;
+          zVec3DAdd( &pl, &c, &cl );
+        }
+      }
+      continue;
+    }
+    /* the nearer child is popped first */
+    near = _rkCDBoxSqrDist( &bvh->node[node->child[0]].box, &pl ) <=
+           _rkCDBoxSqrDist( &bvh->node[node->child[1]].box, &pl ) ? 0 : 1;
+    stack[sp++] = node->child[1-near];
+    stack[sp++] = node->child[near];
+  }
+  zXform3D( rkLinkWldFrame(cell->data.link), &cl, cp );
+}
+
+static bool _rkCDVertNorm(rkCDStat *stat, rkCDCell *cell, zVec3D *vert, zVec3D *norm, zVec3D *pro)
+{
+  _rkCDCellClosest( stat, cell, vert, pro );
   zVec3DSub( pro, vert, norm );
   if( zVec3DIsTiny( norm ) ) return false;
   zVec3DNormalizeNCDRC( norm );
@@ -429,44 +2341,95 @@ static bool _rkCDVertNorm(zPH3D *ph, zVec3D *vert, zVec3D *norm, zVec3D *pro)
   return true;
 }
 
-static rkCDVert *_rkCDVertReg(rkCD *cd, rkCDPair *pair, rkCDVertList *vlist, rkCDCell *cell0, int v_id)
+/* hash of a contact vertex keyed by the cell in a pair and the identifier. */
+static int _rkCDVertHash(rkCDPair *pair, rkCDCell *cell, int id)
 {
-  rkCDVert *v, *cp;
-  zVec3D pro, sub, vert;
-  bool flag = false;
-  rkCDCell *cell1;
+  unsigned long key;
 
-  if( !( v = zAlloc( rkCDVert, 1 ) ) ){
-    ZALLOCERROR();
+  key = 2 * (unsigned long)id + ( cell == pair->data.cell[1] ? 1 : 0 );
+  return (int)( ( key * 2654435761UL ) & ( pair->data._histsize - 1 ) );
+}
+
+/* index contact vertices of a pair at the previous step by a hash table,
+   so that the history of each vertex is found in constant time. */
+static void _rkCDVertHistBuild(rkCDPair *pair)
+{
+  rkCDVert *v, **hist;
+  int size, h;
+
+  for( size=8; size<2*zListSize(&pair->data.vlist); size<<=1 );
+  if( size > pair->data._histcap ){
+    if( !( hist = zRealloc( pair->data._hist, rkCDVert*, size ) ) ){
+      ZALLOCERROR();
+      pair->data._histsize = 0; /* fall back to the linear search */
+      return;
+    }
+    pair->data._hist = hist;
+    pair->data._histcap = size;
+  }
+  pair->data._histsize = size;
+  memset( pair->data._hist, 0, sizeof(rkCDVert*)*size );
+  zListForEach( &pair->data.vlist, v ){
+    for( h=_rkCDVertHash( pair, v->data.cell, v->data._id ); pair->data._hist[h];
+         h=( h + 1 ) & ( size - 1 ) );
+    pair->data._hist[h] = v;
+  }
+}
+
+/* find a contact vertex of a pair at the previous step. */
+static rkCDVert *_rkCDVertHistFind(rkCDPair *pair, rkCDCell *cell, int id)
+{
+  rkCDVert *v;
+  int h;
+
+  if( pair->data._histsize == 0 ){
+    zListForEach( &pair->data.vlist, v )
+      if( v->data.cell == cell && v->data._id == id ) return v;
     return NULL;
   }
+  for( h=_rkCDVertHash( pair, cell, id ); ( v = pair->data._hist[h] );
+       h=( h + 1 ) & ( pair->data._histsize - 1 ) )
+    if( v->data.cell == cell && v->data._id == id ) return v;
+  return NULL;
+}
+
+static rkCDVert *_rkCDVertReg(rkCD *cd, rkCDStat *stat, rkCDPair *pair, rkCDVertList *vlist, rkCDCell *cell0, int v_id, zVec3D *vert)
+{
+  rkCDVert *v, *cp;
+  zVec3D pro, sub, lvert;
+  rkCDCell *cell1;
+
+  if( !( v = _rkCDVertAlloc( cd, pair ) ) ) return NULL;
   cell1 = pair->data.cell[ pair->data.cell[0] == cell0 ? 1 : 0 ];
   v->data.cell = cell0;
-  v->data.vert = zPH3DVert(&cell0->data.ph,v_id);
-
-  zListForEach( &pair->data.vlist, cp )
-    if( cp->data.vert == zPH3DVert(&cell0->data.ph,v_id) ){
-      zVec3DCopy( &cp->data._ref, &v->data._ref );
-      zVec3DCopy( &cp->data._norm, &v->data._norm );
-      zVec3DCopy( &cp->data._axis[0], &v->data._axis[0] );
-      zVec3DCopy( &cp->data._axis[1], &v->data._axis[1] );
-      zVec3DCopy( &cp->data._axis[2], &v->data._axis[2] );
-      zXform3DInv( rkLinkWldFrame(cell1->data.link), zPH3DVert(&cell0->data.ph, v_id), &vert );
-      zVec3DSub( &cp->data._pro, &vert, &sub );
-      zVec3DProj( &sub, &v->data._norm, &pro );
-      zVec3DAdd( &vert, &pro, &v->data._pro );
-      zMulMat3DVec3D( rkLinkWldAtt(cell1->data.link), &v->data._norm, &v->data.norm );
-      zXform3D( rkLinkWldFrame(cell1->data.link), &v->data._pro, &v->data.pro );
-      zXform3D( rkLinkWldFrame(cell1->data.link), &v->data._ref, &v->data.ref );
-      zXform3D( rkLinkWldFrame(cell1->data.link), &v->data._axis[0], &v->data.axis[0] );
-      zXform3D( rkLinkWldFrame(cell1->data.link), &v->data._axis[1], &v->data.axis[1] );
-      zXform3D( rkLinkWldFrame(cell1->data.link), &v->data._axis[2], &v->data.axis[2] );
-      v->data.type = cp->data.type;
-      flag = true;
-    }
-  if( zListIsEmpty( &pair->data.vlist ) || flag == false ){
-    if( !_rkCDVertNorm( &cell1->data.ph, zPH3DVert(&cell0->data.ph, v_id), &v->data.norm, &v->data.pro ) ){
-      zFree( v );
+  v->data._id = v_id;
+  zVec3DCopy( vert, &v->data._vert );
+  v->data.vert = &v->data._vert;
+  /* a recycled vertex may hold values of the previous step */
+  zVec3DZero( &v->data.f );
+  zVec3DZero( &v->data.dir );
+  zVec3DZero( &v->data.vel );
+
+  if( ( cp = _rkCDVertHistFind( pair, cell0, v_id ) ) ){
+    zVec3DCopy( &cp->data._ref, &v->data._ref );
+    zVec3DCopy( &cp->data._norm, &v->data._norm );
+    zVec3DCopy( &cp->data._axis[0], &v->data._axis[0] );
+    zVec3DCopy( &cp->data._axis[1], &v->data._axis[1] );
+    zVec3DCopy( &cp->data._axis[2], &v->data._axis[2] );
+    zXform3DInv( rkLinkWldFrame(cell1->data.link), vert, &lvert );
+    zVec3DSub( &cp->data._pro, &lvert, &sub );
+    zVec3DProj( &sub, &v->data._norm, &pro );
+    zVec3DAdd( &lvert, &pro, &v->data._pro );
+    zMulMat3DVec3D( rkLinkWldAtt(cell1->data.link), &v->data._norm, &v->data.norm );
+    zXform3D( rkLinkWldFrame(cell1->data.link), &v->data._pro, &v->data.pro );
+    zXform3D( rkLinkWldFrame(cell1->data.link), &v->data._ref, &v->data.ref );
+    zXform3D( rkLinkWldFrame(cell1->data.link), &v->data._axis[0], &v->data.axis[0] );
+    zXform3D( rkLinkWldFrame(cell1->data.link), &v->data._axis[1], &v->data.axis[1] );
+    zXform3D( rkLinkWldFrame(cell1->data.link), &v->data._axis[2], &v->data.axis[2] );
+    v->data.type = cp->data.type;
+  } else{
+    if( !_rkCDVertNorm( stat, cell1, vert, &v->data.norm, &v->data.pro ) ){
+      zListInsertHead( &pair->data._vspare, v );
       return NULL;
     }
     zVec3DCopy( &v->data.pro, &v->data.ref );
@@ -484,24 +2447,98 @@ static rkCDVert *_rkCDVertReg(rkCD *cd, rkCDPair *pair, rkCDVertList *vlist, rkC
   return v;
 }
 
-static int _rkCDPairColChkVert(rkCD *cd, rkCDPair *cp)
+static int _rkCDIdxCmp(const void *p1, const void *p2)
 {
-  rkCDVertList temp;
+  return *(const int *)p1 - *(const int *)p2;
+}
+
+/* check vertices of a cell in a pair inside the other, culling those out of
+   the overlap region of bounding boxes with the hierarchy of vertices. Only
+   the remaining vertices are transformed to the frame of the other cell. */
+static int _rkCDPairColChkVertCell(rkCD *cd, rkCDStat *stat, rkCDPair *cp, rkCDVertList *vlist, int s, zAABox3D *region)
+{
+  rkCDCell *cell0, *cell1;
+  rkCDBVH *bvh;
+  rkCDBVHNode *node;
+  zPH3D *ph0, *ph1;
+  zFrame3D f;
+  zAABox3D lbox;
+  zVec3D vert, lvert;
+  int stack[RK_CD_BVH_STACK_SIZE], sp = 0, *vid, vnum = 0;
   register int i;
   int ret = 0;
 
-  zListInit( &temp );
-  for( i=0; i<zPH3DVertNum(&cp->data.cell[0]->data.ph); i++ )
-    if( zPH3DPointIsInside( &cp->data.cell[1]->data.ph, zPH3DVert(&cp->data.cell[0]->data.ph,i), false ) ){
-      if( _rkCDVertReg( cd, cp, &temp, cp->data.cell[0], i ) )
-        ret++;
+  cell0 = cp->data.cell[s];
+  cell1 = cp->data.cell[1-s];
+  bvh = &cell0->data.vbvh;
+  ph0 = zShape3DPH(cell0->data.shape);
+  ph1 = zShape3DPH(cell1->data.shape);
+  stat->vert_cand += zPH3DVertNum(ph0);
+  if( zPH3DVertNum(ph0) == 0 ) return 0;
+  if( zPH3DVertNum(ph0) > cp->data._idxsize ){
+    if( !( vid = zRealloc( cp->data._idx, int, zPH3DVertNum(ph0) ) ) ){
+      ZALLOCERROR();
+      return 0;
     }
-  for( i=0; i<zPH3DVertNum(&cp->data.cell[1]->data.ph); i++ )
-    if( zPH3DPointIsInside( &cp->data.cell[0]->data.ph, zPH3DVert(&cp->data.cell[1]->data.ph,i), false ) ){
-      if( _rkCDVertReg( cd, cp, &temp, cp->data.cell[1], i ) )
+    cp->data._idx = vid;
+    cp->data._idxsize = zPH3DVertNum(ph0);
+  }
+  vid = cp->data._idx;
+  /* vertices inside the other cell have to be in the overlap region */
+  _rkCDBoxXformInv( region, rkLinkWldFrame(cell0->data.link), &lbox );
+  if( bvh->nodenum > 0 )
+    stack[sp++] = 0;
+  else
+    for( i=0; i<zPH3DVertNum(ph0); i++ )
+      if( _rkCDBoxPointIsInside( &lbox, zPH3DVert(ph0,i) ) )
+        vid[vnum++] = i;
+  while( sp > 0 ){
+    node = &bvh->node[stack[--sp]];
+    if( !zColChkAABox3D( &node->box, &lbox ) ) continue;
+    if( node->child[0] >= 0 && sp + 2 <= RK_CD_BVH_STACK_SIZE ){
+      stack[sp++] = node->child[1];
+      stack[sp++] = node->child[0];
+      continue;
+    }
+    for( i=node->head; i<node->head+node->num; i++ )
+      if( _rkCDBoxPointIsInside( &lbox, zPH3DVert(ph0,bvh->idx[i]) ) )
+        vid[vnum++] = bvh->idx[i];
+  }
+  /* keep the order of vertices */
+  qsort( vid, vnum, sizeof(int), _rkCDIdxCmp );
+  stat->vert_test += vnum;
+  _rkCDCellRelFrame( cell0, cell1, &f );
+  for( i=0; i<vnum; i++ ){
+    zXform3D( &f, zPH3DVert(ph0,vid[i]), &lvert );
+    if( zPH3DPointIsInside( ph1, &lvert, false ) ){
+      zXform3D( rkLinkWldFrame(cell0->data.link), zPH3DVert(ph0,vid[i]), &vert );
+      if( _rkCDVertReg( cd, stat, cp, vlist, cell0, vid[i], &vert ) )
         ret++;
     }
-  zListDestroy( rkCDVert, &cp->data.vlist );
+  }
+  return ret;
+}
+
+static int _rkCDPairColChkVert(rkCD *cd, rkCDPair *cp, rkCDStat *stat)
+{
+  rkCDVertList temp;
+  zAABox3D region;
+  register int i;
+  int ret = 0;
+
+  zListInit( &temp );
+  /* overlap region of bounding boxes */
+  for( i=zX; i<=zZ; i++ ){
+    region.min.e[i] = zMax( cp->data.cell[0]->data.aabb.min.e[i], cp->data.cell[1]->data.aabb.min.e[i] );
+    region.max.e[i] = zMin( cp->data.cell[0]->data.aabb.max.e[i], cp->data.cell[1]->data.aabb.max.e[i] );
+    /* margin for round-off errors of bounding boxes */
+    region.min.e[i] -= zTOL;
+    region.max.e[i] += zTOL;
+  }
+  _rkCDVertHistBuild( cp );
+  ret += _rkCDPairColChkVertCell( cd, stat, cp, &temp, 0, &region );
+  ret += _rkCDPairColChkVertCell( cd, stat, cp, &temp, 1, &region );
+  _rkCDVertListRelease( &cp->data.vlist, &cp->data._vspare );
   zListMove( &temp, &cp->data.vlist );
   if( zListIsEmpty( &cp->data.vlist ) )
     cp->data.is_col = false;
@@ -509,22 +2546,17 @@ static int _rkCDPairColChkVert(rkCD *cd, rkCDPair *cp)
   return ret;
 }
 
-static void _rkCDColChkVert(rkCD *cd)
+static int _rkCDColChkVertPair(rkCD *cd, rkCDPair *cp, rkCDStat *stat)
 {
-  rkCDPair *cp;
+  if( cp->data.is_col == true )
+    return _rkCDPairColChkVert( cd, cp, stat );
+  _rkCDVertListRelease( &cp->data.vlist, &cp->data._vspare );
+  return 0;
+}
 
-  cd->colnum = 0;
-  zListForEach( &cd->plist, cp ){
-    if( cp->data.is_col == true ){
-      /* TO BE MODIFIED */
-      rkCDCellUpdatePH( cp->data.cell[0] );
-      rkCDCellUpdatePH( cp->data.cell[1] );
-      cd->colnum += _rkCDPairColChkVert( cd, cp );
-    } else{
-      if( !zListIsEmpty( &cp->data.vlist ) )
-        zListDestroy( rkCDVert, &cp->data.vlist );
-    }
-  }
+static void _rkCDColChkVert(rkCD *cd)
+{
+  _rkCDNarrowPhase( cd, _rkCDColChkVertPair, true );
 }
 
 void rkCDColChkVert(rkCD *cd)
@@ -537,34 +2569,34 @@ static void _rkCDColChkOBBVert(rkCD *cd)
 {
   rkCDPair *cp;
   rkCDVertList temp;
-  register int i;
+  register int i, k;
 
   cd->colnum = 0;
-  zListForEach( &cd->plist, cp ){
+  for( k=0; k<cd->candnum; k++ ){
+    cp = cd->cand[k];
     if( cp->data.is_col == true ){
       zPH3DDestroy( &cp->data.cell[0]->data.ph );
       zPH3DDestroy( &cp->data.cell[1]->data.ph );
       zBox3DToPH( &cp->data.cell[0]->data.obb, &cp->data.cell[0]->data.ph );
       zBox3DToPH( &cp->data.cell[1]->data.obb, &cp->data.cell[1]->data.ph );
       zListInit( &temp );
+      _rkCDVertHistBuild( cp );
       for( i=0; i<zPH3DVertNum(&cp->data.cell[0]->data.ph); i++ )
         if( zPH3DPointIsInside( &cp->data.cell[1]->data.ph, zPH3DVert(&cp->data.cell[0]->data.ph,i), false ) ){
-          _rkCDVertReg( cd, cp, &temp, cp->data.cell[0], i );
+          _rkCDVertReg( cd, &cd->stat, cp, &temp, cp->data.cell[0], i, zPH3DVert(&cp->data.cell[0]->data.ph,i) );
           cd->colnum++;
         }
       for( i=0; i<zPH3DVertNum(&cp->data.cell[1]->data.ph); i++ )
         if( zPH3DPointIsInside( &cp->data.cell[0]->data.ph, zPH3DVert(&cp->data.cell[1]->data.ph,i), false ) ){
-          _rkCDVertReg( cd, cp, &temp, cp->data.cell[1], i );
+          _rkCDVertReg( cd, &cd->stat, cp, &temp, cp->data.cell[1], i, zPH3DVert(&cp->data.cell[1]->data.ph,i) );
           cd->colnum++;
         }
-      zListDestroy( rkCDVert, &cp->data.vlist );
+      _rkCDVertListRelease( &cp->data.vlist, &cp->data._vspare );
       zListMove( &temp, &cp->data.vlist );
       if( zListIsEmpty( &cp->data.vlist ) )
         cp->data.is_col = false;
-    } else{
-      if( !zListIsEmpty( &cp->data.vlist ) )
-        zListDestroy( rkCDVert, &cp->data.vlist );
-    }
+    } else
+      _rkCDVertListRelease( &cp->data.vlist, &cp->data._vspare );
   }
 }
 
@@ -574,27 +2606,25 @@ void rkCDColChkOBBVert(rkCD *cd)
   _rkCDColChkOBBVert( cd );
 }
 
-static void _rkCDColVol(rkCD *cd)
+static int _rkCDColVolPair(rkCD *cd, rkCDPair *cp, rkCDStat *stat)
 {
-  rkCDPair *cp;
+  if( cp->data.is_col == false ) return 0;
+  if( !zIntersectPH3D( &cp->data.cell[0]->data.ph, &cp->data.cell[1]->data.ph, &cp->data.colvol ) ){
+    cp->data.is_col = false;
+    return 0;
+  }
+  /* axis */
+  zVec3DCopy( &cp->data.norm ,&cp->data.axis[0] );
+  zVec3DOrthoSpace( &cp->data.axis[0], &cp->data.axis[1], &cp->data.axis[2] );
+  /* center */
+  zPH3DBarycenter( &cp->data.colvol, &cp->data.center );
+  return 1;
+}
 
-  cd->colnum = 0;
-  zListForEach( &cd->plist, cp )
-    if( cp->data.is_col == true ){
-      /* TO BE MODIFIED */
-      rkCDCellUpdatePH( cp->data.cell[0] );
-      rkCDCellUpdatePH( cp->data.cell[1] );
-      if( !zIntersectPH3D( &cp->data.cell[0]->data.ph, &cp->data.cell[1]->data.ph, &cp->data.colvol ) )
-        cp->data.is_col = false;
-      else{
-        cd->colnum++;
-        /* axis */
-        zVec3DCopy( &cp->data.norm ,&cp->data.axis[0] );
-        zVec3DOrthoSpace( &cp->data.axis[0], &cp->data.axis[1], &cp->data.axis[2] );
-        /* center */
-        zPH3DBarycenter( &cp->data.colvol, &cp->data.center );
-      }
-    }
+static void _rkCDColVol(rkCD *cd)
+{
+  _rkCDCandUpdatePH( cd, false );
+  _rkCDNarrowPhase( cd, _rkCDColVolPair, true );
 }
 
 void rkCDColVol(rkCD *cd)
@@ -696,55 +2726,53 @@ static int _rkCDPairColVolBREP(rkCDPair *cp)
   return ret;
 }
 
-static void _rkCDColVolBREP(rkCD *cd)
+static int _rkCDColVolBREPPair(rkCD *cd, rkCDPair *cp, rkCDStat *stat)
 {
-  rkCDPair *cp;
+  return cp->data.is_col == true ? _rkCDPairColVolBREP( cp ) : 0;
+}
 
-  cd->colnum = 0;
-  zListForEach( &cd->plist, cp )
-    if( cp->data.is_col == true ){
-      /* TO BE MODIFIED */
-      rkCDCellUpdatePH( cp->data.cell[0] );
-      rkCDCellUpdatePH( cp->data.cell[1] );
-      cd->colnum += _rkCDPairColVolBREP( cp );
-    }
+static void _rkCDColVolBREP(rkCD *cd)
+{
+  _rkCDCandUpdatePH( cd, false );
+  _rkCDNarrowPhase( cd, _rkCDColVolBREPPair, true );
 }
 
-static void _rkCDColVolBREPFast(rkCD *cd)
+static int _rkCDColVolBREPFastPair(rkCD *cd, rkCDPair *cp, rkCDStat *stat)
 {
-  rkCDPair *cp;
   zBREP brep[2];
   zAABox3D ib;
+  int ret = 0;
 
-  cd->colnum = 0;
-  zListForEach( &cd->plist, cp )
-    if( cp->data.is_col == true ){
-      /* TO BE MODIFIED */
-      rkCDCellUpdatePH( cp->data.cell[0] );
-      rkCDCellUpdatePH( cp->data.cell[1] );
-      if( !zIntersectPH3DBox( &cp->data.cell[0]->data.ph, &cp->data.cell[1]->data.ph, &ib ) ||
-          !zPH3D2BREPInBox( &cp->data.cell[0]->data.ph, &ib, &brep[0] ) ||
-          !zPH3D2BREPInBox( &cp->data.cell[1]->data.ph, &ib, &brep[1] ) ||
-          !zBREPTruncPH3D( &brep[0], &cp->data.cell[1]->data.ph ) ||
-          !zBREPTruncPH3D( &brep[1], &cp->data.cell[0]->data.ph ) ||
-          ( zListIsEmpty(&brep[0].vlist) && zListIsEmpty(&brep[1].vlist) ) ){
-        cp->data.is_col = false;
-        goto CONTINUE;
-      }
-      cd->colnum++;
-      /* norm */
-      _rkCDIntegrationNormBREP( &brep[0], &brep[1], &cp->data.norm );
-      /* merge */
-      _rkCDBREPMergeCH( &brep[0], &brep[1], &cp->data.colvol );
-      /* axis */
-      zVec3DCopy( &cp->data.norm ,&cp->data.axis[0] );
-      zVec3DOrthoSpace( &cp->data.axis[0], &cp->data.axis[1], &cp->data.axis[2] );
-      /* center */
-      zPH3DBarycenter( &cp->data.colvol, &cp->data.center );
-     CONTINUE:
-      zBREPDestroy( &brep[0] );
-      zBREPDestroy( &brep[1] );
-    }
+  if( cp->data.is_col == false ) return 0;
+  if( !zIntersectPH3DBox( &cp->data.cell[0]->data.ph, &cp->data.cell[1]->data.ph, &ib ) ||
+      !zPH3D2BREPInBox( &cp->data.cell[0]->data.ph, &ib, &brep[0] ) ||
+      !zPH3D2BREPInBox( &cp->data.cell[1]->data.ph, &ib, &brep[1] ) ||
+      !zBREPTruncPH3D( &brep[0], &cp->data.cell[1]->data.ph ) ||
+      !zBREPTruncPH3D( &brep[1], &cp->data.cell[0]->data.ph ) ||
+      ( zListIsEmpty(&brep[0].vlist) && zListIsEmpty(&brep[1].vlist) ) ){
+    cp->data.is_col = false;
+    goto CONTINUE;
+  }
+  ret++;
+  /* norm */
+  _rkCDIntegrationNormBREP( &brep[0], &brep[1], &cp->data.norm );
+  /* merge */
+  _rkCDBREPMergeCH( &brep[0], &brep[1], &cp->data.colvol );
+  /* axis */
+  zVec3DCopy( &cp->data.norm ,&cp->data.axis[0] );
+  zVec3DOrthoSpace( &cp->data.axis[0], &cp->data.axis[1], &cp->data.axis[2] );
+  /* center */
+  zPH3DBarycenter( &cp->data.colvol, &cp->data.center );
+ CONTINUE:
+  zBREPDestroy( &brep[0] );
+  zBREPDestroy( &brep[1] );
+  return ret;
+}
+
+static void _rkCDColVolBREPFast(rkCD *cd)
+{
+  _rkCDCandUpdatePH( cd, false );
+  _rkCDNarrowPhase( cd, _rkCDColVolBREPFastPair, true );
 }
 
 void rkCDColVolBREP(rkCD *cd)
@@ -759,25 +2787,19 @@ void rkCDColVolBREPFast(rkCD *cd)
   _rkCDColVolBREPFast( cd );
 }
 
-static void _rkCDColVolBREPVert(rkCD *cd)
+static int _rkCDColVolBREPVertPair(rkCD *cd, rkCDPair *cp, rkCDStat *stat)
 {
-  rkCDPair *cp;
+  if( cp->data.is_col == true )
+    return _rkCDPairIsRigid( cp ) ?
+      _rkCDPairColVolBREP( cp ) : _rkCDPairColChkVert( cd, cp, stat );
+  _rkCDVertListRelease( &cp->data.vlist, &cp->data._vspare );
+  return 0;
+}
 
-  cd->colnum = 0;
-  zListForEach( &cd->plist, cp ){
-    if( cp->data.is_col == true ){
-      /* TO BE MODIFIED */
-      rkCDCellUpdatePH( cp->data.cell[0] );
-      rkCDCellUpdatePH( cp->data.cell[1] );
-      if( cp->data.ci && rkContactInfoType(cp->data.ci) == RK_CONTACT_RIGID )
-        cd->colnum += _rkCDPairColVolBREP( cp );
-      else
-        cd->colnum += _rkCDPairColChkVert( cd, cp );
-    } else {
-      if( !zListIsEmpty( &cp->data.vlist ) )
-        zListDestroy( rkCDVert, &cp->data.vlist );
-    }
-  }
+static void _rkCDColVolBREPVert(rkCD *cd)
+{
+  _rkCDCandUpdatePH( cd, true );
+  _rkCDNarrowPhase( cd, _rkCDColVolBREPVertPair, true );
 }
 
 void rkCDColVolBREPVert(rkCD *cd)
@@ -786,5 +2808,126 @@ void rkCDColVolBREPVert(rkCD *cd)
   _rkCDColVolBREPVert( cd );
 }
 
+/* maximum number of iterations of the conservative advancement */
+#define RK_CD_TOI_ITER_MAX 100
+
+/* radius of a cell about the origin of the link frame. */
+static double _rkCDCellRadius(rkCDCell *cell)
+{
+  zPH3D *ph;
+  zAABox3D *box;
+  double r, rmax = 0;
+  register int i, j;
+
+  if( cell->data.vbvh.nodenum > 0 ){
+    box = &cell->data.vbvh.node[0].box;
+    for( i=zX; i<=zZ; i++ ){
+      r = zMax( fabs( box->min.e[i] ), fabs( box->max.e[i] ) );
+      rmax += r*r;
+    }
+    return sqrt( rmax );
+  }
+  ph = zShape3DPH(cell->data.shape);
+  for( j=0; j<zPH3DVertNum(ph); j++ )
+    if( ( r = zVec3DSqrNorm( zPH3DVert(ph,j) ) ) > rmax ) rmax = r;
+  return sqrt( rmax );
+}
+
+/* interpolate frames, where the attitude rotates about a fixed axis. */
+static void _rkCDFrameInterp(zFrame3D *fs, zFrame3D *fe, zVec3D *aa, double t, zFrame3D *f)
+{
+  zVec3D a;
+  zMat3D m;
+
+  zVec3DInterDiv( zFrame3DPos(fs), zFrame3DPos(fe), t, zFrame3DPos(f) );
+  zVec3DMul( aa, t, &a );
+  zMat3DFromAA( &m, &a );
+  zMulMat3DMat3D( &m, zFrame3DAtt(fs), zFrame3DAtt(f) );
+}
+
+/* time of impact of a pair of collision detection cells. */
+bool rkCDPairTOI(rkCDPair *pair, zFrame3D *fs0, zFrame3D *fe0, zFrame3D *fs1, zFrame3D *fe1, double tol, double *toi)
+{
+  zPH3D *ph0, *ph1;
+  zFrame3D f0, f1, f;
+  zVec3D aa0, aa1, dp, v, u, p0, p1;
+  double w, d, bound, t = 0;
+  int iter;
+
+  ph0 = zShape3DPH(pair->data.cell[0]->data.shape);
+  ph1 = zShape3DPH(pair->data.cell[1]->data.shape);
+  if( zPH3DVertNum(ph0) == 0 || zPH3DVertNum(ph1) == 0 ) return false;
+  /* rotations and the relative translation in the normalized time */
+  zMat3DError( zFrame3DAtt(fe0), zFrame3DAtt(fs0), &aa0 );
+  zMat3DError( zFrame3DAtt(fe1), zFrame3DAtt(fs1), &aa1 );
+  zVec3DSub( zFrame3DPos(fe0), zFrame3DPos(fs0), &dp );
+  zVec3DSub( zFrame3DPos(fe1), zFrame3DPos(fs1), &v );
+  zVec3DSubDRC( &dp, &v );
+  /* upper bound of the speed of points due to rotations */
+  w = zVec3DNorm( &aa0 ) * _rkCDCellRadius( pair->data.cell[0] )
+    + zVec3DNorm( &aa1 ) * _rkCDCellRadius( pair->data.cell[1] );
+  /* a hit is reported at the last time if the distance does not converge */
+  for( iter=0; iter<RK_CD_TOI_ITER_MAX; iter++ ){
+    _rkCDFrameInterp( fs0, fe0, &aa0, t, &f0 );
+    _rkCDFrameInterp( fs1, fe1, &aa1, t, &f1 );
+    _rkCDRelFrame( &f0, &f1, &f );
+    if( _rkCDGJK( ph0, &f, ph1, NULL, true, &v, &p0, &p1 ) ||
+        ( d = zVec3DNorm( &v ) ) <= tol ) break;
+    /* the distance never decreases faster than the approaching speed
+       along the direction from the latter cell to the former */
+    zMulMat3DVec3D( zFrame3DAtt(&f1), &v, &u );
+    bound = w - zVec3DInnerProd( &dp, &u ) / d;
+    if( bound <= 0 || ( t += d / bound ) > 1 ) return false;
+  }
+  *toi = t;
+  return true;
+}
+
+/* continuous collision check over swept volumes of cells. */
+double rkCDColChkTOI(rkCD *cd, double tol)
+{
+  rkCDCell *cell;
+  rkCDPair *cp;
+  zAABox3D box;
+  double toi = 1.0;
+  register int k;
+
+  cd->colnum = 0;
+  if( zListIsEmpty( &cd->clist ) ) return toi;
+  zListForEach( &cd->plist, cp )
+    cp->data.toi = 1.0;
+  /* results of the previous discrete check are reset, so that it has to be done after this */
+  rkCDReset( cd );
+  /* bounding boxes swept from the previous posture */
+  zListForEach( &cd->clist, cell ){
+    rkCDCellUpdateBB( cell );
+    box = cell->data.aabb;
+    _rkCDBoxMerge( &cell->data.aabb, &cell->data._aabb0 );
+    cell->data._aabb0 = box;
+  }
+  _rkCDColChkAABB( cd );
+  /* restore bounding boxes at the current posture */
+  zListForEach( &cd->clist, cell )
+    cell->data.aabb = cell->data._aabb0;
+  for( k=0; k<cd->candnum; k++ ){
+    cp = cd->cand[k];
+    if( !cp->data.is_col ) continue;
+    /* the flag is used only in the broad phase, and the hit is reported by toi */
+    cp->data.is_col = false;
+    if( !rkCDPairTOI( cp,
+          &cp->data.cell[0]->data._f0, rkLinkWldFrame(cp->data.cell[0]->data.link),
+          &cp->data.cell[1]->data._f0, rkLinkWldFrame(cp->data.cell[1]->data.link),
+          tol, &cp->data.toi ) ){
+      cp->data.toi = 1.0;
+      continue;
+    }
+    cd->colnum++;
+    if( cp->data.toi < toi ) toi = cp->data.toi;
+  }
+  zListForEach( &cd->clist, cell )
+    zFrame3DCopy( rkLinkWldFrame(cell->data.link), &cell->data._f0 );
+  return toi;
+}
+
 /* for fd */
 zListQuickSortDef( rkCDPlaneList, rkCDPlane )
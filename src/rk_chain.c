@@ -430,6 +430,31 @@ void rkChainID(rkChain *c, zVec vel, zVec acc)
   rkChainUpdateID( c );
 }
 
+/* update link states and joint torques of a kinematic chain via selective inverse dynamics. */
+void rkChainUpdateIDSelect(rkChain *c, int flag)
+{
+  if( flag & RK_ID_GRAVITY )
+    rkLinkUpdateRateStatic( rkChainRoot(c), RK_GRAVITY6D );
+  else
+    rkChainUpdateRate( c );
+  if( flag & RK_ID_ROOTWRENCH )
+    rkLinkUpdateWrenchNoTrq( rkChainRoot(c) );
+  else
+    rkChainUpdateWrench( c );
+  if( !( flag & RK_ID_NOCOM ) ){
+    rkChainUpdateCOMVel( c );
+    rkChainUpdateCOMAcc( c );
+  }
+}
+
+/* solve selective inverse dynamics of a kinematic chain. */
+void rkChainIDSelect(rkChain *c, zVec vel, zVec acc, int flag)
+{
+  if( !( flag & RK_ID_GRAVITY ) )
+    rkChainSetJointRateAll( c, vel, acc );
+  rkChainUpdateIDSelect( c, flag );
+}
+
 /* continuously update joint displacements of a kinematic chain over a time step. */
 void rkChainFKCNT(rkChain *c, zVec dis, double dt)
 {
@@ -595,6 +620,205 @@ bool rkChainInertiaMatBiasVec(rkChain *chain, zMat inertia, zVec bias)
   return true;
 }
 
+/* Coriolis matrix of a kinematic chain.
+ * Motion and force vectors are with respect to the world frame about its origin. */
+
+/* cross product of two motion vectors. */
+static zVec6D *_rkCoriolisMotionCross(zVec6D *v, zVec6D *m, zVec6D *c)
+{
+  zVec3D tmp;
+
+  zVec3DOuterProd( zVec6DAng(v), zVec6DLin(m), zVec6DLin(c) );
+  zVec3DOuterProd( zVec6DLin(v), zVec6DAng(m), &tmp );
+  zVec3DAddDRC( zVec6DLin(c), &tmp );
+  zVec3DOuterProd( zVec6DAng(v), zVec6DAng(m), zVec6DAng(c) );
+  return c;
+}
+
+/* cross product of a motion vector and a force vector. */
+static zVec6D *_rkCoriolisForceCross(zVec6D *v, zVec6D *f, zVec6D *c)
+{
+  zVec3D tmp;
+
+  zVec3DOuterProd( zVec6DAng(v), zVec6DLin(f), zVec6DLin(c) );
+  zVec3DOuterProd( zVec6DAng(v), zVec6DAng(f), zVec6DAng(c) );
+  zVec3DOuterProd( zVec6DLin(v), zVec6DLin(f), &tmp );
+  zVec3DAddDRC( zVec6DAng(c), &tmp );
+  return c;
+}
+
+/* momentum of a rigid body with mass m, center of mass pc and inertia tensor ic about it. */
+static zVec6D *_rkCoriolisMomentum(double m, zVec3D *pc, zMat3D *ic, zVec6D *v, zVec6D *h)
+{
+  zVec3D tmp;
+
+  zVec3DOuterProd( zVec6DAng(v), pc, &tmp );
+  zVec3DAddDRC( &tmp, zVec6DLin(v) );
+  zVec3DMul( &tmp, m, zVec6DLin(h) );
+  zMulMat3DVec3D( ic, zVec6DAng(v), zVec6DAng(h) );
+  zVec3DOuterProd( pc, zVec6DLin(h), &tmp );
+  zVec3DAddDRC( zVec6DAng(h), &tmp );
+  return h;
+}
+
+/* add spatial inertia and Coriolis factor of a link to 6x6 row-major matrices. */
+static void _rkCoriolisAddLinkInertia(rkLink *link, zVec6D *v, double *ic, double *bc)
+{
+  zVec3D pc;
+  zMat3D i;
+  zVec6D u, hu, hv, vu, t1, t2;
+  register int j, k;
+
+  zXform3D( rkLinkWldFrame(link), rkLinkCOM(link), &pc );
+  rkLinkWldInertia( link, &i );
+  _rkCoriolisMomentum( rkLinkMass(link), &pc, &i, v, &hv );
+  for( k=0; k<6; k++ ){
+    zVec6DZero( &u );
+    u.e[k] = 1;
+    _rkCoriolisMomentum( rkLinkMass(link), &pc, &i, &u, &hu );
+    /* B u = ( v x* I u + u x* I v - I v x u ) / 2 */
+    _rkCoriolisForceCross( v, &hu, &t1 );
+    _rkCoriolisForceCross( &u, &hv, &t2 );
+    zVec6DAddDRC( &t1, &t2 );
+    _rkCoriolisMotionCross( v, &u, &vu );
+    _rkCoriolisMomentum( rkLinkMass(link), &pc, &i, &vu, &t2 );
+    zVec6DSubDRC( &t1, &t2 );
+    for( j=0; j<6; j++ ){
+      ic[j*6+k] += hu.e[j];
+      bc[j*6+k] += 0.5 * t1.e[j];
+    }
+  }
+}
+
+/* product of a 6x6 row-major matrix (or its transpose) and a 6D vector. */
+static zVec6D *_rkCoriolisMulMatVec(double *m, zVec6D *v, zVec6D *mv, bool trans)
+{
+  register int j, k;
+
+  for( j=0; j<6; j++ )
+    for( mv->e[j]=0, k=0; k<6; k++ )
+      mv->e[j] += ( trans ? m[k*6+j] : m[j*6+k] ) * v->e[k];
+  return mv;
+}
+
+/* motion subspace of a joint axis. */
+static zVec6D *_rkCoriolisAxis(rkLink *link, int i, zVec6D *s)
+{
+  zVec3D tmp;
+
+  if( !rkJointLinAxis( rkLinkJoint(link), i, rkLinkWldFrame(link), zVec6DLin(s) ) )
+    zVec3DZero( zVec6DLin(s) );
+  if( rkJointAngAxis( rkLinkJoint(link), i, rkLinkWldFrame(link), zVec6DAng(s) ) ){
+    zVec3DOuterProd( rkLinkWldPos(link), zVec6DAng(s), &tmp );
+    zVec3DAddDRC( zVec6DLin(s), &tmp );
+  } else
+    zVec3DZero( zVec6DAng(s) );
+  return s;
+}
+
+/* forward sweep of link velocities, joint axes and their rates. */
+static void _rkCoriolisForward(rkChain *chain, rkLink *link, zVec6D *vp, zVec6D *v, zVec6D *s, zVec6D *ds, double *ic, double *bc)
+{
+  double dq[6];
+  zVec6D w, wl;
+  zVec3D tmp;
+  register int k;
+  int id, j;
+
+  id = link - rkChainRoot(chain);
+  zVec6DCopy( vp, &v[id] );
+  rkJointGetVel( rkLinkJoint(link), dq );
+  for( k=0; k<rkLinkJointSize(link); k++ ){
+    j = rkLinkOffset(link) + k;
+    _rkCoriolisAxis( link, k, &s[j] );
+    /* the axis moves at the velocity of the parent plus that carried by the joint itself */
+    rkJointAxisVel( rkLinkJoint(link), k, &wl );
+    zMulMat3DVec6D( rkLinkWldAtt(link), &wl, &w );
+    zVec3DOuterProd( rkLinkWldPos(link), zVec6DAng(&w), &tmp );
+    zVec3DAddDRC( zVec6DLin(&w), &tmp );
+    zVec6DAddDRC( &w, vp );
+    _rkCoriolisMotionCross( &w, &s[j], &ds[j] );
+    zVec6DCatDRC( &v[id], dq[k], &s[j] );
+  }
+  memset( ic+id*36, 0, sizeof(double)*36 );
+  memset( bc+id*36, 0, sizeof(double)*36 );
+  _rkCoriolisAddLinkInertia( link, &v[id], ic+id*36, bc+id*36 );
+  if( rkLinkChild(link) )
+    _rkCoriolisForward( chain, rkLinkChild(link), &v[id], v, s, ds, ic, bc );
+  if( rkLinkSibl(link) )
+    _rkCoriolisForward( chain, rkLinkSibl(link), vp, v, s, ds, ic, bc );
+}
+
+/* backward sweep of composite inertias and Coriolis matrix components. */
+static void _rkCoriolisBackward(rkChain *chain, rkLink *link, zVec6D *s, zVec6D *ds, double *ic, double *bc, zMat c)
+{
+  rkLink *l;
+  zVec6D f1, f2, f3, tmp;
+  register int k, m;
+  int id, i, j;
+
+  if( rkLinkChild(link) )
+    _rkCoriolisBackward( chain, rkLinkChild(link), s, ds, ic, bc, c );
+  if( rkLinkSibl(link) )
+    _rkCoriolisBackward( chain, rkLinkSibl(link), s, ds, ic, bc, c );
+  id = link - rkChainRoot(chain);
+  for( k=0; k<rkLinkJointSize(link); k++ ){
+    j = rkLinkOffset(link) + k;
+    _rkCoriolisMulMatVec( ic+id*36, &ds[j], &f1, false );
+    _rkCoriolisMulMatVec( bc+id*36, &s[j], &tmp, false );
+    zVec6DAddDRC( &f1, &tmp );
+    _rkCoriolisMulMatVec( ic+id*36, &s[j], &f2, false );
+    _rkCoriolisMulMatVec( bc+id*36, &s[j], &f3, true );
+    for( l=link; l; l=rkLinkParent(l) )
+      for( m=0; m<rkLinkJointSize(l); m++ ){
+        i = rkLinkOffset(l) + m;
+        zMatElemNC(c,i,j) = zVec6DInnerProd( &s[i], &f1 );
+        if( l != link )
+          zMatElemNC(c,j,i) = zVec6DInnerProd( &ds[i], &f2 ) + zVec6DInnerProd( &s[i], &f3 );
+      }
+  }
+  if( !rkLinkParent(link) ) return;
+  i = rkLinkParent(link) - rkChainRoot(chain);
+  for( k=0; k<36; k++ ){
+    ic[i*36+k] += ic[id*36+k];
+    bc[i*36+k] += bc[id*36+k];
+  }
+}
+
+/* Coriolis matrix of a kinematic chain. */
+bool rkChainCoriolisMat(rkChain *chain, zMat c)
+{
+  zVec6D *v, *s, *ds;
+  double *ic, *bc;
+  bool ret = true;
+
+  if( !zMatIsSqr( c ) || zMatRowSizeNC(c) != rkChainJointSize(chain) ){
+    ZRUNERROR( RK_ERR_MAT_VEC_SIZMISMATCH );
+    return false;
+  }
+  zMatZero( c );
+  if( rkChainJointSize(chain) == 0 ) return true;
+  v = zAlloc( zVec6D, rkChainLinkNum(chain) );
+  s = zAlloc( zVec6D, rkChainJointSize(chain) );
+  ds = zAlloc( zVec6D, rkChainJointSize(chain) );
+  ic = zAlloc( double, rkChainLinkNum(chain)*36 );
+  bc = zAlloc( double, rkChainLinkNum(chain)*36 );
+  if( !v || !s || !ds || !ic || !bc ){
+    ZALLOCERROR();
+    ret = false;
+    goto TERMINATE;
+  }
+  _rkCoriolisForward( chain, rkChainRoot(chain), ZVEC6DZERO, v, s, ds, ic, bc );
+  _rkCoriolisBackward( chain, rkChainRoot(chain), s, ds, ic, bc, c );
+ TERMINATE:
+  zFree( v );
+  zFree( s );
+  zFree( ds );
+  zFree( ic );
+  zFree( bc );
+  return ret;
+}
+
 /* net external wrench applied to a kinematic chain. */
 zVec6D *rkChainNetExtWrench(rkChain *c, zVec6D *w)
 {
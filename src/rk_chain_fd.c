@@ -0,0 +1,110 @@
+/* RoKi - Robot Kinetics library
+ * Copyright (C) 1998 Tomomichi Sugihara (Zhidao)
+ *
+ * rk_chain_fd - forward dynamics integrator of a kinematic chain
+ */
+
+#include <roki/rk_chain_fd.h>
+
+/* ********************************************************** */
+/* CLASS: rkChainFD
+ * forward dynamics integrator of a kinematic chain
+ * ********************************************************** */
+
+/* create a forward dynamics integrator. */
+rkChainFD *rkChainFDCreate(rkChainFD *fd, rkChain *chain, rkChainFDMethod method, double dt)
+{
+  int n;
+
+  fd->chain = chain;
+  fd->method = method;
+  fd->t = 0;
+  fd->dt = dt;
+  n = rkChainJointSize( chain );
+  fd->dis = zVecAlloc( n );
+  fd->vel = zVecAlloc( n );
+  fd->acc = zVecAlloc( n );
+  fd->_dis = zVecAlloc( n );
+  fd->_vel = zVecAlloc( n );
+  fd->_acc = zVecAlloc( n );
+  fd->_vs = zVecAlloc( n );
+  fd->_as = zVecAlloc( n );
+  if( !fd->dis || !fd->vel || !fd->acc || !fd->_dis || !fd->_vel || !fd->_acc || !fd->_vs || !fd->_as ){
+    rkChainFDDestroy( fd );
+    return NULL;
+  }
+  rkChainGetJointDisAll( chain, fd->dis );
+  return fd;
+}
+
+/* destroy a forward dynamics integrator. */
+void rkChainFDDestroy(rkChainFD *fd)
+{
+  zVecFreeAO( 8, fd->dis, fd->vel, fd->acc, fd->_dis, fd->_vel, fd->_acc, fd->_vs, fd->_as );
+  fd->chain = NULL;
+  fd->dis = fd->vel = fd->acc = NULL;
+  fd->_dis = fd->_vel = fd->_acc = fd->_vs = fd->_as = NULL;
+}
+
+/* initialize a forward dynamics integrator. */
+void rkChainFDInit(rkChainFD *fd, zVec dis, zVec vel)
+{
+  fd->t = 0;
+  if( dis ) zVecCopyNC( dis, fd->dis );
+  if( vel ) zVecCopyNC( vel, fd->vel );
+  zVecZero( fd->acc );
+}
+
+/* semi-implicit Euler method. */
+static void _rkChainFDStepEuler(rkChainFD *fd)
+{
+  rkChainABI( fd->chain, fd->dis, fd->vel, fd->acc );
+  zVecCatNCDRC( fd->vel, fd->dt, fd->acc );
+  rkChainCatJointDisAll( fd->chain, fd->dis, fd->dt, fd->vel );
+}
+
+/* an intermediate stage of the Runge-Kutta method. */
+static void _rkChainFDStageRK4(rkChainFD *fd, double h, zVec acc, double w)
+{
+  zVecCopyNC( fd->dis, fd->_dis );
+  rkChainCatJointDisAll( fd->chain, fd->_dis, h, fd->_vel );
+  zVecCatNC( fd->vel, h, acc, fd->_vel );
+  rkChainABI( fd->chain, fd->_dis, fd->_vel, fd->_acc );
+  zVecCatNCDRC( fd->_vs, w, fd->_vel );
+  zVecCatNCDRC( fd->_as, w, fd->_acc );
+}
+
+/* classical fourth-order Runge-Kutta method. */
+static void _rkChainFDStepRK4(rkChainFD *fd)
+{
+  double h;
+
+  h = 0.5 * fd->dt;
+  rkChainABI( fd->chain, fd->dis, fd->vel, fd->acc );
+  zVecCopyNC( fd->vel, fd->_vs );
+  zVecCopyNC( fd->acc, fd->_as );
+  zVecCopyNC( fd->vel, fd->_vel );
+  _rkChainFDStageRK4( fd, h, fd->acc, 2 );
+  _rkChainFDStageRK4( fd, h, fd->_acc, 2 );
+  _rkChainFDStageRK4( fd, fd->dt, fd->_acc, 1 );
+  rkChainCatJointDisAll( fd->chain, fd->dis, fd->dt/6, fd->_vs );
+  zVecCatNCDRC( fd->vel, fd->dt/6, fd->_as );
+}
+
+/* step forward dynamics. */
+rkChainFD *rkChainFDStep(rkChainFD *fd)
+{
+  switch( fd->method ){
+  case RK_CHAIN_FD_RK4: _rkChainFDStepRK4( fd ); break;
+  default:              _rkChainFDStepEuler( fd );
+  }
+  fd->t += fd->dt;
+  return fd;
+}
+
+/* repeat steps of forward dynamics. */
+rkChainFD *rkChainFDStepN(rkChainFD *fd, int n)
+{
+  while( n-- > 0 ) rkChainFDStep( fd );
+  return fd;
+}
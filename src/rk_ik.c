@@ -4,6 +4,9 @@
  * rk_ik - inverse kinematics
  */
 
+/* for a monotonic clock */
+#include <time.h>
+
 #include <roki/rk_ik.h>
 
 /* ********************************************************** */
@@ -11,6 +14,19 @@
  * inverse kinematics class
  * ********************************************************** */
 
+/* current time of a monotonic clock in seconds. */
+static double _rkIKClock(void)
+{
+#ifdef CLOCK_MONOTONIC
+  struct timespec ts;
+
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+#else
+  return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
 /* initialize inverse kinematics solver. */
 static void _rkIKInit(rkIK *ik)
 {
@@ -19,10 +35,13 @@ static void _rkIKInit(rkIK *ik)
   ik->joint_weight = NULL;
   ik->joint_vel = NULL;
   ik->eval = 0;
+  memset( &ik->stat, 0, sizeof(rkIKStat) );
+  memset( &ik->trace, 0, sizeof(rkIKTrace) );
+  ik->seed = NULL;
 
   zListInit( &ik->clist );
   ik->_c_mat_cell = NULL;
-  zVec3DZero( &ik->_c_srv_cell );
+  zVec6DZero( &ik->_c_srv_cell );
 
   ik->_j_idx = NULL;
   ik->_j_ofs = NULL;
@@ -33,6 +52,8 @@ static void _rkIKInit(rkIK *ik)
   ik->_c_we = NULL;
   /* default joint velocity computation method */
   ik->_jv = rkIKJointVelAD;
+  ik->_dis_best = NULL;
+  ik->_damp = 0;
   ik->__c = NULL;
   zLEInit( &ik->__le );
 }
@@ -46,9 +67,10 @@ rkIK *rkIKCreate(rkIK *ik, rkChain *chain)
   ik->joint_weight = zAlloc( double, rkChainLinkNum(chain) );
   ik->joint_vel = zVecAlloc( rkChainJointSize(chain) );
   ik->_j_ofs = zIndexCreate( rkChainLinkNum(chain) );
-  ik->_c_mat_cell = zMatAlloc( 3, rkChainJointSize(chain) );
+  ik->_c_mat_cell = zMatAlloc( RK_IK_CELL_DIM_MAX, rkChainJointSize(chain) );
+  ik->_dis_best = zVecAlloc( rkChainJointSize(chain) );
   if( !ik->joint_sw || !ik->joint_weight ||
-      !ik->joint_vel || !ik->_c_mat_cell ){
+      !ik->joint_vel || !ik->_c_mat_cell || !ik->_dis_best ){
     ZALLOCERROR();
     return NULL;
   }
@@ -74,17 +96,30 @@ void rkIKDestroy(rkIK *ik)
   zVecFree( ik->_c_srv );
   zVecFree( ik->_c_we );
   ik->_jv = NULL;
+  zVecFree( ik->_dis_best );
+  rkIKTraceFree( ik );
   zVecFree( ik->__c );
   zLEFree( &ik->__le );
 }
 
+/* total number of components constrained by cells. */
+static int _rkIKCellDimTotal(rkIK *ik)
+{
+  rkIKCell *cp;
+  int dim = 0;
+
+  zListForEach( &ik->clist, cp )
+    dim += rkIKCellDim(cp);
+  return dim;
+}
+
 /* allocate working memory for constraint coefficient matrix of inverse kinematics solver. */
 static bool _rkIKAllocCMat(rkIK *ik)
 {
   if( zListSize(&ik->clist) == 0 || zArraySize(ik->_j_idx) == 0 )
     return true;
   zMatFree( ik->_c_mat );
-  if( !( ik->_c_mat = zMatAlloc( zListSize(&ik->clist)*3, zVecSizeNC(ik->_j_vel) ) ) ){
+  if( !( ik->_c_mat = zMatAlloc( _rkIKCellDimTotal(ik), zVecSizeNC(ik->_j_vel) ) ) ){
     ZALLOCERROR();
     return false;
   }
@@ -167,16 +202,17 @@ static bool _rkIKAllocSRV(rkIK *ik)
   if( zListSize(&ik->clist) == 0 ) return true;
   zVecFree( ik->_c_srv );
   zVecFree( ik->_c_we );
-  ik->_c_srv = zVecAlloc( zListSize(&ik->clist)*3 );
-  ik->_c_we = zVecAlloc( zListSize(&ik->clist)*3 );
-  ik->__c = zVecAlloc( zListSize(&ik->clist)*3 );
+  zVecFree( ik->__c );
+  ik->_c_srv = zVecAlloc( _rkIKCellDimTotal(ik) );
+  ik->_c_we = zVecAlloc( _rkIKCellDimTotal(ik) );
+  ik->__c = zVecAlloc( _rkIKCellDimTotal(ik) );
   if( !ik->_c_srv || !ik->_c_we || !ik->__c ){
     ZALLOCERROR();
     return false;
   }
   return _rkIKAllocCMat( ik );
 }
-rkIKCell *rkIKCellReg(rkIK *ik, rkIKCellAttr *attr, int mask, rkIKRef_fp rf, rkIKCMat_fp mf, rkIKSRV_fp vf, rkIKBind_fp bf, rkIKAcm_fp af, void *util)
+static rkIKCell *_rkIKCellReg(rkIK *ik, rkIKCellAttr *attr, int mask, int dim, rkIKRef_fp rf, rkIKCMat_fp mf, rkIKSRV_fp vf, rkIKBind_fp bf, rkIKAcm_fp af, void *util)
 {
   rkIKCell *cell, *cp;
 
@@ -185,6 +221,7 @@ rkIKCell *rkIKCellReg(rkIK *ik, rkIKCellAttr *attr, int mask, rkIKRef_fp rf, rkI
     return NULL;
   }
   rkIKCellInit( cell, attr, mask, rf, mf, vf, bf, af, util );
+  cell->data._dim = dim;
   if( zListIsEmpty( &ik->clist ) ||
       ( cp = zListTail(&ik->clist) )->data.id != 0 ){
     cp = zListRoot(&ik->clist);
@@ -199,6 +236,10 @@ rkIKCell *rkIKCellReg(rkIK *ik, rkIKCellAttr *attr, int mask, rkIKRef_fp rf, rkI
   /* return registered entry no., if it succeeds. */
   return _rkIKAllocSRV( ik ) ? cell : NULL;
 }
+rkIKCell *rkIKCellReg(rkIK *ik, rkIKCellAttr *attr, int mask, rkIKRef_fp rf, rkIKCMat_fp mf, rkIKSRV_fp vf, rkIKBind_fp bf, rkIKAcm_fp af, void *util)
+{
+  return _rkIKCellReg( ik, attr, mask, 3, rf, mf, vf, bf, af, util );
+}
 bool rkIKCellUnreg(rkIK *ik, rkIKCell *cell)
 {
   zListPurge( &ik->clist, cell );
@@ -248,9 +289,9 @@ static int _rkIKCellEq(rkIK *ik, rkIKCell *cell, int s, int row)
 {
   register int i, j;
 
-  if( !( ( RK_IK_CELL_XON << s ) & cell->data.attr.mode ) ) return 0;
+  if( !( ( RK_IK_CELL_XON << s%3 ) & cell->data.attr.mode ) ) return 0;
   zVecSetElemNC( ik->_c_srv, row, ik->_c_srv_cell.e[s] );
-  zVecSetElemNC( ik->_c_we, row, cell->data.attr.w.e[s] );
+  zVecSetElemNC( ik->_c_we, row, cell->data.attr.w.e[s%3] );
   for( i=0; i<rkChainLinkNum(ik->chain); i++ )
     if( ik->joint_sw[i] ){
       for( j=0; j<rkChainLinkJointSize(ik->chain,i); j++ )
@@ -264,6 +305,17 @@ static int _rkIKCellEq(rkIK *ik, rkIKCell *cell, int s, int row)
     }
   return 1;
 }
+/* weighted-squared norm of residual of a cell. */
+static double _rkIKCellWSqrNorm(rkIKCell *cell, zVec6D *srv)
+{
+  double e;
+
+  e = zVec3DWSqrNorm( zVec6DLin(srv), &cell->data.attr.w );
+  if( rkIKCellDim(cell) > 3 )
+    e += zVec3DWSqrNorm( zVec6DAng(srv), &cell->data.attr.w );
+  return e;
+}
+
 void rkIKEq(rkIK *ik)
 {
   register int i;
@@ -273,14 +325,15 @@ void rkIKEq(rkIK *ik)
   ik->eval = 0;
   zListForEach( &ik->clist, cell ){
     if( rkIKCellIsDisabled( cell ) ) continue;
+    zMatSetRowSize( ik->_c_mat_cell, rkIKCellDim(cell) );
     rkIKCellCMat( cell, ik->chain, ik->_c_mat_cell );
-    rkIKCellSRV( cell, ik->chain, &ik->_c_srv_cell );
-    cell->data._eval = zVec3DWSqrNorm( &ik->_c_srv_cell, &cell->data.attr.w );
+    rkIKCellSRV( cell, ik->chain, zVec6DLin(&ik->_c_srv_cell) );
+    cell->data._eval = _rkIKCellWSqrNorm( cell, &ik->_c_srv_cell );
     ik->eval += cell->data._eval;
     cell->data._eval = sqrt( cell->data._eval );
     if( rkIKCellIsForced( cell ) )
-      rkIKCellAcm( cell, ik->chain, &ik->_c_srv_cell );
-    for( i=0; i<3; i++ )
+      rkIKCellAcm( cell, ik->chain, zVec6DLin(&ik->_c_srv_cell) );
+    for( i=0; i<rkIKCellDim(cell); i++ )
       row += _rkIKCellEq( ik, cell, i, row );
   }
   ik->eval = sqrt( ik->eval );
@@ -314,19 +367,47 @@ zVec rkIKJointVelAD(rkIK *ik)
   zVecAmpNC( ik->_c_srv, ik->_c_we, ik->__c );
   zMulMatTVecNC( ik->_c_mat, ik->__c, ik->__le.v1 );
   zMatTQuadNC( ik->_c_mat, ik->_c_we, ik->__le.m );
-  e = zVecInnerProd( ik->_c_srv, ik->__c );
+  ik->_damp = e = zVecInnerProd( ik->_c_srv, ik->__c );
   for( i=0; i<zMatRowSizeNC(ik->__le.m); i++ )
     zMatElemNC(ik->__le.m,i,i) += zVecElemNC(ik->_j_wn,i) + e;
   zLESolveGaussDST( ik->__le.m, ik->__le.v1, ik->_j_vel, ik->__le.idx1, ik->__le.s );
   return ik->_j_vel;
 }
 
+/* record the latest iteration to the trace. */
+static void _rkIKTraceRecord(rkIK *ik, double time)
+{
+  register int i = 0;
+  rkIKCell *cell;
+  double *rec;
+
+  if( ik->trace.num < ik->trace.size )
+    rec = ik->trace.buf + ( ik->trace.head + ik->trace.num++ ) % ik->trace.size * rkIKTraceRecSize(ik);
+  else{ /* overwrite the oldest record */
+    rec = ik->trace.buf + ik->trace.head * rkIKTraceRecSize(ik);
+    ik->trace.head = ( ik->trace.head + 1 ) % ik->trace.size;
+  }
+  rec[0] = ik->trace.count++;
+  rec[1] = ik->eval;
+  rec[2] = zVecNorm( ik->_j_vel );
+  rec[3] = ik->_damp;
+  rec[4] = time;
+  zListForEach( &ik->clist, cell ){
+    if( i >= ik->trace.cellnum ) break;
+    rec[RK_IK_TRACE_HEADSIZE+i++] = rkIKCellIsDisabled( cell ) ? 0 : cell->data._eval;
+  }
+  for( ; i<ik->trace.cellnum; i++ )
+    rec[RK_IK_TRACE_HEADSIZE+i] = 0;
+}
+
 /* resolve the motion rate into joint angle rate. */
 zVec rkIKSolveRate(rkIK *ik)
 {
   register int i, j, k;
-  double *vp;
+  double *vp, t = 0;
 
+  if( rkIKTraceIsOn( ik ) ) t = _rkIKClock();
+  ik->_damp = 0;
   rkIKEq( ik );
   ik->_jv( ik );
   for( vp=zVecBuf(ik->_j_vel), i=0; i<zArraySize(ik->_j_idx); i++ ){
@@ -334,13 +415,13 @@ zVec rkIKSolveRate(rkIK *ik)
     for( j=0; j<rkChainLinkJointSize(ik->chain,k); j++ )
       zVecSetElemNC( ik->joint_vel, rkChainLinkOffset(ik->chain,k)+j, *vp++ );
   }
+  if( rkIKTraceIsOn( ik ) ) _rkIKTraceRecord( ik, _rkIKClock() - t );
   return ik->joint_vel;
 }
 
-/* solve one-step inverse kinematics based on Newton=Raphson's method. */
-zVec rkIKSolveOne(rkIK *ik, zVec dis, double dt)
+/* update joint displacements with the resolved joint angle rate. */
+static zVec _rkIKUpdateDis(rkIK *ik, zVec dis, double dt)
 {
-  rkIKSolveRate( ik );
   rkChainCatJointDisAll( ik->chain, dis, dt, ik->joint_vel );
   rkChainSetJointDisAll( ik->chain, dis );
   rkChainGetJointDisAll( ik->chain, dis );
@@ -348,13 +429,30 @@ zVec rkIKSolveOne(rkIK *ik, zVec dis, double dt)
   return dis;
 }
 
+/* solve one-step inverse kinematics based on Newton=Raphson's method. */
+zVec rkIKSolveOne(rkIK *ik, zVec dis, double dt)
+{
+  rkIKSolveRate( ik );
+  return _rkIKUpdateDis( ik, dis, dt );
+}
+
+/* initial posture of iteration. */
+static zVec _rkIKInitDis(rkIK *ik, zVec dis)
+{
+  if( ik->seed && rkIKSeedDBFind( ik->seed, ik, dis ) )
+    rkChainFK( ik->chain, dis );
+  else
+    rkChainGetJointDisAll( ik->chain, dis );
+  return dis;
+}
+
 /* solve inverse kinematics based on Newton=Raphson's method. */
 int rkIKSolve(rkIK *ik, zVec dis, double tol, int iter)
 {
   register int i;
   double rest = HUGE_VAL;
 
-  rkChainGetJointDisAll( ik->chain, dis );
+  _rkIKInitDis( ik, dis );
   ZITERINIT( iter );
   rkIKAcmZero( ik );
   for( i=0; i<iter; i++ ){
@@ -366,6 +464,139 @@ int rkIKSolve(rkIK *ik, zVec dis, double tol, int iter)
   return -1;
 }
 
+/* residual error of the current posture without computing Jacobian matrices. */
+static double _rkIKResidual(rkIK *ik)
+{
+  rkIKCell *cell;
+  zVec6D err;
+  double eval = 0;
+
+  zListForEach( &ik->clist, cell ){
+    if( rkIKCellIsDisabled( cell ) ) continue;
+    rkIKCellSRV( cell, ik->chain, zVec6DLin(&err) );
+    eval += _rkIKCellWSqrNorm( cell, &err );
+  }
+  return sqrt( eval );
+}
+
+/* solve inverse kinematics within a time budget. */
+rkIKStatus rkIKSolveTimed(rkIK *ik, zVec dis, double tol, int iter, double budget)
+{
+  register int i;
+  double rest = HUGE_VAL, best = HUGE_VAL;
+  double t0, t1, t2;
+
+  t0 = t1 = _rkIKClock();
+  _rkIKInitDis( ik, dis );
+  ZITERINIT( iter );
+  rkIKAcmZero( ik );
+  ik->stat.status = RK_IK_ITERMAX;
+  ik->stat.time_max = 0;
+  for( i=0; i<iter; ){
+    rkIKSolveRate( ik ); /* ik->eval is the residual at dis */
+    if( ik->eval < best ){
+      best = ik->eval;
+      zVecCopyNC( dis, ik->_dis_best );
+    }
+    _rkIKUpdateDis( ik, dis, 1.0 );
+    i++;
+    t2 = _rkIKClock();
+    if( t2 - t1 > ik->stat.time_max ) ik->stat.time_max = t2 - t1;
+    t1 = t2;
+    if( zIsTol( ik->eval - rest, tol ) ){
+      ik->stat.status = RK_IK_CONVERGED;
+      break;
+    }
+    rest = ik->eval;
+    if( t1 - t0 + ik->stat.time_max >= budget ){
+      ik->stat.status = RK_IK_TIMEOUT;
+      break;
+    }
+  }
+  ik->stat.iter = i;
+  ik->stat.eval = _rkIKResidual( ik );
+  if( ik->stat.status != RK_IK_CONVERGED && ik->stat.eval > best ){
+    /* retract to the best iterate */
+    zVecCopyNC( ik->_dis_best, dis );
+    rkChainFK( ik->chain, dis );
+    ik->stat.eval = best;
+  }
+  ik->stat.time = _rkIKClock() - t0;
+  return ik->stat.status;
+}
+
+/* allocate a ring buffer to trace iterations. */
+rkIKTrace *rkIKTraceAlloc(rkIK *ik, int size)
+{
+  rkIKTraceFree( ik );
+  if( size <= 0 ) return NULL;
+  ik->trace.cellnum = zListSize( &ik->clist );
+  if( !( ik->trace.buf = zAlloc( double, size * ( RK_IK_TRACE_HEADSIZE + ik->trace.cellnum ) ) ) ){
+    ZALLOCERROR();
+    ik->trace.cellnum = 0;
+    return NULL;
+  }
+  ik->trace.size = size;
+  rkIKTraceReset( ik );
+  return &ik->trace;
+}
+
+/* free a ring buffer to trace iterations. */
+void rkIKTraceFree(rkIK *ik)
+{
+  zFree( ik->trace.buf );
+  memset( &ik->trace, 0, sizeof(rkIKTrace) );
+}
+
+/* discard all records of a trace. */
+void rkIKTraceReset(rkIK *ik)
+{
+  ik->trace.head = ik->trace.num = ik->trace.count = 0;
+}
+
+/* the i-th record of a trace from the oldest. */
+double *rkIKTraceRec(rkIK *ik, int i)
+{
+  if( i < 0 || i >= ik->trace.num ) return NULL;
+  return ik->trace.buf + ( ik->trace.head + i ) % ik->trace.size * rkIKTraceRecSize(ik);
+}
+
+/* print records of a trace in CSV format. */
+void rkIKTraceFPrintCSV(FILE *fp, rkIK *ik)
+{
+  register int i, j;
+  double *rec;
+
+  fprintf( fp, "iter,eval,step,damp,time" );
+  for( j=0; j<ik->trace.cellnum; j++ )
+    fprintf( fp, ",cell%d", j );
+  fprintf( fp, "\n" );
+  for( i=0; i<ik->trace.num; i++ ){
+    rec = rkIKTraceRec( ik, i );
+    fprintf( fp, "%d", (int)rec[0] );
+    for( j=1; j<rkIKTraceRecSize(ik); j++ )
+      fprintf( fp, ",%.10g", rec[j] );
+    fprintf( fp, "\n" );
+  }
+}
+
+/* write records of a trace in binary format. */
+bool rkIKTraceFWrite(FILE *fp, rkIK *ik)
+{
+  int n;
+
+  if( fwrite( &ik->trace.num, sizeof(int), 1, fp ) != 1 ||
+      fwrite( &ik->trace.cellnum, sizeof(int), 1, fp ) != 1 ) return false;
+  if( ik->trace.num == 0 ) return true;
+  /* the ring buffer is written in at most two chunks */
+  n = zMin( ik->trace.num, ik->trace.size - ik->trace.head );
+  if( fwrite( rkIKTraceRec(ik,0), sizeof(double)*rkIKTraceRecSize(ik), n, fp ) != (size_t)n ) return false;
+  if( n < ik->trace.num &&
+      fwrite( ik->trace.buf, sizeof(double)*rkIKTraceRecSize(ik), ik->trace.num-n, fp ) != (size_t)( ik->trace.num-n ) )
+    return false;
+  return true;
+}
+
 /* ********************************************************** */
 /* IK configuration file I/O
  * ********************************************************** */
@@ -405,6 +636,11 @@ rkIKCell *rkIKCellRegAMCOM(rkIK *ik, rkIKCellAttr *attr, int mask)
   return rkIKCellReg( ik, attr, mask, rkIKRefSetPos, rkIKJacobiAMCOM, rkIKAMCOMErr, rkIKBindAMCOM, rkIKAcmAtt, NULL );
 }
 
+rkIKCell *rkIKCellRegWldFrame(rkIK *ik, rkIKCellAttr *attr, int mask)
+{
+  return _rkIKCellReg( ik, attr, mask, 6, rkIKRefSetPos, rkIKJacobiLinkWld, rkIKLinkWldErr, rkIKBindLinkWld, rkIKAcmFrame, NULL );
+}
+
 /* IK item lookup table */
 static struct _rkIKLookup{
   char *str;
@@ -417,6 +653,7 @@ static struct _rkIKLookup{
   { "com",       rkIKCellRegCOM    },
   { "am",        rkIKCellRegAM     },
   { "amcom",     rkIKCellRegAMCOM  },
+  { "world_frame", rkIKCellRegWldFrame },
   { NULL, NULL },
 };
 
@@ -38,13 +38,14 @@ void rkIKCellInit(rkIKCell *cell, rkIKCellAttr *attr, int mask, rkIKRef_fp rf, r
   cell->data._bind_fp = bf;
   cell->data._acm_fp = af;
   cell->data.index_offset = 0;
+  cell->data._dim = 3;
   cell->data._eval = 0;
   cell->data._util = util;
 }
 
 void rkIKCellAcmZero(rkIKCell *cell)
 {
-  zVec3DZero( &cell->data.acm.ae.p );
+  memset( &cell->data.acm.ae, 0, sizeof(cell->data.acm.ae) );
   zVec3DCreate( &cell->data.acm.e_old.p, HUGE_VAL, HUGE_VAL, HUGE_VAL );
   zVec3DCreate( &cell->data.acm.h_old, HUGE_VAL, HUGE_VAL, HUGE_VAL );
 }
@@ -110,6 +111,11 @@ zMat rkIKJacobiAMCOM(rkChain *chain, rkIKCellAttr *attr, zMat j)
   return rkChainAMCOMMat( chain, j );
 }
 
+zMat rkIKJacobiLinkWld(rkChain *chain, rkIKCellAttr *attr, zMat j)
+{ /* linear and angular motion of a link in the world frame */
+  return rkChainLinkWldJacobi( chain, attr->id, &attr->ap, j );
+}
+
 /* displacement error */
 
 zVec3D *rkIKLinkWldPosErr(rkChain *chain, rkIKCellAttr *attr, void *util, rkIKRef *ref, zVec3D *err)
@@ -161,6 +167,16 @@ zVec3D *rkIKAMCOMErr(rkChain *chain, rkIKCellAttr *attr, void *util, rkIKRef *re
   return zVec3DRevDRC( err );
 }
 
+zVec3D *rkIKLinkWldErr(rkChain *chain, rkIKCellAttr *attr, void *util, rkIKRef *ref, zVec3D *err)
+{ /* position and attitude error of a link in the world frame */
+  zVec3D p;
+
+  zXform3D( rkChainLinkWldFrame(chain,attr->id), &attr->ap, &p );
+  zVec3DSub( zFrame3DPos(&ref->frame), &p, zVec6DLin((zVec6D*)err) );
+  zMat3DError( zFrame3DAtt(&ref->frame), rkChainLinkWldAtt(chain,attr->id), zVec6DAng((zVec6D*)err) );
+  return err;
+}
+
 /* bind current position/attitude */
 
 void rkIKBindLinkWldPos(rkChain *chain, rkIKCellAttr *attr, void *util, rkIKRef *ref)
@@ -202,6 +218,12 @@ void rkIKBindAMCOM(rkChain *chain, rkIKCellAttr *attr, void *util, rkIKRef *ref)
   rkChainAM( chain, rkChainWldCOM(chain), &ref->pos );
 }
 
+void rkIKBindLinkWld(rkChain *chain, rkIKCellAttr *attr, void *util, rkIKRef *ref)
+{ /* current frame of a link in the world frame */
+  zXform3D( rkChainLinkWldFrame(chain,attr->id), &attr->ap, zFrame3DPos(&ref->frame) );
+  zMat3DCopy( rkChainLinkWldAtt(chain,attr->id), zFrame3DAtt(&ref->frame) );
+}
+
 /* error accumulation correction */
 
 zVec3D *rkIKAcmPos(rkChain *chain, rkIKAcm *acm, void *util, zVec3D *srv)
@@ -218,3 +240,17 @@ zVec3D *rkIKAcmAtt(rkChain *chain, rkIKAcm *acm, void *util, zVec3D *srv)
   zEPCascade( &e, &acm->ae.e, &e );
   return zEP2AA( &e, srv );
 }
+
+zVec3D *rkIKAcmFrame(rkChain *chain, rkIKAcm *acm, void *util, zVec3D *srv)
+{
+  zVec3D *ang;
+  zEP e;
+
+  zVec3DAddDRC( srv, zVec3DCatDRC( &acm->ae.f.p, 1.0, srv ) );
+  ang = zVec6DAng( (zVec6D*)srv );
+  zAA2EP( ang, &e );
+  zEPCatDRC( &acm->ae.f.e, 1.0, &e );
+  zEPCascade( &e, &acm->ae.f.e, &e );
+  zEP2AA( &e, ang );
+  return srv;
+}
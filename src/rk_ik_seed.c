@@ -0,0 +1,271 @@
+/* RoKi - Robot Kinetics library
+ * Copyright (C) 1998 Tomomichi Sugihara (Zhidao)
+ *
+ * rk_ik_seed - inverse kinematics: seed database
+ */
+
+#include <roki/rk_ik.h>
+
+/* ********************************************************** */
+/* CLASS: rkIKSeedDB
+ * database of solutions of inverse kinematics to be seeds
+ * ********************************************************** */
+
+/* create an IK seed database. */
+rkIKSeedDB *rkIKSeedDBCreate(rkIKSeedDB *db, rkIK *ik)
+{
+  rkIKCell *cell;
+
+  db->keysize = 0;
+  zListForEach( &ik->clist, cell )
+    db->keysize += rkIKCellDim(cell);
+  db->dissize = rkChainJointSize(ik->chain);
+  db->num = db->_size = 0;
+  db->radius = HUGE_VAL;
+  db->_key = db->_dis = NULL;
+  db->_left = db->_right = NULL;
+  if( !( db->_kbuf = zAlloc( double, zMax(db->keysize,1) ) ) ){
+    ZALLOCERROR();
+    return NULL;
+  }
+  return db;
+}
+
+/* destroy an IK seed database. */
+void rkIKSeedDBDestroy(rkIKSeedDB *db)
+{
+  zFree( db->_key );
+  zFree( db->_dis );
+  zFree( db->_left );
+  zFree( db->_right );
+  zFree( db->_kbuf );
+  db->keysize = db->dissize = db->num = db->_size = 0;
+}
+
+/* reserve entries of an IK seed database. */
+static bool _rkIKSeedDBReserve(rkIKSeedDB *db, int size)
+{
+  double *key, *dis;
+  int *left, *right;
+
+  if( size <= db->_size ) return true;
+  size = zMax( size, db->_size*2 );
+  key = realloc( db->_key, sizeof(double)*db->keysize*size );
+  if( key ) db->_key = key;
+  dis = realloc( db->_dis, sizeof(double)*db->dissize*size );
+  if( dis ) db->_dis = dis;
+  left = realloc( db->_left, sizeof(int)*size );
+  if( left ) db->_left = left;
+  right = realloc( db->_right, sizeof(int)*size );
+  if( right ) db->_right = right;
+  if( !key || !dis || !left || !right ){
+    ZALLOCERROR();
+    return false;
+  }
+  db->_size = size;
+  return true;
+}
+
+/* key of the current references of constraint cells. */
+double *rkIKSeedDBKeyIK(rkIKSeedDB *db, rkIK *ik, double *key)
+{
+  rkIKCell *cell;
+  zVec3D *v;
+  int i = 0;
+
+  zListForEach( &ik->clist, cell ){
+    if( i + rkIKCellDim(cell) > db->keysize ) break;
+    v = (zVec3D *)( key + i );
+    if( rkIKCellIsDisabled( cell ) ){
+      zVec3DZero( v );
+      if( rkIKCellDim(cell) == 6 ) zVec3DZero( v+1 );
+    } else
+    if( rkIKCellDim(cell) == 6 ){ /* position and attitude of a frame */
+      zVec3DCopy( zFrame3DPos(&cell->data.ref.frame), v );
+      zMat3DToAA( zFrame3DAtt(&cell->data.ref.frame), v+1 );
+    } else
+    if( cell->data._ref_fp == rkIKRefSetPos )
+      zVec3DCopy( &cell->data.ref.pos, v );
+    else
+      zMat3DToAA( &cell->data.ref.att, v );
+    i += rkIKCellDim(cell);
+  }
+  for( ; i<db->keysize; i++ ) key[i] = 0;
+  return key;
+}
+
+/* squared distance between two keys. */
+static double _rkIKSeedDBSqrDist(rkIKSeedDB *db, double *k1, double *k2)
+{
+  register int i;
+  double d = 0;
+
+  for( i=0; i<db->keysize; i++ )
+    d += zSqr( k1[i] - k2[i] );
+  return d;
+}
+
+/* insert the next entry of an IK seed database, of which the key and the
+   joint displacement are already stored, to kd-tree. */
+static void _rkIKSeedDBInsert(rkIKSeedDB *db)
+{
+  int node, depth, axis;
+  int *child;
+  double *key;
+
+  key = rkIKSeedDBKey(db,db->num);
+  db->_left[db->num] = db->_right[db->num] = -1;
+  if( db->num > 0 && db->keysize > 0 )
+    for( node=0, depth=0; ; node=*child, depth++ ){
+      axis = depth % db->keysize;
+      child = key[axis] < rkIKSeedDBKey(db,node)[axis] ?
+        &db->_left[node] : &db->_right[node];
+      if( *child < 0 ){
+        *child = db->num;
+        break;
+      }
+    }
+  db->num++;
+}
+
+/* add a seed to an IK seed database. */
+bool rkIKSeedDBAdd(rkIKSeedDB *db, double *key, zVec dis)
+{
+  if( zVecSizeNC(dis) != db->dissize ){
+    ZRUNERROR( RK_ERR_MAT_VEC_SIZMISMATCH );
+    return false;
+  }
+  if( !_rkIKSeedDBReserve( db, db->num+1 ) ) return false;
+  memcpy( rkIKSeedDBKey(db,db->num), key, sizeof(double)*db->keysize );
+  memcpy( rkIKSeedDBDis(db,db->num), zVecBuf(dis), sizeof(double)*db->dissize );
+  _rkIKSeedDBInsert( db );
+  return true;
+}
+
+/* add a solution of inverse kinematics to an IK seed database. */
+bool rkIKSeedDBAddIK(rkIKSeedDB *db, rkIK *ik, zVec dis)
+{
+  return rkIKSeedDBAdd( db, rkIKSeedDBKeyIK( db, ik, db->_kbuf ), dis );
+}
+
+/* nearest neighbor search in kd-tree. */
+static void _rkIKSeedDBNN(rkIKSeedDB *db, int node, int depth, double *key, int *nn, double *d2min)
+{
+  int axis;
+  double d2, diff;
+
+  if( node < 0 ) return;
+  if( ( d2 = _rkIKSeedDBSqrDist( db, key, rkIKSeedDBKey(db,node) ) ) < *d2min ){
+    *d2min = d2;
+    *nn = node;
+  }
+  axis = depth % db->keysize;
+  diff = key[axis] - rkIKSeedDBKey(db,node)[axis];
+  _rkIKSeedDBNN( db, diff < 0 ? db->_left[node] : db->_right[node], depth+1, key, nn, d2min );
+  if( zSqr(diff) < *d2min ) /* the other side may have closer ones */
+    _rkIKSeedDBNN( db, diff < 0 ? db->_right[node] : db->_left[node], depth+1, key, nn, d2min );
+}
+
+/* find the nearest neighbor of a key in an IK seed database. */
+int rkIKSeedDBNN(rkIKSeedDB *db, double *key, double *dist)
+{
+  int nn = -1;
+  double d2min = HUGE_VAL;
+
+  if( db->num == 0 ) return -1;
+  if( db->keysize == 0 ){
+    nn = 0;
+    d2min = 0;
+  } else
+    _rkIKSeedDBNN( db, 0, 0, key, &nn, &d2min );
+  if( dist ) *dist = sqrt( d2min );
+  return nn;
+}
+
+/* find a seed for the current references of inverse kinematics. */
+zVec rkIKSeedDBFind(rkIKSeedDB *db, rkIK *ik, zVec dis)
+{
+  int nn;
+  double dist;
+
+  if( ( nn = rkIKSeedDBNN( db, rkIKSeedDBKeyIK( db, ik, db->_kbuf ), &dist ) ) < 0 ||
+      dist > db->radius ) return NULL;
+  memcpy( zVecBuf(dis), rkIKSeedDBDis(db,nn), sizeof(double)*db->dissize );
+  return dis;
+}
+
+/* write an IK seed database to a file in binary format. */
+bool rkIKSeedDBFWrite(FILE *fp, rkIKSeedDB *db)
+{
+  int head[3];
+
+  head[0] = db->keysize;
+  head[1] = db->dissize;
+  head[2] = db->num;
+  if( fwrite( RK_IKSEED_MAGIC, sizeof(RK_IKSEED_MAGIC)-1, 1, fp ) != 1 ||
+      fwrite( head, sizeof(int), 3, fp ) != 3 ) return false;
+  if( db->num == 0 ) return true;
+  return ( db->keysize == 0 ||
+           fwrite( db->_key, sizeof(double)*db->keysize, db->num, fp ) == (size_t)db->num ) &&
+         ( db->dissize == 0 ||
+           fwrite( db->_dis, sizeof(double)*db->dissize, db->num, fp ) == (size_t)db->num );
+}
+
+/* read an IK seed database from a file in binary format. */
+bool rkIKSeedDBFRead(FILE *fp, rkIKSeedDB *db)
+{
+  char magic[sizeof(RK_IKSEED_MAGIC)-1];
+  int head[3];
+  register int i;
+
+  if( fread( magic, sizeof(magic), 1, fp ) != 1 ||
+      memcmp( magic, RK_IKSEED_MAGIC, sizeof(magic) ) != 0 ||
+      fread( head, sizeof(int), 3, fp ) != 3 ||
+      head[0] != db->keysize || head[1] != db->dissize || head[2] < 0 ){
+    ZRUNERROR( RK_ERR_IK_SEED_INVFILE );
+    return false;
+  }
+  if( head[2] == 0 ) return true;
+  if( !_rkIKSeedDBReserve( db, db->num+head[2] ) ) return false;
+  /* the block of keys is followed by that of joint displacements */
+  if( ( db->keysize > 0 &&
+        fread( rkIKSeedDBKey(db,db->num), sizeof(double)*db->keysize, head[2], fp ) != (size_t)head[2] ) ||
+      ( db->dissize > 0 &&
+        fread( rkIKSeedDBDis(db,db->num), sizeof(double)*db->dissize, head[2], fp ) != (size_t)head[2] ) ){
+    ZRUNERROR( RK_ERR_IK_SEED_INVFILE );
+    return false;
+  }
+  for( i=0; i<head[2]; i++ )
+    _rkIKSeedDBInsert( db );
+  return true;
+}
+
+/* write an IK seed database to a file. */
+bool rkIKSeedDBWriteFile(rkIKSeedDB *db, char filename[])
+{
+  char fname[BUFSIZ];
+  FILE *fp;
+  bool ret;
+
+  zAddSuffix( filename, RK_IKSEED_SUFFIX, fname, BUFSIZ );
+  if( !( fp = fopen( fname, "w" ) ) ){
+    ZOPENERROR( fname );
+    return false;
+  }
+  ret = rkIKSeedDBFWrite( fp, db );
+  fclose( fp );
+  return ret;
+}
+
+/* read an IK seed database from a file. */
+bool rkIKSeedDBReadFile(rkIKSeedDB *db, char filename[])
+{
+  FILE *fp;
+  bool ret;
+
+  if( !( fp = zOpenFile( filename, RK_IKSEED_SUFFIX, "r" ) ) )
+    return false;
+  ret = rkIKSeedDBFRead( fp, db );
+  fclose( fp );
+  return ret;
+}
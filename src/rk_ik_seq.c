@@ -4,6 +4,13 @@
  * rk_ik_seq - inverse kinematics: sequence
  */
 
+/* for memory-mapped files */
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <roki/rk_ik.h>
 
 /* set IK sequence cell to IK solver. */
@@ -24,6 +31,166 @@ void rkIKSeqCellSet(rkIK *ik, rkIKSeqCell *c)
   }
 }
 
+/* free entries of IK sequence cell. */
+void rkIKSeqCellFree(rkIKSeqCell *c)
+{
+  zFree( c->entry );
+  rkIKSeqCellInit( c );
+}
+
+/* reserve entries of IK sequence cell. */
+static bool _rkIKSeqCellReserve(rkIKSeqCell *c, int nc)
+{
+  if( nc <= c->_size ) return true;
+  zFree( c->entry );
+  if( !( c->entry = zAlloc( rkIKEntry, nc ) ) ){
+    ZALLOCERROR();
+    c->_size = c->nc = 0;
+    return false;
+  }
+  /* paddings of entries are written out in binary format */
+  memset( c->entry, 0, sizeof(rkIKEntry)*nc );
+  c->_size = nc;
+  return true;
+}
+
+/* scan an IK sequence cell from the current position of a file. */
+bool rkIKSeqCellFScan(FILE *fp, rkIKSeqCell *c)
+{
+  register int i;
+  int nc;
+
+  if( feof(fp) || !zFSkipDelimiter( fp ) ) return false;
+  zFDouble( fp, &c->dt );
+  zFInt( fp, &nc );
+  if( nc < 0 || !_rkIKSeqCellReserve( c, nc ) ) return false;
+  for( c->nc=nc, i=0; i<c->nc; i++ ){
+    zFInt( fp, &c->entry[i].id );
+    zFDouble( fp, &c->entry[i].w[0] );
+    zFDouble( fp, &c->entry[i].w[1] );
+    zFDouble( fp, &c->entry[i].w[2] );
+    zFDouble( fp, &c->entry[i].val[0] );
+    zFDouble( fp, &c->entry[i].val[1] );
+    zFDouble( fp, &c->entry[i].val[2] );
+  }
+  return true;
+}
+
+/* print an IK sequence cell out to the current position of a file. */
+void rkIKSeqCellFPrint(FILE *fp, rkIKSeqCell *c)
+{
+  register int i;
+
+  fprintf( fp, "%.10g ", c->dt );
+  fprintf( fp, "%d", c->nc );
+  for( i=0; i<c->nc; i++ )
+    fprintf( fp, " %d %.10g %.10g %.10g %.10g %.10g %.10g",
+      c->entry[i].id,
+      c->entry[i].w[0], c->entry[i].w[1], c->entry[i].w[2],
+      c->entry[i].val[0], c->entry[i].val[1], c->entry[i].val[2] );
+  fprintf( fp, "\n" );
+}
+
+/* write the header of a binary IK sequence. */
+bool rkIKSeqBinFWriteHeader(FILE *fp)
+{
+  return fwrite( RK_IKSEQ_BIN_MAGIC, sizeof(RK_IKSEQ_BIN_MAGIC)-1, 1, fp ) == 1;
+}
+
+/* read the header of a binary IK sequence. */
+bool rkIKSeqBinFReadHeader(FILE *fp)
+{
+  char magic[sizeof(RK_IKSEQ_BIN_MAGIC)-1];
+
+  return fread( magic, sizeof(magic), 1, fp ) == 1 &&
+    memcmp( magic, RK_IKSEQ_BIN_MAGIC, sizeof(magic) ) == 0;
+}
+
+/* write an IK sequence cell in binary format. */
+bool rkIKSeqCellFWrite(FILE *fp, rkIKSeqCell *c)
+{
+  rkIKSeqBinHead head;
+
+  head.dt = c->dt;
+  head.nc = c->nc;
+  head._pad = 0;
+  if( fwrite( &head, sizeof(rkIKSeqBinHead), 1, fp ) != 1 ) return false;
+  return c->nc == 0 ||
+    fwrite( c->entry, sizeof(rkIKEntry), c->nc, fp ) == (size_t)c->nc;
+}
+
+/* read an IK sequence cell in binary format. */
+bool rkIKSeqCellFRead(FILE *fp, rkIKSeqCell *c)
+{
+  rkIKSeqBinHead head;
+
+  if( fread( &head, sizeof(rkIKSeqBinHead), 1, fp ) != 1 || head.nc < 0 )
+    return false;
+  if( !_rkIKSeqCellReserve( c, head.nc ) ) return false;
+  c->dt = head.dt;
+  c->nc = head.nc;
+  return c->nc == 0 ||
+    fread( c->entry, sizeof(rkIKEntry), c->nc, fp ) == (size_t)c->nc;
+}
+
+/* map a binary IK sequence file onto memory. */
+rkIKSeqMap *rkIKSeqMapOpen(rkIKSeqMap *map, char filename[])
+{
+  int fd;
+  struct stat st;
+  void *addr;
+
+  map->addr = NULL;
+  map->size = map->cur = 0;
+  if( ( fd = open( filename, O_RDONLY ) ) < 0 ){
+    ZOPENERROR( filename );
+    return NULL;
+  }
+  if( fstat( fd, &st ) < 0 || (size_t)st.st_size < sizeof(RK_IKSEQ_BIN_MAGIC)-1 ||
+      ( addr = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 ) ) == MAP_FAILED ){
+    ZRUNERROR( RK_ERR_IK_SEQ_INVBIN, filename );
+    close( fd );
+    return NULL;
+  }
+  close( fd );
+  map->addr = addr;
+  map->size = st.st_size;
+  if( memcmp( map->addr, RK_IKSEQ_BIN_MAGIC, sizeof(RK_IKSEQ_BIN_MAGIC)-1 ) != 0 ){
+    ZRUNERROR( RK_ERR_IK_SEQ_INVBIN, filename );
+    rkIKSeqMapClose( map );
+    return NULL;
+  }
+  rkIKSeqMapRewind( map );
+  return map;
+}
+
+/* unmap a binary IK sequence file. */
+void rkIKSeqMapClose(rkIKSeqMap *map)
+{
+  if( map->addr ) munmap( map->addr, map->size );
+  map->addr = NULL;
+  map->size = map->cur = 0;
+}
+
+/* the next cell of a memory-mapped binary IK sequence. */
+bool rkIKSeqMapNext(rkIKSeqMap *map, rkIKSeqCell *c)
+{
+  rkIKSeqBinHead head;
+
+  if( map->cur + sizeof(rkIKSeqBinHead) > map->size ) return false;
+  memcpy( &head, map->addr + map->cur, sizeof(rkIKSeqBinHead) );
+  if( head.nc < 0 ||
+      map->cur + sizeof(rkIKSeqBinHead) + sizeof(rkIKEntry)*head.nc > map->size )
+    return false;
+  map->cur += sizeof(rkIKSeqBinHead);
+  c->dt = head.dt;
+  c->nc = head.nc;
+  c->entry = (rkIKEntry *)( map->addr + map->cur );
+  c->_size = 0; /* not owned */
+  map->cur += sizeof(rkIKEntry) * head.nc;
+  return true;
+}
+
 /* initialize IK sequence. */
 rkIKSeq *rkIKSeqInit(rkIKSeq *seq)
 {
@@ -31,6 +198,7 @@ rkIKSeq *rkIKSeqInit(rkIKSeq *seq)
   zListRoot(seq)->data.dt = 0;
   zListRoot(seq)->data.nc = 0;
   zListRoot(seq)->data.entry = NULL;
+  zListRoot(seq)->data._size = 0;
   return seq;
 }
 
@@ -77,6 +245,7 @@ rkIKSeq *rkIKSeqFScan(FILE *fp, rkIKSeq *seq)
       free( cp );
       break;
     }
+    cp->data._size = cp->data.nc;
     for( i=0; i<cp->data.nc; i++ ){
       zFInt( fp, &cp->data.entry[i].id );
       zFDouble( fp, &cp->data.entry[i].w[0] );
@@ -111,20 +280,7 @@ bool rkIKSeqPrintFile(rkIKSeq *seq, char filename[])
 void rkIKSeqFPrint(FILE *fp, rkIKSeq *seq)
 {
   rkIKSeqListCell *cp;
-  register int i;
 
-  zListForEachRew( seq, cp ){
-    fprintf( fp, "%.10g ", cp->data.dt );
-    fprintf( fp, "%d", cp->data.nc );
-    for( i=0; i<cp->data.nc; i++ )
-      fprintf( fp, " %d %.10g %.10g %.10g %.10g %.10g %.10g",
-        cp->data.entry[i].id,
-        cp->data.entry[i].w[0],
-        cp->data.entry[i].w[1],
-        cp->data.entry[i].w[2],
-        cp->data.entry[i].val[0],
-        cp->data.entry[i].val[1],
-        cp->data.entry[i].val[2] );
-    fprintf( fp, "\n" );
-  }
+  zListForEachRew( seq, cp )
+    rkIKSeqCellFPrint( fp, &cp->data );
 }
@@ -90,6 +90,36 @@ zMat rkChainLinkWldLinJacobi(rkChain *c, int id, zVec3D *p, zMat jacobi)
   return jacobi;
 }
 
+/* Jacobian matrix about link translation and angular movement with respect to the world frame. */
+zMat rkChainLinkWldJacobi(rkChain *c, int id, zVec3D *p, zMat jacobi)
+{
+  rkLink *l;
+  register int i;
+  zVec3D s, a, tp, dp;
+
+  zMatZero( jacobi );
+  zXform3D( rkChainLinkWldFrame(c,id), p, &tp );
+  for( l=rkChainLink(c,id); ; l=rkLinkParent(l) ){
+    for( i=0; i<rkLinkJointSize(l); i++ ){
+      if( rkJointAngAxis( rkLinkJoint(l), i, rkLinkWldFrame(l), &a ) ){
+        zMatSetElemNC( jacobi, zXA, rkLinkOffset(l)+i, a.e[zX] );
+        zMatSetElemNC( jacobi, zYA, rkLinkOffset(l)+i, a.e[zY] );
+        zMatSetElemNC( jacobi, zZA, rkLinkOffset(l)+i, a.e[zZ] );
+        if( !rkJointLinAxis( rkLinkJoint(l), i, rkLinkWldFrame(l), &s ) ){
+          zVec3DSub( &tp, rkLinkWldPos(l), &dp );
+          zVec3DOuterProd( &a, &dp, &s );
+        }
+      } else
+      if( !rkJointLinAxis( rkLinkJoint(l), i, rkLinkWldFrame(l), &s ) ) continue;
+      zMatSetElemNC( jacobi, zX, rkLinkOffset(l)+i, s.e[zX] );
+      zMatSetElemNC( jacobi, zY, rkLinkOffset(l)+i, s.e[zY] );
+      zMatSetElemNC( jacobi, zZ, rkLinkOffset(l)+i, s.e[zZ] );
+    }
+    if( l == rkChainRoot(c) ) break;
+  }
+  return jacobi;
+}
+
 /* Jacobian matrix about relative angular movement of a link to another
  * with respect to the world frame. */
 zMat rkChainLinkToLinkAngJacobi(rkChain *c, int from, int to, zMat jacobi)
@@ -101,6 +101,10 @@ zVec3D *_rkJointAxisZ(void *prp, zFrame3D *f, zVec3D *a){
   return a;
 }
 
+void _rkJointAxisVelNull(void *prp, int i, zVec6D *v){
+  zVec6DZero( v );
+}
+
 /* joint torsion */
 
 double rkJointRevolTorsionDis(zFrame3D *dev, zVec6D *t)
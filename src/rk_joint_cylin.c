@@ -416,6 +416,7 @@ rkJointCom rk_joint_cylin = {
   _rkJointCylinTorsion,
   _rk_joint_cylin_axis_ang,
   _rk_joint_cylin_axis_lin,
+  _rkJointAxisVelNull,
 
   _rkJointCylinSetFrictionPivot,
   _rkJointCylinGetFrictionPivot,
@@ -119,6 +119,7 @@ rkJointCom rk_joint_fixed = {
   _rkJointFixedTorsion,
   _rk_joint_fixed_axis_ang,
   _rk_joint_fixed_axis_lin,
+  _rkJointAxisVelNull,
 
   _rkJointFixedFrictionPivot,
   _rkJointFixedFrictionPivot,
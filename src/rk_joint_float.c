@@ -183,6 +183,13 @@ static zVec3D* (*_rk_joint_float_axis_lin[])(void*,zFrame3D*,zVec3D*) = {
   _rkJointAxisNull,
 };
 
+/* the angular axes travel with the linear components */
+static void _rkJointFloatAxisVel(void *prp, int i, zVec6D *v){
+  zVec6DZero( v );
+  if( i >= 3 )
+    zMulMat3DTVec3D( &_rkc(prp)->_att, zVec6DLin(&_rkc(prp)->vel), zVec6DLin(v) );
+}
+
 static void _rkJointFloatFrictionPivot(void *prp, rkJointFrictionPivot *fp){}
 static void _rkJointFloatVal(void *prp, double *val){}
 
@@ -283,6 +290,7 @@ rkJointCom rk_joint_float = {
   _rkJointFloatTorsion,
   _rk_joint_float_axis_ang,
   _rk_joint_float_axis_lin,
+  _rkJointFloatAxisVel,
 
   _rkJointFloatFrictionPivot,
   _rkJointFloatFrictionPivot,
@@ -184,6 +184,13 @@ static zVec3D* (*_rk_joint_hooke_axis_lin[])(void*,zFrame3D*,zVec3D*) = {
   _rkJointAxisNull,
 };
 
+/* the second axis is carried by the first rotation */
+static void _rkJointHookeAxisVel(void *prp, int i, zVec6D *v){
+  zVec6DZero( v );
+  if( i == 1 )
+    zVec3DCreate( zVec6DAng(v), -_rkc(prp)->_s[1]*_rkc(prp)->vel[0], 0, _rkc(prp)->_c[1]*_rkc(prp)->vel[0] );
+}
+
 static void _rkJointHookeSetFrictionPivot(void *prp, rkJointFrictionPivot *fp){
   fp[0] = _rkc(prp)->_fp[0];
   fp[1] = _rkc(prp)->_fp[1];
@@ -384,6 +391,7 @@ rkJointCom rk_joint_hooke = {
   _rkJointHookeTorsion,
   _rk_joint_hooke_axis_ang,
   _rk_joint_hooke_axis_lin,
+  _rkJointHookeAxisVel,
 
   _rkJointHookeSetFrictionPivot,
   _rkJointHookeGetFrictionPivot,
@@ -357,6 +357,7 @@ rkJointCom rk_joint_prism = {
   _rkJointPrismTorsion,
   _rk_joint_prism_axis_ang,
   _rk_joint_prism_axis_lin,
+  _rkJointAxisVelNull,
 
   _rkJointPrismSetFrictionPivot,
   _rkJointPrismGetFrictionPivot,
@@ -365,6 +365,7 @@ rkJointCom rk_joint_revol = {
   _rkJointRevolTorsion,
   _rk_joint_revol_axis_ang,
   _rk_joint_revol_axis_lin,
+  _rkJointAxisVelNull,
 
   _rkJointRevolSetFrictionPivot,
   _rkJointRevolGetFrictionPivot,
@@ -293,6 +293,7 @@ rkJointCom rk_joint_spher = {
   _rkJointSpherTorsion,
   _rk_joint_spher_axis_ang,
   _rk_joint_spher_axis_lin,
+  _rkJointAxisVelNull,
 
   _rkJointSpherFrictionPivot,
   _rkJointSpherFrictionPivot,
@@ -184,8 +184,21 @@ void rkLinkUpdateRate(rkLink *l, zVec6D *pvel, zVec6D *pacc)
     rkLinkUpdateRate( rkLinkSibl(l), rkLinkVel(rkLinkParent(l)), rkLinkAcc(rkLinkParent(l)) );
 }
 
-/* update joint torque of link based on Neuton=Euler's equation. */
-void rkLinkUpdateWrench(rkLink *l)
+/* update link motion rate at rest only under the acceleration of gravity. */
+void rkLinkUpdateRateStatic(rkLink *l, zVec6D *pacc)
+{
+  zVec6DZero( rkLinkVel(l) );
+  zMulMat3DTVec6D( rkLinkAdjAtt(l), pacc, rkLinkAcc(l) );
+  zVec3DZero( rkLinkCOMVel(l) );
+  zVec3DCopy( rkLinkLinAcc(l), rkLinkCOMAcc(l) );
+  if( rkLinkChild(l) )
+    rkLinkUpdateRateStatic( rkLinkChild(l), rkLinkAcc(l) );
+  if( rkLinkSibl(l) )
+    rkLinkUpdateRateStatic( rkLinkSibl(l), rkLinkAcc(rkLinkParent(l)) );
+}
+
+/* update joint wrench of link based on Neuton=Euler's equation. */
+static void _rkLinkUpdateWrench(rkLink *l, bool calctrq)
 {
   zVec6D w;
   rkLink *child;
@@ -195,7 +208,7 @@ void rkLinkUpdateWrench(rkLink *l)
   zVec6DAngShiftDRC( rkLinkWrench(l), rkLinkCOM(l) );
   /* reaction force propagation from children */
   if( ( child = rkLinkChild(l) ) ){
-    rkLinkUpdateWrench( child );
+    _rkLinkUpdateWrench( child, calctrq );
     for( ; child; child=rkLinkSibl(child) ){
       zXform6DAng( rkLinkAdjFrame(child), rkLinkWrench(child), &w );
       zVec6DAddDRC( rkLinkWrench(l), &w );
@@ -204,10 +217,23 @@ void rkLinkUpdateWrench(rkLink *l)
   rkLinkNetExtWrench( l, &w ); /* external wrench */
   zVec6DSubDRC( rkLinkWrench(l), &w );
   /* joint torque resolution */
-  rkJointCalcTrq( rkLinkJoint(l), rkLinkWrench(l) );
+  if( calctrq )
+    rkJointCalcTrq( rkLinkJoint(l), rkLinkWrench(l) );
   /* branch */
   if( rkLinkSibl(l) )
-    rkLinkUpdateWrench( rkLinkSibl(l) );
+    _rkLinkUpdateWrench( rkLinkSibl(l), calctrq );
+}
+
+/* update joint torque of link based on Neuton=Euler's equation. */
+void rkLinkUpdateWrench(rkLink *l)
+{
+  _rkLinkUpdateWrench( l, true );
+}
+
+/* update joint wrench of link without resolving it to joint torque. */
+void rkLinkUpdateWrenchNoTrq(rkLink *l)
+{
+  _rkLinkUpdateWrench( l, false );
 }
 
 void rkLinkConfToJointDis(rkLink *link)
@@ -0,0 +1,474 @@
+#include <roki/roki.h>
+
+#define N 10
+
+void link_mp_rand(rkLink *l)
+{
+  double i11, i12, i13, i22, i23, i33;
+
+  rkLinkSetMass( l, zRandF(0.1,1.0) );
+  zVec3DCreate( rkLinkCOM(l), zRandF(-0.1,0.1), zRandF(-0.1,0.1), zRandF(-0.1,0.1) );
+  i11 = zRandF(0.01,0.1);
+  i12 =-zRandF(0.0001,0.001);
+  i13 =-zRandF(0.0001,0.001);
+  i22 = zRandF(0.01,0.1);
+  i23 =-zRandF(0.00001,0.0001);
+  i33 = zRandF(0.01,0.1);
+  zMat3DCreate( rkLinkInertia(l), i11, i12, i13, i12, i22, i23, i13, i23, i33 );
+}
+
+/* a branched kinematic chain with joints of given types */
+void chain_init_joint(rkChain *chain, int n, rkJointCom *com[], int nc)
+{
+  register int i;
+  char name[BUFSIZ];
+  zVec3D aa;
+
+  rkChainInit( chain );
+  zArrayAlloc( &chain->link, rkLink, n );
+  for( i=0; i<n; i++ ){
+    sprintf( name, "link#%02d", i );
+    rkLinkInit( rkChainLink(chain,i) );
+    link_mp_rand( rkChainLink(chain,i) );
+    rkChainMass( chain ) += rkChainLinkMass( chain, i );
+    zVec3DCreate( &aa, zRandF(-1,1), zRandF(-1,1), zRandF(-1,1) );
+    zVec3DCreate( rkChainLinkOrgPos(chain,i), zRandF(-0.5,0.5), zRandF(-0.5,0.5), zRandF(-0.5,0.5) );
+    zMat3DFromAA( rkChainLinkOrgAtt(chain,i), &aa );
+    zNameSet( rkChainLink(chain,i), name );
+    rkJointAssign( rkChainLinkJoint(chain,i), com[i%nc] );
+    if( i > 0 )
+      rkLinkAddChild( rkChainLink(chain,i<n/2+1?i-1:i-n/2), rkChainLink(chain,i) );
+  }
+  rkChainSetOffset( chain );
+  rkChainUpdateFK( chain );
+  rkChainUpdateID( chain );
+  rkChainABIAlloc( chain );
+}
+
+/* a branched kinematic chain with various joints */
+void chain_init(rkChain *chain, int n)
+{
+  rkJointCom *com[] = { &rk_joint_revol, &rk_joint_prism, &rk_joint_cylin, &rk_joint_revol };
+
+  chain_init_joint( chain, n, com, 4 );
+}
+
+void chain_set_rand(rkChain *chain, zVec dis, zVec vel)
+{
+  zVecRandUniform( dis, -1.0, 1.0 );
+  zVecRandUniform( vel, -1.0, 1.0 );
+  rkChainFK( chain, dis );
+  rkChainSetJointVelAll( chain, vel );
+  rkChainUpdateVel( chain );
+}
+
+/* contact-space inverse inertia matrix by the definition, J M^-1 J^T */
+void contact_inv_inertia(rkChain *chain, int k, rkABIContactAxis axis[], zMat d)
+{
+  zMat m, minv, j, jt, tmp;
+  zVec bias;
+  register int i, l;
+
+  m = zMatAllocSqr( rkChainJointSize(chain) );
+  minv = zMatAllocSqr( rkChainJointSize(chain) );
+  bias = zVecAlloc( rkChainJointSize(chain) );
+  j = zMatAlloc( 3, rkChainJointSize(chain) );
+  jt = zMatAlloc( k, rkChainJointSize(chain) );
+  tmp = zMatAlloc( rkChainJointSize(chain), k );
+  rkChainInertiaMatBiasVec( chain, m, bias );
+  zMatInv( m, minv );
+  for( i=0; i<k; i++ ){
+    rkChainLinkWldLinJacobi( chain, axis[i].link - rkChainRoot(chain), &axis[i].p, j );
+    for( l=0; l<rkChainJointSize(chain); l++ )
+      zMatSetElemNC( jt, i, l,
+        zMatElemNC(j,0,l)*axis[i].n.e[zX] + zMatElemNC(j,1,l)*axis[i].n.e[zY] + zMatElemNC(j,2,l)*axis[i].n.e[zZ] );
+  }
+  zMulMatMatTNC( minv, jt, tmp );
+  zMulMatMatNC( jt, tmp, d );
+  zMatFreeAO( 5, m, minv, j, jt, tmp );
+  zVecFree( bias );
+}
+
+bool assert_contact_inv_inertia(rkChain *chain, zVec dis, zVec vel)
+{
+  rkABIContactAxis axis[N];
+  zMat d, d_ans;
+  register int i;
+  bool result;
+
+  chain_set_rand( chain, dis, vel );
+  for( i=0; i<N; i++ ){
+    axis[i].link = rkChainLink(chain,zRandI(0,N-1));
+    zVec3DCreate( &axis[i].p, zRandF(-0.1,0.1), zRandF(-0.1,0.1), zRandF(-0.1,0.1) );
+    zVec3DCreate( &axis[i].n, zRandF(-1,1), zRandF(-1,1), zRandF(-1,1) );
+    zVec3DNormalizeDRC( &axis[i].n );
+  }
+  d = zMatAllocSqr( N );
+  d_ans = zMatAllocSqr( N );
+  rkChainABIUpdate( chain );
+  rkChainABIPushPrpAccBias( chain );
+  rkChainABIContactInvInertiaMat( chain, N, axis, d );
+  contact_inv_inertia( chain, N, axis, d_ans );
+  result = zMatIsEqual( d, d_ans, zTOL );
+  zMatFreeAO( 2, d, d_ans );
+  return result;
+}
+
+bool assert_inv_inertia(rkChain *chain, zVec dis, zVec vel)
+{
+  zMat m, minv, minv_ans;
+  zVec bias, v, a, a_ans;
+  bool result;
+
+  m = zMatAllocSqr( rkChainJointSize(chain) );
+  minv = zMatAllocSqr( rkChainJointSize(chain) );
+  minv_ans = zMatAllocSqr( rkChainJointSize(chain) );
+  bias = zVecAlloc( rkChainJointSize(chain) );
+  v = zVecAlloc( rkChainJointSize(chain) );
+  a = zVecAlloc( rkChainJointSize(chain) );
+  a_ans = zVecAlloc( rkChainJointSize(chain) );
+  chain_set_rand( chain, dis, vel );
+  zVecRandUniform( v, -1.0, 1.0 );
+  rkChainABIUpdate( chain );
+  rkChainInvInertiaMat( chain, minv );
+  rkChainInvInertiaMulVec( chain, v, a );
+  rkChainInertiaMatBiasVec( chain, m, bias );
+  zMatInv( m, minv_ans );
+  zMulMatVec( minv_ans, v, a_ans );
+  result = zMatIsEqual( minv, minv_ans, zTOL ) && zVecIsEqual( a, a_ans, zTOL );
+  zMatFreeAO( 3, m, minv, minv_ans );
+  zVecFreeAO( 4, bias, v, a, a_ans );
+  return result;
+}
+
+/* inverse of operational-space inertia matrix by the definition, J M^-1 J^T */
+void opspace_inv_inertia(rkChain *chain, int n, rkLink *link[], zVec3D p[], zMat m)
+{
+  zMat h, hinv, j, jt, tmp;
+  zVec bias;
+  register int i, k, l;
+
+  h = zMatAllocSqr( rkChainJointSize(chain) );
+  hinv = zMatAllocSqr( rkChainJointSize(chain) );
+  bias = zVecAlloc( rkChainJointSize(chain) );
+  j = zMatAlloc( 6, rkChainJointSize(chain) );
+  jt = zMatAlloc( 6*n, rkChainJointSize(chain) );
+  tmp = zMatAlloc( rkChainJointSize(chain), 6*n );
+  rkChainInertiaMatBiasVec( chain, h, bias );
+  zMatInv( h, hinv );
+  for( i=0; i<n; i++ ){
+    rkChainLinkWldJacobi( chain, link[i] - rkChainRoot(chain), &p[i], j );
+    for( k=0; k<6; k++ )
+      for( l=0; l<rkChainJointSize(chain); l++ )
+        zMatSetElemNC( jt, 6*i+k, l, zMatElemNC(j,k,l) );
+  }
+  zMulMatMatTNC( hinv, jt, tmp );
+  zMulMatMatNC( jt, tmp, m );
+  zMatFreeAO( 5, h, hinv, j, jt, tmp );
+  zVecFree( bias );
+}
+
+bool assert_opspace_inertia(rkChain *chain, zVec dis, zVec vel)
+{
+  rkLink *link[2];
+  zVec3D p[2];
+  zMat m, m_ans, ws, lambda, lambda_ans;
+  register int i, j;
+  bool result;
+
+  chain_set_rand( chain, dis, vel );
+  link[0] = rkChainLink(chain,N/2);
+  link[1] = rkChainLink(chain,N-1);
+  for( i=0; i<2; i++ )
+    zVec3DCreate( &p[i], zRandF(-0.1,0.1), zRandF(-0.1,0.1), zRandF(-0.1,0.1) );
+  m = zMatAllocSqr( 12 );
+  m_ans = zMatAllocSqr( 12 );
+  ws = zMatAllocSqr( 6 );
+  lambda = zMatAllocSqr( 6 );
+  lambda_ans = zMatAllocSqr( 6 );
+  rkChainABIUpdate( chain );
+  rkChainABIPushPrpAccBias( chain );
+  rkChainLinkOpSpaceInvInertia( chain, 2, link, p, m );
+  opspace_inv_inertia( chain, 2, link, p, m_ans );
+  result = zMatIsEqual( m, m_ans, zTOL );
+  /* the block of the first point */
+  for( i=0; i<6; i++ )
+    for( j=0; j<6; j++ )
+      zMatSetElemNC( lambda, i, j, zMatElemNC(m_ans,i,j) );
+  zMatInv( lambda, lambda_ans );
+  rkChainLinkOpSpaceInertia( chain, 1, link, p, ws, lambda );
+  result = result && zMatIsEqual( lambda, lambda_ans, 1.0e-8 );
+  zMatFreeAO( 5, m, m_ans, ws, lambda, lambda_ans );
+  return result;
+}
+
+bool assert_hd(rkChain *chain, zVec dis, zVec vel)
+{
+  zVec acc, trq, trq_id;
+  register int i, k;
+  bool result = true;
+
+  acc = zVecAlloc( rkChainJointSize(chain) );
+  trq = zVecAlloc( rkChainJointSize(chain) );
+  trq_id = zVecAlloc( rkChainJointSize(chain) );
+  chain_set_rand( chain, dis, vel );
+  zVecRandUniform( acc, -1.0, 1.0 );
+  for( i=0; i<rkChainLinkNum(chain); i++ )
+    rkLinkABISetAccSpec( rkChainLink(chain,i), i % 2 == 0 );
+  rkChainHD( chain, dis, vel, acc, trq );
+  rkChainID( chain, vel, acc );
+  rkChainGetJointTrqAll( chain, trq_id );
+  for( i=0; i<rkChainLinkNum(chain); i++ ){
+    if( rkChainLinkOffset(chain,i) < 0 ) continue;
+    for( k=0; k<rkChainLinkJointSize(chain,i); k++ )
+      if( !zIsTol( zVecElemNC(trq_id,rkChainLinkOffset(chain,i)+k) -
+            ( rkLinkABIIsAccSpec(rkChainLink(chain,i)) ? zVecElemNC(trq,rkChainLinkOffset(chain,i)+k) : 0 ), zTOL ) ){
+        eprintf( "link #%d, joint torque #%d\n", i, k );
+        result = false;
+      }
+  }
+  for( i=0; i<rkChainLinkNum(chain); i++ )
+    rkLinkABISetAccSpec( rkChainLink(chain,i), false );
+  zVecFreeAO( 3, acc, trq, trq_id );
+  return result;
+}
+
+bool assert_abi_frozen(rkChain *chain, zVec dis, zVec vel)
+{
+  zVec acc, acc_frozen;
+  bool result;
+
+  acc = zVecAlloc( rkChainJointSize(chain) );
+  acc_frozen = zVecAlloc( rkChainJointSize(chain) );
+  chain_set_rand( chain, dis, vel );
+  rkChainABIUpdate( chain );
+  /* only the velocity changes */
+  zVecRandUniform( vel, -1.0, 1.0 );
+  rkChainSetJointVelAll( chain, vel );
+  rkChainUpdateVel( chain );
+  rkChainABIUpdateFrozen( chain );
+  rkChainGetJointAccAll( chain, acc_frozen );
+  rkChainABIUpdate( chain );
+  rkChainGetJointAccAll( chain, acc );
+  result = zVecIsEqual( acc, acc_frozen, zTOL );
+  zVecFreeAO( 2, acc, acc_frozen );
+  return result;
+}
+
+/* frozen joint acceleration of a kinematic chain without updating inertias */
+void abi_frozen_acc(rkChain *chain, zVec dis, zVec vel, zVec acc)
+{
+  rkChainSetJointDisAll( chain, dis );
+  rkChainSetJointVelAll( chain, vel );
+  rkChainUpdateFK( chain );
+  rkChainUpdateVel( chain );
+  rkChainABIUpdateFrozenGetWrench( chain );
+  rkChainGetJointAccAll( chain, acc );
+}
+
+#define FZ_INTERVAL 5
+#define FZ_TOL      0.1
+
+bool assert_abi_freeze(rkChain *chain, zVec dis, zVec vel)
+{
+  rkABIFreeze fz;
+  zVec acc, acc_exact, acc_frozen;
+  int k;
+  register int i;
+  bool result = true;
+
+  acc = zVecAlloc( rkChainJointSize(chain) );
+  acc_exact = zVecAlloc( rkChainJointSize(chain) );
+  acc_frozen = zVecAlloc( rkChainJointSize(chain) );
+  rkABIFreezeCreate( &fz, chain, FZ_INTERVAL, FZ_TOL );
+  /* a joint of a non-root link, which moves the inertias of its subtree */
+  k = rkChainLinkOffset(chain,1);
+  zVecRandUniform( dis, -1.0, 1.0 );
+  zVecRandUniform( vel, -1.0, 1.0 );
+  /* the first call refreshes inertias */
+  rkChainABIFreeze( chain, &fz, dis, vel, acc );
+  rkChainABI( chain, dis, vel, acc_exact );
+  if( fz.refresh != 1 || fz.count != 0 || !zVecIsEqual( acc, acc_exact, zTOL ) ) result = false;
+  /* small deviations within the interval */
+  for( i=1; i<=FZ_INTERVAL; i++ ){
+    zVecElemNC(dis,k) += FZ_TOL * 0.1;
+    rkChainABIFreeze( chain, &fz, dis, vel, acc );
+    if( fz.refresh != 1 || fz.count != i || fabs( fz.err - FZ_TOL*0.1*i ) > zTOL ) result = false;
+  }
+  /* refresh after the interval, where the error of the frozen acceleration is observed */
+  zVecElemNC(dis,k) += FZ_TOL * 0.1;
+  abi_frozen_acc( chain, dis, vel, acc_frozen );
+  rkChainABIFreeze( chain, &fz, dis, vel, acc );
+  rkChainABI( chain, dis, vel, acc_exact );
+  if( fz.refresh != 2 || fz.count != 0 || fz.err != 0 ||
+      !zVecIsEqual( acc, acc_exact, zTOL ) ||
+      fabs( fz.acc_err - zVecDist( acc_exact, acc_frozen ) ) > zTOL || zIsTiny( fz.acc_err ) ){
+    eprintf( "not refreshed after the interval\n" );
+    result = false;
+  }
+  /* refresh by a deviation over the tolerance before the interval */
+  zVecElemNC(dis,k) += FZ_TOL * 2;
+  abi_frozen_acc( chain, dis, vel, acc_frozen );
+  rkChainABIFreeze( chain, &fz, dis, vel, acc );
+  rkChainABI( chain, dis, vel, acc_exact );
+  if( fz.refresh != 3 || fz.count != 0 || fz.err != 0 ||
+      !zVecIsEqual( acc, acc_exact, zTOL ) ||
+      fabs( fz.acc_err - zVecDist( acc_exact, acc_frozen ) ) > zTOL || zIsTiny( fz.acc_err ) ){
+    eprintf( "not refreshed by the deviation\n" );
+    result = false;
+  }
+  /* the observed error is kept until the next refresh */
+  rkChainABIFreeze( chain, &fz, dis, vel, acc );
+  if( fz.refresh != 3 || fz.count != 1 || fz.err != 0 ||
+      fabs( fz.acc_err - zVecDist( acc_exact, acc_frozen ) ) > zTOL ) result = false;
+  rkABIFreezeDestroy( &fz );
+  zVecFreeAO( 3, acc, acc_exact, acc_frozen );
+  return result;
+}
+
+#define NS 8
+
+bool assert_abi_ens(void)
+{
+  rkJointCom *com[] = { &rk_joint_revol, &rk_joint_prism, &rk_joint_fixed, &rk_joint_revol };
+  rkChain chain;
+  rkABIEns ens;
+  zVec dis[NS], vel[NS], trq[NS], acc, acc_ens;
+  register int i, n;
+  bool result = true;
+
+  chain_init_joint( &chain, N, com, 4 );
+  /* torque motors to drive joints in the regular ABI method */
+  for( i=0; i<rkChainLinkNum(&chain); i++ )
+    if( rkChainLinkJointSize(&chain,i) > 0 ){
+      rkMotorDestroy( rkJointGetMotor(rkChainLinkJoint(&chain,i)) );
+      rkMotorAssign( rkJointGetMotor(rkChainLinkJoint(&chain,i)), &rk_motor_trq );
+    }
+  if( !rkABIEnsCreate( &ens, &chain, NS ) ) return false;
+  for( n=0; n<NS; n++ ){
+    dis[n] = zVecAlloc( rkChainJointSize(&chain) );
+    vel[n] = zVecAlloc( rkChainJointSize(&chain) );
+    trq[n] = zVecAlloc( rkChainJointSize(&chain) );
+    zVecRandUniform( dis[n], -1.0, 1.0 );
+    zVecRandUniform( vel[n], -1.0, 1.0 );
+    zVecRandUniform( trq[n], -1.0, 1.0 );
+    rkABIEnsSetState( &ens, n, dis[n], vel[n], trq[n] );
+  }
+  acc = zVecAlloc( rkChainJointSize(&chain) );
+  acc_ens = zVecAlloc( rkChainJointSize(&chain) );
+  rkABIEnsUpdate( &ens );
+  for( n=0; n<NS; n++ ){
+    for( i=0; i<rkChainLinkNum(&chain); i++ )
+      if( rkChainLinkJointSize(&chain,i) > 0 )
+        rkJointMotorSetInput( rkChainLinkJoint(&chain,i), &zVecElemNC(trq[n],rkChainLinkOffset(&chain,i)) );
+    rkChainABI( &chain, dis[n], vel[n], acc );
+    rkABIEnsGetAcc( &ens, n, acc_ens );
+    if( !zVecIsEqual( acc, acc_ens, zTOL ) ){
+      eprintf( "instance #%d\n", n );
+      result = false;
+    }
+  }
+  for( n=0; n<NS; n++ )
+    zVecFreeAO( 3, dis[n], vel[n], trq[n] );
+  zVecFreeAO( 2, acc, acc_ens );
+  rkABIEnsDestroy( &ens );
+  /* restoring torques are not supported */
+  for( i=0; i<rkChainLinkNum(&chain); i++ )
+    if( rkChainLinkJoint(&chain,i)->com == &rk_joint_revol ){
+      ((rkJointRevolPrp *)rkChainLinkJoint(&chain,i)->prp)->stiffness = 1.0;
+      break;
+    }
+  if( rkABIEnsCreate( &ens, &chain, NS ) ){
+    eprintf( "joint stiffness is accepted\n" );
+    rkABIEnsDestroy( &ens );
+    result = false;
+  }
+  rkChainABIDestroy( &chain );
+  rkChainDestroy( &chain );
+  return result;
+}
+
+bool assert_abi_mt(void)
+{
+  rkChain chain;
+  zVec dis, vel, acc, acc_mt;
+  zVec6D wrench, err;
+  register int i;
+  bool result = true;
+
+  chain_init( &chain, N*4 );
+  dis = zVecAlloc( rkChainJointSize(&chain) );
+  vel = zVecAlloc( rkChainJointSize(&chain) );
+  acc = zVecAlloc( rkChainJointSize(&chain) );
+  acc_mt = zVecAlloc( rkChainJointSize(&chain) );
+  chain_set_rand( &chain, dis, vel );
+  rkChainABIUpdateGetWrench( &chain );
+  rkChainGetJointAccAll( &chain, acc );
+  zVec6DCopy( rkChainLinkWrench(&chain,N), &wrench );
+  for( i=1; i<=4; i++ ){
+    rkChainABIUpdateGetWrenchMT( &chain, i );
+    rkChainGetJointAccAll( &chain, acc_mt );
+    zVec6DSub( &wrench, rkChainLinkWrench(&chain,N), &err );
+    if( !zVecIsEqual( acc, acc_mt, zTOL ) || !zVec6DIsTol( &err, zTOL ) ){
+      eprintf( "number of threads = %d\n", i );
+      result = false;
+    }
+  }
+  /* the pool is created again after termination */
+  rkChainABIPoolDestroy();
+  rkChainABIUpdateGetWrenchMT( &chain, 4 );
+  rkChainGetJointAccAll( &chain, acc_mt );
+  if( !zVecIsEqual( acc, acc_mt, zTOL ) ) result = false;
+  rkChainABIPoolDestroy();
+  zVecFreeAO( 4, dis, vel, acc, acc_mt );
+  rkChainABIDestroy( &chain );
+  rkChainDestroy( &chain );
+  return result;
+}
+
+bool assert_chain_fd(rkChain *chain, zVec dis, zVec vel)
+{
+  rkChainFD fd_euler, fd_rk4;
+  bool result;
+
+  chain_set_rand( chain, dis, vel );
+  zVecMulDRC( vel, 0.1 );
+  rkChainFDCreate( &fd_euler, chain, RK_CHAIN_FD_EULER, 1.0e-6 );
+  rkChainFDCreate( &fd_rk4, chain, RK_CHAIN_FD_RK4, 1.0e-3 );
+  rkChainFDInit( &fd_euler, dis, vel );
+  rkChainFDInit( &fd_rk4, dis, vel );
+  rkChainFDStepN( &fd_euler, 10000 );
+  rkChainFDStepN( &fd_rk4, 10 );
+  result = zVecIsEqual( rkChainFDDis(&fd_euler), rkChainFDDis(&fd_rk4), 1.0e-5 ) &&
+    zVecIsEqual( rkChainFDVel(&fd_euler), rkChainFDVel(&fd_rk4), 1.0e-4 );
+  rkChainFDDestroy( &fd_euler );
+  rkChainFDDestroy( &fd_rk4 );
+  return result;
+}
+
+int main(void)
+{
+  rkChain chain;
+  zVec dis, vel;
+
+  zRandInit();
+  chain_init( &chain, N );
+  dis = zVecAlloc( rkChainJointSize(&chain) );
+  vel = zVecAlloc( rkChainJointSize(&chain) );
+
+  zAssert( rkChainABIContactInvInertiaMat, assert_contact_inv_inertia( &chain, dis, vel ) );
+
+  zAssert( rkChainInvInertiaMat + rkChainInvInertiaMulVec, assert_inv_inertia( &chain, dis, vel ) );
+  zAssert( rkChainLinkOpSpaceInvInertia + rkChainLinkOpSpaceInertia, assert_opspace_inertia( &chain, dis, vel ) );
+  zAssert( rkChainHD, assert_hd( &chain, dis, vel ) );
+  zAssert( rkChainABIUpdateFrozen, assert_abi_frozen( &chain, dis, vel ) );
+  zAssert( rkChainABIFreeze, assert_abi_freeze( &chain, dis, vel ) );
+  zAssert( rkChainABIUpdateMT, assert_abi_mt() );
+  zAssert( rkABIEnsUpdate, assert_abi_ens() );
+  zAssert( rkChainFDStep, assert_chain_fd( &chain, dis, vel ) );
+
+  zVecFreeAO( 2, dis, vel );
+  rkChainABIDestroy( &chain );
+  rkChainDestroy( &chain );
+  return 0;
+}
@@ -0,0 +1,1075 @@
+#include <roki/roki.h>
+
+#define NV 12 /* number of random points to make a polyhedron */
+#define NS 20 /* number of sets of random polyhedra */
+#define NT 50 /* number of random postures of each set */
+
+/* a box shape, which is checked as a primitive */
+zShape3D *shape_box_prim(double d, double w, double h)
+{
+  zShape3D *s;
+  zVec3D c, ax, ay, az;
+
+  if( !( s = zAlloc( zShape3D, 1 ) ) ) return NULL;
+  zVec3DZero( &c );
+  zVec3DCreate( &ax, 1, 0, 0 );
+  zVec3DCreate( &ay, 0, 1, 0 );
+  zVec3DCreate( &az, 0, 0, 1 );
+  return zShape3DBoxCreate( s, &c, &ax, &ay, &az, d, w, h );
+}
+
+/* a box shape converted to a polyhedron, which is checked by GJK algorithm */
+zShape3D *shape_box(double d, double w, double h)
+{
+  zShape3D *s;
+
+  if( ( s = shape_box_prim( d, w, h ) ) ) zShape3DToPH( s );
+  return s;
+}
+
+/* the convex hull of random points */
+zShape3D *shape_rand_ph(double r)
+{
+  zShape3D *s;
+  zVec3D p[NV];
+  zVec3DAddrList vlist;
+  register int i;
+
+  if( !( s = shape_box( 1, 1, 1 ) ) ) return NULL;
+  zPH3DDestroy( zShape3DPH(s) );
+  zListInit( &vlist );
+  for( i=0; i<NV; i++ ){
+    zVec3DCreate( &p[i], zRandF(-r,r), zRandF(-r,r), zRandF(-r,r) );
+    zVec3DAddrListAdd( &vlist, &p[i] );
+  }
+  zCH3DPL( zShape3DPH(s), &vlist );
+  zVec3DAddrListDestroy( &vlist );
+  return s;
+}
+
+/* a kinematic chain of a fixed base and free-floating links */
+void chain_init(rkChain *chain, int n)
+{
+  char name[BUFSIZ];
+  register int i;
+
+  rkChainInit( chain );
+  zArrayAlloc( &chain->link, rkLink, n );
+  for( i=0; i<n; i++ ){
+    sprintf( name, "link#%02d", i );
+    rkLinkInit( rkChainLink(chain,i) );
+    zNameSet( rkChainLink(chain,i), name );
+    rkJointAssign( rkChainLinkJoint(chain,i), i == 0 ? &rk_joint_fixed : &rk_joint_float );
+    if( i > 0 )
+      rkLinkAddChild( rkChainRoot(chain), rkChainLink(chain,i) );
+  }
+  rkChainSetOffset( chain );
+  rkChainUpdateFK( chain );
+}
+
+void chain_destroy(rkChain *chain)
+{
+  zShape3D *s;
+  register int i;
+
+  for( i=0; i<rkChainLinkNum(chain); i++ )
+    while( ( s = rkLinkShapePop( rkChainLink(chain,i) ) ) ){
+      zShape3DDestroy( s );
+      free( s );
+    }
+  rkChainDestroy( chain );
+}
+
+/* move a free-floating link */
+void chain_link_move(rkChain *chain, int i, double x, double y, double z, zVec3D *aa)
+{
+  double dis[6];
+
+  dis[0] = x; dis[1] = y; dis[2] = z;
+  dis[3] = aa ? aa->e[zX] : 0;
+  dis[4] = aa ? aa->e[zY] : 0;
+  dis[5] = aa ? aa->e[zZ] : 0;
+  rkChainLinkJointSetDis( chain, i, dis );
+  rkChainUpdateFK( chain );
+}
+
+/* a detector of a pair of shapes, where the latter is movable */
+bool cd_pair_create(rkCD *cd, rkChain *chain, zShape3D *s0, zShape3D *s1)
+{
+  chain_init( chain, 2 );
+  rkLinkShapePush( rkChainLink(chain,0), s0 );
+  rkLinkShapePush( rkChainLink(chain,1), s1 );
+  chain_link_move( chain, 1, 0, 10, 0, NULL ); /* apart from each other at the registration */
+  rkCDCreate( cd );
+  return rkCDChainReg( cd, chain, RK_CD_CELL_MOVE ) && zListSize(&cd->plist) == 1;
+}
+
+void cd_destroy(rkCD *cd, rkChain *chain)
+{
+  rkCDDestroy( cd );
+  chain_destroy( chain );
+}
+
+/* compare GJK algorithm of rkCD with that of Zeo */
+bool check_gjk(rkCD *cd)
+{
+  rkCDPair *pair;
+  zVec3D p0, p1;
+  bool ans;
+
+  pair = zListHead( &cd->plist );
+  rkCDColChkGJK( cd );
+  rkCDCellUpdatePH( pair->data.cell[0] );
+  rkCDCellUpdatePH( pair->data.cell[1] );
+  ans = zColChkPH3D( &pair->data.cell[0]->data.ph, &pair->data.cell[1]->data.ph, &p0, &p1 );
+  if( pair->data.is_col != ans ) return false;
+  rkCDColChkGJKOnly( cd );
+  return pair->data.is_col == ans;
+}
+
+bool assert_gjk_rand(void)
+{
+  rkChain chain;
+  rkCD cd;
+  zVec3D aa;
+  register int i, j;
+  bool result = true;
+
+  for( i=0; i<NS; i++ ){
+    if( !cd_pair_create( &cd, &chain, shape_rand_ph( 0.5 ), shape_rand_ph( 0.5 ) ) ) return false;
+    for( j=0; j<NT; j++ ){
+      zVec3DCreate( &aa, zRandF(-zPI,zPI), zRandF(-zPI,zPI), zRandF(-zPI,zPI) );
+      chain_link_move( &chain, 1, zRandF(-1,1), zRandF(-1,1), zRandF(-1,1), &aa );
+      if( !check_gjk( &cd ) ) result = false;
+    }
+    cd_destroy( &cd, &chain );
+  }
+  return result;
+}
+
+/* check a posture of a cube against a unit cube at the origin with the expected answer */
+bool check_gjk_cube(zShape3D *s, double x, double y, double z, zVec3D *aa, bool ans)
+{
+  rkChain chain;
+  rkCD cd;
+  bool result;
+
+  if( !cd_pair_create( &cd, &chain, shape_box( 1, 1, 1 ), s ) ) return false;
+  chain_link_move( &chain, 1, x, y, z, aa );
+  result = check_gjk( &cd ) && zListHead(&cd.plist)->data.is_col == ans;
+  cd_destroy( &cd, &chain );
+  return result;
+}
+
+#define GAP 1.0e-4
+
+/* degenerate and touching cases */
+bool assert_gjk_degenerate(void)
+{
+  zVec3D aa;
+  register int i;
+  bool result = true;
+
+  for( i=-1; i<=1; i+=2 ){
+    /* face-face */
+    result = result && check_gjk_cube( shape_box( 1, 1, 1 ), 1+i*GAP, 0, 0, NULL, i < 0 );
+    /* edge-edge in parallel */
+    result = result && check_gjk_cube( shape_box( 1, 1, 1 ), 1+i*GAP, 1+i*GAP, 0, NULL, i < 0 );
+    /* vertex-vertex */
+    result = result && check_gjk_cube( shape_box( 1, 1, 1 ), 1+i*GAP, 1+i*GAP, 1+i*GAP, NULL, i < 0 );
+    /* edge-face */
+    zVec3DCreate( &aa, 0, 0, 0.25*zPI );
+    result = result && check_gjk_cube( shape_box( 1, 1, 1 ), 0.5+sqrt(0.5)+i*GAP, 0, 0, &aa, i < 0 );
+    /* flat plate */
+    result = result && check_gjk_cube( shape_box( 1, 1, 0 ), 0, 0, 0.5+i*GAP, NULL, i < 0 );
+  }
+  /* coincident cubes */
+  result = result && check_gjk_cube( shape_box( 1, 1, 1 ), 0, 0, 0, NULL, true );
+  /* a cube inside another */
+  result = result && check_gjk_cube( shape_box( 0.5, 0.5, 0.5 ), 0.1, -0.1, 0.1, NULL, true );
+  return result;
+}
+
+#define TOL 1.0e-4
+
+/* a bar rotating about its center to sweep a cube */
+bool assert_toi_rot(void)
+{
+  rkChain chain;
+  rkCD cd;
+  rkCDPair *pair;
+  zVec3D aa;
+  double toi;
+  bool result = true;
+
+  /* a cube of 0.2 wide at the origin and a bar of 2 long centered at ( 0, -0.8, 0 ) */
+  if( !cd_pair_create( &cd, &chain, shape_box( 0.2, 0.2, 0.2 ), shape_box( 2, 0.1, 0.1 ) ) ) return false;
+  pair = zListHead( &cd.plist );
+  zVec3DCreate( &aa, 0, 0, 0.25*zPI );
+  chain_link_move( &chain, 1, 0, -0.8, 0, &aa );
+  rkCDColChkTOI( &cd, TOL ); /* start from the posture */
+  /* rotate from 45 to 135 degrees, where the bar is apart from the cube at the both ends */
+  zVec3DCreate( &aa, 0, 0, 0.75*zPI );
+  chain_link_move( &chain, 1, 0, -0.8, 0, &aa );
+  toi = rkCDColChkTOI( &cd, TOL );
+  if( cd.colnum != 1 || toi <= 0 || toi >= 1 ) result = false;
+  rkCDColChkGJK( &cd );
+  if( pair->data.is_col ) result = false;
+  /* apart at the time of impact, and colliding a bit after that */
+  zVec3DCreate( &aa, 0, 0, ( 0.25 + 0.5*toi )*zPI );
+  chain_link_move( &chain, 1, 0, -0.8, 0, &aa );
+  rkCDColChkGJK( &cd );
+  if( pair->data.is_col ) result = false;
+  zVec3DCreate( &aa, 0, 0, ( 0.25 + 0.5*( toi + 0.02 ) )*zPI );
+  chain_link_move( &chain, 1, 0, -0.8, 0, &aa );
+  rkCDColChkGJK( &cd );
+  if( !pair->data.is_col ) result = false;
+  cd_destroy( &cd, &chain );
+  return result;
+}
+
+/* a cube passing through a thin wall */
+bool assert_toi(void)
+{
+  rkChain chain;
+  rkCD cd;
+  rkCDPair *pair;
+  zAABox3D *box;
+  double toi;
+  bool result = true;
+
+  /* a wall of 0.1 thick at the origin and a cube of 0.2 wide */
+  if( !cd_pair_create( &cd, &chain, shape_box( 0.1, 2, 2 ), shape_box( 0.2, 0.2, 0.2 ) ) ) return false;
+  pair = zListHead( &cd.plist );
+  box = &( pair->data.cell[0]->data.link == rkChainLink(&chain,1) ? pair->data.cell[0] : pair->data.cell[1] )->data.aabb;
+  /* move to the front of the wall */
+  chain_link_move( &chain, 1, -1, 0, 0, NULL );
+  if( rkCDColChkTOI( &cd, TOL ) != 1.0 || cd.colnum != 0 ) result = false;
+  /* pass through the wall, which is hit at ( 1 - 0.05 - 0.1 ) / 2 */
+  chain_link_move( &chain, 1, 1, 0, 0, NULL );
+  toi = rkCDColChkTOI( &cd, TOL );
+  if( fabs( toi - 0.425 ) > TOL || cd.colnum != 1 ||
+      pair->data.toi != toi || pair->data.is_col ) result = false;
+  /* the bounding box is not swept after the check */
+  if( fabs( box->min.e[zX] - 0.9 ) > zTOL || fabs( box->max.e[zX] - 1.1 ) > zTOL ) result = false;
+  /* no more hit without motion */
+  if( rkCDColChkTOI( &cd, TOL ) != 1.0 || cd.colnum != 0 || pair->data.toi != 1.0 ) result = false;
+  cd_destroy( &cd, &chain );
+  return result;
+}
+
+/* a cube rotated about an axis by 45 degrees */
+zShape3D *shape_cube_tilt(zAxis axis)
+{
+  zShape3D *s;
+  zVec3D c, aa;
+  zMat3D m;
+
+  if( !( s = zAlloc( zShape3D, 1 ) ) ) return NULL;
+  zVec3DZero( &c );
+  zVec3DZero( &aa );
+  aa.e[axis] = zDeg2Rad( 45 );
+  zMat3DFromAA( &m, &aa );
+  return zShape3DBoxCreate( s, &c, &m.v[zX], &m.v[zY], &m.v[zZ], 1, 1, 1 );
+}
+
+bool assert_prim_boxbox(void)
+{
+  rkChain chain;
+  rkCD cd;
+  rkCDPair *pair;
+  double z0, z1;
+  bool result = true;
+  register int i;
+
+  /* a top edge along x-axis and a bottom edge along y-axis crossing with depth 0.01 */
+  if( !cd_pair_create( &cd, &chain, shape_cube_tilt( zX ), shape_cube_tilt( zY ) ) ) return false;
+  pair = zListHead( &cd.plist );
+  chain_link_move( &chain, 1, 0, 0, 2*sqrt(0.5)-0.01, NULL );
+  rkCDColChkGJK( &cd );
+  if( !pair->data.is_col || cd.stat.prim_test == 0 ) result = false;
+  /* witness points are the closest points of the edges */
+  for( i=0; i<2; i++ )
+    if( !zIsTiny( pair->data.wit[i].e[zX] ) || !zIsTiny( pair->data.wit[i].e[zY] ) ) result = false;
+  z0 = zMin( pair->data.wit[0].e[zZ], pair->data.wit[1].e[zZ] );
+  z1 = zMax( pair->data.wit[0].e[zZ], pair->data.wit[1].e[zZ] );
+  if( fabs( z0 - ( sqrt(0.5) - 0.01 ) ) > zTOL || fabs( z1 - sqrt(0.5) ) > zTOL ) result = false;
+  cd_destroy( &cd, &chain );
+  return result;
+}
+
+#define NVS 64 /* number of vertices of a random spherical polyhedron */
+
+/* the convex hull of random points on a sphere, all of which are vertices */
+zShape3D *shape_rand_sphere(double r)
+{
+  zShape3D *s;
+  zVec3D p[NVS];
+  zVec3DAddrList vlist;
+  register int i;
+
+  if( !( s = shape_box( 1, 1, 1 ) ) ) return NULL;
+  zPH3DDestroy( zShape3DPH(s) );
+  zListInit( &vlist );
+  for( i=0; i<NVS; i++ ){
+    do{
+      zVec3DCreate( &p[i], zRandF(-1,1), zRandF(-1,1), zRandF(-1,1) );
+    } while( zVec3DIsTiny( &p[i] ) );
+    zVec3DNormalizeDRC( &p[i] );
+    zVec3DMulDRC( &p[i], r );
+    zVec3DAddrListAdd( &vlist, &p[i] );
+  }
+  zCH3DPL( zShape3DPH(s), &vlist );
+  zVec3DAddrListDestroy( &vlist );
+  return s;
+}
+
+/* check contact vertices and their projections found with the hierarchies
+   against the linear scan of all vertices and faces */
+bool check_vert_linear(rkCD *cd)
+{
+  rkCDPair *pair;
+  rkCDCell *c0, *c1;
+  rkCDVert *v;
+  zPH3D *ph0, *ph1;
+  zVec3D w, l, c;
+  bool in[NVS];
+  int num;
+  register int s, i;
+
+  pair = zListHead( &cd->plist );
+  for( s=0; s<2; s++ ){
+    c0 = pair->data.cell[s];
+    c1 = pair->data.cell[1-s];
+    ph0 = zShape3DPH(c0->data.shape);
+    ph1 = zShape3DPH(c1->data.shape);
+    if( zPH3DVertNum(ph0) > NVS ) return false;
+    for( num=0, i=0; i<zPH3DVertNum(ph0); i++ ){
+      zXform3D( rkLinkWldFrame(c0->data.link), zPH3DVert(ph0,i), &w );
+      zXform3DInv( rkLinkWldFrame(c1->data.link), &w, &l );
+      if( ( in[i] = zPH3DPointIsInside( ph1, &l, false ) ) ) num++;
+    }
+    zListForEach( &pair->data.vlist, v ){
+      if( v->data.cell != c0 ) continue;
+      if( !in[v->data._id] ) return false;
+      in[v->data._id] = false; /* each vertex is found only once */
+      num--;
+      /* the closest point on the other cell */
+      zXform3DInv( rkLinkWldFrame(c1->data.link), v->data.vert, &l );
+      zPH3DClosest( ph1, &l, &c );
+      zXform3D( rkLinkWldFrame(c1->data.link), &c, &w );
+      if( !zVec3DEqual( &w, &v->data.pro ) ) return false;
+    }
+    if( num != 0 ) return false;
+  }
+  return true;
+}
+
+/* culling of vertices and faces with the hierarchies against the linear scan */
+bool assert_vert_bvh(void)
+{
+  rkChain chain;
+  rkCD cd;
+  zVec3D aa;
+  register int i, j;
+  bool result = true;
+
+  for( i=0; i<NS; i++ ){
+    if( !cd_pair_create( &cd, &chain, shape_rand_sphere( 0.5 ), shape_rand_sphere( 0.5 ) ) ) return false;
+    for( j=0; j<NT; j++ ){
+      /* release contact vertices so that projections are not inherited from the previous step */
+      chain_link_move( &chain, 1, 0, 10, 0, NULL );
+      rkCDColChkVert( &cd );
+      zVec3DCreate( &aa, zRandF(-zPI,zPI), zRandF(-zPI,zPI), zRandF(-zPI,zPI) );
+      chain_link_move( &chain, 1, zRandF(-0.8,0.8), zRandF(-0.8,0.8), zRandF(-0.8,0.8), &aa );
+      rkCDColChkVert( &cd );
+      if( !check_vert_linear( &cd ) ) result = false;
+    }
+    /* some vertices and faces are culled */
+    if( cd.stat.vert_test >= cd.stat.vert_cand || cd.stat.face_test >= cd.stat.face_cand ) result = false;
+    cd_destroy( &cd, &chain );
+  }
+  return result;
+}
+
+#define NREST 20 /* number of steps in resting contact */
+
+/* history of a contact vertex */
+typedef struct{
+  rkCDCell *cell;
+  int id;
+  rkContactFricType type;
+  zVec3D ref;
+} vert_hist;
+
+/* stick/slip modes and referential points of contact vertices of a polyhedron
+   resting on a floor are inherited over steps */
+bool assert_vert_hist(void)
+{
+  rkChain chain;
+  rkCD cd;
+  rkCDPair *pair;
+  rkCDVert *v;
+  zShape3D *s;
+  vert_hist hist[2*NVS];
+  zVec3D aa, ref;
+  double zmin = 0;
+  int histnum = 0, found = 0;
+  register int i, j;
+  bool result = true;
+
+  if( !( s = shape_rand_sphere( 0.5 ) ) ) return false;
+  for( i=0; i<zShape3DVertNum(s); i++ )
+    zmin = zMin( zmin, zShape3DVert(s,i)->e[zZ] );
+  if( !cd_pair_create( &cd, &chain, shape_box( 2, 2, 0.2 ), s ) ) return false;
+  pair = zListHead( &cd.plist );
+  for( i=0; i<NREST; i++ ){
+    /* sink into the floor by 0.02 with a small wobble */
+    zVec3DCreate( &aa, zRandF(-0.05,0.05), zRandF(-0.05,0.05), zRandF(-0.05,0.05) );
+    chain_link_move( &chain, 1, zRandF(-0.01,0.01), zRandF(-0.01,0.01), 0.12-zmin, &aa );
+    rkCDColChkVert( &cd );
+    if( !pair->data.is_col ) result = false;
+    zListForEach( &pair->data.vlist, v ){
+      /* linear lookup of the history */
+      for( j=0; j<histnum; j++ )
+        if( hist[j].cell == v->data.cell && hist[j].id == v->data._id ) break;
+      if( j < histnum ){
+        found++;
+        zXform3D( rkLinkWldFrame(pair->data.cell[pair->data.cell[0] == v->data.cell ? 1 : 0]->data.link), &hist[j].ref, &ref );
+        if( v->data.type != hist[j].type ||
+            !zVec3DEqual( &v->data._ref, &hist[j].ref ) ||
+            !zVec3DEqual( &v->data.ref, &ref ) ) result = false;
+      } else
+      if( v->data.type != cd.def_type ) result = false;
+    }
+    /* modes and referential points are updated as done by a contact solver */
+    histnum = 0;
+    zListForEach( &pair->data.vlist, v ){
+      if( histnum == 2*NVS ) break;
+      v->data.type = v->data._id % 2 ? RK_CONTACT_KF : RK_CONTACT_SF;
+      v->data._ref.e[zX] += 0.001 * ( v->data._id + 1 );
+      hist[histnum].cell = v->data.cell;
+      hist[histnum].id = v->data._id;
+      hist[histnum].type = v->data.type;
+      zVec3DCopy( &v->data._ref, &hist[histnum++].ref );
+    }
+  }
+  if( found == 0 ) result = false;
+  cd_destroy( &cd, &chain );
+  return result;
+}
+
+#define NPL 4 /* number of contact planes */
+
+/* contact planes of a pair are recycled after a reset */
+bool assert_plane_alloc(void)
+{
+  rkChain chain;
+  rkCD cd;
+  rkCDPair *pair;
+  rkCDPlane *plane[NPL], *p;
+  register int i, j;
+  bool result = true;
+
+  if( !cd_pair_create( &cd, &chain, shape_box( 1, 1, 1 ), shape_box( 1, 1, 1 ) ) ) return false;
+  pair = zListHead( &cd.plist );
+  chain_link_move( &chain, 1, 0.5, 0, 0, NULL );
+  rkCDColChkAABB( &cd );
+  for( i=0; i<NPL; i++ ){
+    if( !( plane[i] = rkCDPlaneAlloc( &cd ) ) ){
+      result = false;
+      goto TERMINATE;
+    }
+    zListInsertHead( &pair->data.cplane, plane[i] );
+  }
+  /* planes are released to the pool, and reallocated from it */
+  rkCDColChkAABB( &cd );
+  if( !zListIsEmpty( &pair->data.cplane ) || zListSize( &cd._ppool ) != NPL ) result = false;
+  for( i=0; i<NPL; i++ ){
+    if( !( p = rkCDPlaneAlloc( &cd ) ) ){
+      result = false;
+      goto TERMINATE;
+    }
+    zListInsertHead( &pair->data.cplane, p );
+    for( j=0; j<NPL; j++ )
+      if( p == plane[j] ) break;
+    if( j == NPL ) result = false;
+  }
+  if( !zListIsEmpty( &cd._ppool ) ) result = false;
+ TERMINATE:
+  cd_destroy( &cd, &chain );
+  return result;
+}
+
+#define NPRIM 20   /* number of random samples of each pair of primitives */
+#define DIV 32     /* number of divisions to convert a round primitive to a polyhedron */
+#define MARGIN 0.02 /* margin for errors of polyhedra inscribed in primitives */
+
+/* specification of a primitive shape */
+typedef struct{
+  rkCDPrimType type;
+  zVec3D c[2];  /* center or centers of the both ends */
+  zMat3D m;     /* attitude of a box */
+  double l[3];  /* lengths of a box */
+  double r;     /* radius */
+} prim_spec;
+
+zShape3D *shape_prim(prim_spec *spec)
+{
+  zShape3D *s;
+
+  if( !( s = zAlloc( zShape3D, 1 ) ) ) return NULL;
+  switch( spec->type ){
+  case RK_CD_PRIM_SPHERE:   return zShape3DSphereCreate( s, &spec->c[0], spec->r, DIV );
+  case RK_CD_PRIM_CAPSULE:  return zShape3DCapsuleCreate( s, &spec->c[0], &spec->c[1], spec->r, DIV );
+  case RK_CD_PRIM_CYLINDER: return zShape3DCylCreate( s, &spec->c[0], &spec->c[1], spec->r, DIV );
+  default: ;
+  }
+  return zShape3DBoxCreate( s, &spec->c[0], &spec->m.v[zX], &spec->m.v[zY], &spec->m.v[zZ], spec->l[0], spec->l[1], spec->l[2] );
+}
+
+/* a primitive converted to a polyhedron inscribed in it */
+zShape3D *shape_prim_ph(prim_spec *spec)
+{
+  zShape3D *s;
+
+  if( ( s = shape_prim( spec ) ) ) zShape3DToPH( s );
+  return s;
+}
+
+/* check if polyhedra collide with the former translated by d along a direction u */
+bool check_prim_ph(rkCD *cd, rkChain *chain, zVec3D *u, double d)
+{
+  /* the latter is translated in the opposite direction instead */
+  chain_link_move( chain, 1, -d*u->e[zX], -d*u->e[zY], -d*u->e[zZ], NULL );
+  rkCDColChkGJKOnly( cd );
+  return zListHead(&cd->plist)->data.is_col;
+}
+
+/* check the closed-form test of a pair of primitives against GJK algorithm on inscribed polyhedra */
+bool check_prim(prim_spec *p0, prim_spec *p1)
+{
+  rkChain chain, chain_ph;
+  rkCD cd, cd_ph;
+  rkCDPair *pair;
+  zVec3D n, u;
+  double depth, eps;
+  register int i;
+  bool result;
+
+  result = cd_pair_create( &cd, &chain, shape_prim( p0 ), shape_prim( p1 ) );
+  if( !cd_pair_create( &cd_ph, &chain_ph, shape_prim_ph( p0 ), shape_prim_ph( p1 ) ) || !result ){
+    result = false;
+    goto TERMINATE;
+  }
+  pair = zListHead( &cd.plist );
+  chain_link_move( &chain, 1, 0, 0, 0, NULL );
+  rkCDColChkGJKOnly( &cd );
+  if( cd.stat.prim_test == 0 ) result = false;
+  if( !pair->data.is_col ){ /* inscribed polyhedra never collide either */
+    zVec3DZero( &u );
+    if( check_prim_ph( &cd_ph, &chain_ph, &u, 0 ) ) result = false;
+    goto TERMINATE;
+  }
+  /* depth along the normal from the latter to the former */
+  zVec3DCopy( &pair->data.norm, &n );
+  zVec3DSub( &pair->data.wit[1], &pair->data.wit[0], &u );
+  depth = zVec3DInnerProd( &u, &n );
+  if( !zIsTiny( zVec3DNorm( &n ) - 1 ) || depth < -zTOL ) result = false;
+  eps = ( p0->type == RK_CD_PRIM_BOX && p1->type == RK_CD_PRIM_BOX ? 0 : MARGIN ) + TOL;
+  if( depth <= eps ) goto TERMINATE;
+  /* the former is pushed out along the normal by the depth, and never by a shorter translation */
+  if( !check_prim_ph( &cd_ph, &chain_ph, &n, 0 ) ||
+      !check_prim_ph( &cd_ph, &chain_ph, &n, depth-eps ) ||
+       check_prim_ph( &cd_ph, &chain_ph, &n, depth+eps ) ) result = false;
+  for( i=0; i<4; i++ ){
+    zVec3DCreate( &u, zRandF(-1,1), zRandF(-1,1), zRandF(-1,1) );
+    if( zVec3DIsTiny( &u ) ) continue;
+    zVec3DNormalizeDRC( &u );
+    if( !check_prim_ph( &cd_ph, &chain_ph, &u, depth-eps ) ) result = false;
+  }
+ TERMINATE:
+  cd_destroy( &cd_ph, &chain_ph );
+  cd_destroy( &cd, &chain );
+  return result;
+}
+
+/* check a pair of primitives in the both orders */
+bool check_prim_pair(prim_spec *p0, prim_spec *p1)
+{
+  return check_prim( p0, p1 ) && check_prim( p1, p0 );
+}
+
+void prim_rand_rot(zMat3D *m)
+{
+  zVec3D aa;
+
+  zVec3DCreate( &aa, zRandF(-zPI,zPI), zRandF(-zPI,zPI), zRandF(-zPI,zPI) );
+  zMat3DFromAA( m, &aa );
+}
+
+void prim_sphere(prim_spec *spec, zVec3D *c, double r)
+{
+  spec->type = RK_CD_PRIM_SPHERE;
+  zVec3DCopy( c, &spec->c[0] );
+  zVec3DCopy( c, &spec->c[1] );
+  spec->r = r;
+}
+
+/* a capsule or a cylinder along the z-axis of an attitude */
+void prim_swept(prim_spec *spec, rkCDPrimType type, zVec3D *c, zMat3D *m, double len, double r)
+{
+  spec->type = type;
+  zVec3DCat( c, -0.5*len, &m->v[zZ], &spec->c[0] );
+  zVec3DCat( c,  0.5*len, &m->v[zZ], &spec->c[1] );
+  spec->r = r;
+}
+
+void prim_box(prim_spec *spec, zMat3D *m, double d, double w, double h)
+{
+  spec->type = RK_CD_PRIM_BOX;
+  zVec3DZero( &spec->c[0] );
+  zVec3DZero( &spec->c[1] );
+  zMat3DCopy( m, &spec->m );
+  spec->l[0] = d; spec->l[1] = w; spec->l[2] = h;
+}
+
+/* a point in the frame of a box or a cylinder at the origin */
+void prim_point(zMat3D *m, double x, double y, double z, zVec3D *p)
+{
+  zVec3D pl;
+
+  zVec3DCreate( &pl, x, y, z );
+  zMulMat3DVec3D( m, &pl, p );
+}
+
+#define prim_rand_vec(v,r) zVec3DCreate( v, zRandF(-(r),r), zRandF(-(r),r), zRandF(-(r),r) )
+
+/* closed-form tests of primitives against GJK algorithm on polyhedra */
+bool assert_prim_closed(void)
+{
+  prim_spec p0, p1;
+  zMat3D m;
+  zVec3D c, pl;
+  double r, l, rc, rr, th, z;
+  register int i, k;
+  bool result = true;
+
+  for( i=0; i<NPRIM; i++ ){
+    /* sphere-sphere */
+    prim_rand_vec( &c, 0.5 );
+    prim_sphere( &p0, &c, zRandF(0.2,0.5) );
+    prim_rand_vec( &c, 0.5 );
+    prim_sphere( &p1, &c, zRandF(0.2,0.5) );
+    if( !check_prim_pair( &p0, &p1 ) ) result = false;
+    /* capsule-capsule and sphere-capsule */
+    prim_rand_vec( &c, 0.3 );
+    prim_rand_rot( &m );
+    prim_swept( &p0, RK_CD_PRIM_CAPSULE, &c, &m, zRandF(0.2,1.0), zRandF(0.1,0.3) );
+    prim_rand_vec( &c, 0.3 );
+    prim_rand_rot( &m );
+    prim_swept( &p1, RK_CD_PRIM_CAPSULE, &c, &m, zRandF(0.2,1.0), zRandF(0.1,0.3) );
+    if( !check_prim_pair( &p0, &p1 ) ) result = false;
+    prim_rand_vec( &c, 0.5 );
+    prim_sphere( &p1, &c, zRandF(0.1,0.3) );
+    if( !check_prim_pair( &p0, &p1 ) ) result = false;
+    /* sphere-box with the center inside and outside the box */
+    prim_rand_rot( &m );
+    prim_box( &p0, &m, zRandF(0.4,1.0), zRandF(0.4,1.0), zRandF(0.4,1.0) );
+    r = zRandF(0.1,0.3);
+    prim_point( &m, 0.45*zRandF(-1,1)*p0.l[0], 0.45*zRandF(-1,1)*p0.l[1], 0.45*zRandF(-1,1)*p0.l[2], &c );
+    prim_sphere( &p1, &c, r );
+    if( !check_prim_pair( &p0, &p1 ) ) result = false;
+    do{
+      for( k=zX; k<=zZ; k++ )
+        pl.e[k] = zRandF(-1,1) * ( 0.5*p0.l[k] + r + 0.1 );
+    } while( fabs(pl.e[zX]) <= 0.5*p0.l[0] && fabs(pl.e[zY]) <= 0.5*p0.l[1] && fabs(pl.e[zZ]) <= 0.5*p0.l[2] );
+    prim_point( &m, pl.e[zX], pl.e[zY], pl.e[zZ], &c );
+    prim_sphere( &p1, &c, r );
+    if( !check_prim_pair( &p0, &p1 ) ) result = false;
+    /* sphere-cylinder beside the side, on the caps and inside */
+    prim_rand_rot( &m );
+    zVec3DZero( &c );
+    l = zRandF(0.4,1.0);
+    rc = zRandF(0.2,0.5);
+    prim_swept( &p0, RK_CD_PRIM_CYLINDER, &c, &m, l, rc );
+    r = zRandF(0.1,0.3);
+    th = zRandF(-zPI,zPI);
+    rr = zRandF(rc,rc+r+0.1);
+    z = zRandF(-0.4,0.4) * l;
+    prim_point( &m, rr*cos(th), rr*sin(th), z, &c );
+    prim_sphere( &p1, &c, r );
+    if( !check_prim_pair( &p0, &p1 ) ) result = false;
+    rr = zRandF(0,0.9) * rc;
+    z = ( zRandI(0,1) ? 1 : -1 ) * zRandF(0.5*l,0.5*l+r+0.1);
+    prim_point( &m, rr*cos(th), rr*sin(th), z, &c );
+    prim_sphere( &p1, &c, r );
+    if( !check_prim_pair( &p0, &p1 ) ) result = false;
+    rr = zRandF(0,0.95) * rc;
+    z = zRandF(-0.45,0.45) * l;
+    prim_point( &m, rr*cos(th), rr*sin(th), z, &c );
+    prim_sphere( &p1, &c, r );
+    if( !check_prim_pair( &p0, &p1 ) ) result = false;
+    /* box-box */
+    prim_rand_rot( &m );
+    prim_box( &p0, &m, zRandF(0.4,1.0), zRandF(0.4,1.0), zRandF(0.4,1.0) );
+    prim_rand_rot( &m );
+    prim_box( &p1, &m, zRandF(0.4,1.0), zRandF(0.4,1.0), zRandF(0.4,1.0) );
+    prim_rand_vec( &p1.c[0], 0.8 );
+    if( !check_prim_pair( &p0, &p1 ) ) result = false;
+  }
+  return result;
+}
+
+#define NL 8 /* number of free-floating links */
+#define NP 10 /* number of postures */
+#define NTHREAD 4
+
+/* a scene of a floor and free-floating boxes and polyhedra */
+bool cd_scene_create(rkCD *cd, rkChain *chain, bool defer)
+{
+  register int i;
+
+  chain_init( chain, NL+1 );
+  rkLinkShapePush( rkChainRoot(chain), shape_box_prim( 3, 3, 0.2 ) );
+  for( i=1; i<=NL; i++ ){
+    rkLinkShapePush( rkChainLink(chain,i), i % 2 ?
+      shape_box_prim( zRandF(0.3,0.6), zRandF(0.3,0.6), zRandF(0.3,0.6) ) : shape_rand_ph( 0.3 ) );
+    chain_link_move( chain, i, 2*i, 10, 0, NULL ); /* apart from each other at the registration */
+  }
+  rkCDCreate( cd );
+  return ( defer ? rkCDChainRegDefer( cd, chain, RK_CD_CELL_MOVE, NULL ) :
+                   rkCDChainReg( cd, chain, RK_CD_CELL_MOVE ) ) != NULL;
+}
+
+/* results of collision check to be compared */
+typedef struct{
+  int colnum;
+  int pairnum;
+  bool *is_col;
+  int *vnum;     /* numbers of contact vertices of colliding pairs */
+  int *cvnum;    /* numbers of vertices of collision volumes of colliding pairs */
+  int vertnum;
+  zVec3D *vert;  /* contact vertices */
+  zVec3D *pro;   /* projections of contact vertices */
+} cd_result;
+
+void cd_result_destroy(cd_result *res)
+{
+  zFree( res->is_col );
+  zFree( res->vnum );
+  zFree( res->cvnum );
+  zFree( res->vert );
+  zFree( res->pro );
+}
+
+bool cd_result_create(cd_result *res, rkCD *cd)
+{
+  rkCDPair *pair;
+  rkCDVert *v;
+  register int i = 0, j = 0;
+
+  res->colnum = cd->colnum;
+  res->pairnum = zListSize( &cd->plist );
+  res->vertnum = 0;
+  zListForEach( &cd->plist, pair )
+    if( pair->data.is_col ) res->vertnum += zListSize( &pair->data.vlist );
+  res->is_col = zAlloc( bool, zMax( res->pairnum, 1 ) );
+  res->vnum = zAlloc( int, zMax( res->pairnum, 1 ) );
+  res->cvnum = zAlloc( int, zMax( res->pairnum, 1 ) );
+  res->vert = zAlloc( zVec3D, zMax( res->vertnum, 1 ) );
+  res->pro = zAlloc( zVec3D, zMax( res->vertnum, 1 ) );
+  if( !res->is_col || !res->vnum || !res->cvnum || !res->vert || !res->pro ){
+    cd_result_destroy( res );
+    return false;
+  }
+  zListForEach( &cd->plist, pair ){
+    if( ( res->is_col[i] = pair->data.is_col ) ){
+      res->vnum[i] = zListSize( &pair->data.vlist );
+      res->cvnum[i] = zPH3DVertNum( &pair->data.colvol );
+      zListForEach( &pair->data.vlist, v ){
+        zVec3DCopy( v->data.vert, &res->vert[j] );
+        zVec3DCopy( &v->data.pro, &res->pro[j++] );
+      }
+    }
+    i++;
+  }
+  return true;
+}
+
+/* compare the current result of a collision detector with the previous one pair by pair */
+bool cd_result_cmp(cd_result *res, rkCD *cd)
+{
+  rkCDPair *pair;
+  rkCDVert *v;
+  register int i = 0, j = 0;
+
+  if( cd->colnum != res->colnum || zListSize(&cd->plist) != res->pairnum ) return false;
+  zListForEach( &cd->plist, pair ){
+    if( pair->data.is_col != res->is_col[i] ) return false;
+    if( pair->data.is_col ){
+      if( zListSize(&pair->data.vlist) != res->vnum[i] ||
+          zPH3DVertNum(&pair->data.colvol) != res->cvnum[i] ) return false;
+      zListForEach( &pair->data.vlist, v ){
+        if( !zVec3DEqual( v->data.vert, &res->vert[j] ) ||
+            !zVec3DEqual( &v->data.pro, &res->pro[j] ) ) return false;
+        j++;
+      }
+    }
+    i++;
+  }
+  return true;
+}
+
+/* collision checks with one and multiple threads on the same scene */
+bool assert_colchk_mt(void)
+{
+  void (*colchk[])(rkCD*) = {
+    rkCDColChkAABB, rkCDColChkOBB, rkCDColChkGJK, rkCDColChkVert, rkCDColChkOBBVert,
+    rkCDColChkGJKOnly,
+    rkCDColVol, rkCDColVolBREP, rkCDColVolBREPFast, rkCDColVolBREPVert,
+    NULL,
+  };
+  rkChain chain;
+  rkCD cd;
+  cd_result res;
+  zVec3D aa;
+  register int i, j, k;
+  bool result = true;
+
+  if( !cd_scene_create( &cd, &chain, false ) ) return false;
+  for( i=0; i<NP; i++ ){
+    for( j=1; j<=NL; j++ ){
+      zVec3DCreate( &aa, zRandF(-zPI,zPI), zRandF(-zPI,zPI), zRandF(-zPI,zPI) );
+      chain_link_move( &chain, j, zRandF(-0.5,0.5), zRandF(-0.5,0.5), zRandF(0,0.3), &aa );
+    }
+    for( k=0; colchk[k]; k++ ){
+      rkCDSetThreadNum( &cd, 1 );
+      colchk[k]( &cd );
+      if( !cd_result_create( &res, &cd ) ){
+        result = false;
+        break;
+      }
+      rkCDSetThreadNum( &cd, NTHREAD );
+      colchk[k]( &cd );
+      if( !cd_result_cmp( &res, &cd ) ) result = false;
+      cd_result_destroy( &res );
+    }
+  }
+  cd_destroy( &cd, &chain );
+  return result;
+}
+
+#define NSTEP 50 /* number of steps of motion */
+
+/* check if the candidates of the broad phase are the pairs of overlapping bounding boxes */
+bool check_sap(rkCD *cd, rkChain *chain)
+{
+  bool cand[NL+1][NL+1];
+  rkCDCell *cell;
+  zBox3D obb;
+  zAABox3D aabb[NL+1];
+  int i0, i1;
+  register int i, j;
+
+  for( i=0; i<=NL; i++ )
+    for( j=0; j<=NL; j++ ) cand[i][j] = false;
+  for( i=0; i<cd->candnum; i++ ){
+    i0 = cd->cand[i]->data.cell[0]->data.link - rkChainRoot(chain);
+    i1 = cd->cand[i]->data.cell[1]->data.link - rkChainRoot(chain);
+    if( !cd->cand[i]->data.is_col || cand[i0][i1] ) return false;
+    cand[i0][i1] = cand[i1][i0] = true;
+  }
+  /* all pairs of bounding boxes are tested */
+  zListForEach( &cd->clist, cell ){
+    zBox3DXform( &cell->data.bb, rkLinkWldFrame(cell->data.link), &obb );
+    zBox3DToAABox3D( &obb, &aabb[cell->data.link - rkChainRoot(chain)] );
+  }
+  for( i=0; i<=NL; i++ )
+    for( j=i+1; j<=NL; j++ )
+      if( zColChkAABox3D( &aabb[i], &aabb[j] ) != cand[i][j] ) return false;
+  return true;
+}
+
+/* sweep-and-prune against the brute-force test over continuous motion of links */
+bool assert_sap(void)
+{
+  rkChain chain;
+  rkCD cd;
+  zVec3D pos[NL+1], aa[NL+1];
+  register int i, j, k;
+  bool result = true;
+  int defer;
+
+  for( defer=0; defer<2; defer++ ){
+    if( !cd_scene_create( &cd, &chain, defer ) ) return false;
+    for( j=1; j<=NL; j++ ){
+      zVec3DCreate( &pos[j], zRandF(-1,1), zRandF(-1,1), zRandF(0,0.5) );
+      zVec3DCreate( &aa[j], zRandF(-zPI,zPI), zRandF(-zPI,zPI), zRandF(-zPI,zPI) );
+    }
+    for( i=0; i<NSTEP; i++ ){
+      for( j=1; j<=NL; j++ ){
+        /* small moves with occasional jumps */
+        for( k=zX; k<=zZ; k++ ){
+          pos[j].e[k] += i % 10 == 9 ? zRandF(-0.5,0.5) : zRandF(-0.05,0.05);
+          aa[j].e[k] += zRandF(-0.1,0.1);
+        }
+        chain_link_move( &chain, j, pos[j].e[zX], pos[j].e[zY], pos[j].e[zZ], &aa[j] );
+      }
+      rkCDColChkAABB( &cd );
+      if( !check_sap( &cd, &chain ) ) result = false;
+    }
+    cd_destroy( &cd, &chain );
+  }
+  return result;
+}
+
+#define CACHEFILE "cd_test.cache"
+#define CACHESIZE 0x10000
+
+/* a chain of free-floating links, where the (2k-1)-th and 2k-th links overlap at the registration */
+void chain_defer_init(rkChain *chain)
+{
+  register int i;
+
+  chain_init( chain, NL+1 );
+  rkLinkShapePush( rkChainRoot(chain), shape_box( 3, 3, 0.2 ) );
+  for( i=1; i<=NL; i++ ){
+    rkLinkShapePush( rkChainLink(chain,i), i % 2 ? shape_box( 0.5, 0.5, 0.5 ) : shape_rand_ph( 0.3 ) );
+    chain_link_move( chain, i, 2*((i+1)/2), 10, 0, NULL );
+  }
+}
+
+/* colliding pairs of links, each of which has a shape */
+void cd_col_mat(rkCD *cd, rkChain *chain, bool col[NL+1][NL+1])
+{
+  rkCDPair *pair;
+  int i0, i1;
+  register int i, j;
+
+  for( i=0; i<=NL; i++ )
+    for( j=0; j<=NL; j++ ) col[i][j] = false;
+  zListForEach( &cd->plist, pair ){
+    if( !pair->data.is_col ) continue;
+    i0 = pair->data.cell[0]->data.link - rkChainRoot(chain);
+    i1 = pair->data.cell[1]->data.link - rkChainRoot(chain);
+    col[i0][i1] = col[i1][i0] = true;
+  }
+}
+
+/* compare colliding pairs of links found by two collision detectors */
+bool cd_col_cmp(rkCD *cd1, rkCD *cd2, rkChain *chain)
+{
+  bool col1[NL+1][NL+1], col2[NL+1][NL+1];
+  register int i, j;
+
+  if( cd1->colnum != cd2->colnum ) return false;
+  cd_col_mat( cd1, chain, col1 );
+  cd_col_mat( cd2, chain, col2 );
+  for( i=0; i<=NL; i++ )
+    for( j=0; j<=NL; j++ )
+      if( col1[i][j] != col2[i][j] ) return false;
+  return true;
+}
+
+/* check if the cache file has the same contents with a buffer */
+bool cache_cmp(char *buf, int n)
+{
+  static char cur[CACHESIZE];
+  FILE *fp;
+  int m;
+
+  if( !( fp = fopen( CACHEFILE, "r" ) ) ) return false;
+  m = fread( cur, 1, CACHESIZE, fp );
+  fclose( fp );
+  return m == n && memcmp( cur, buf, n ) == 0;
+}
+
+/* deferred registration against the eager one, and the cache of the permanent collision test */
+bool assert_chainreg_defer(void)
+{
+  static char buf[CACHESIZE];
+  rkChain chain;
+  rkCD cd, cd_defer, cd_cache, cd_reject;
+  zShape3D *s;
+  zVec dis;
+  zVec3D aa;
+  FILE *fp;
+  int exclnum, n = 0;
+  register int i, j;
+  bool result = true;
+
+  chain_defer_init( &chain );
+  dis = zVecAlloc( rkChainJointSize(&chain) );
+  rkChainGetJointDisAll( &chain, dis );
+  rkCDCreate( &cd );
+  rkCDCreate( &cd_defer );
+  rkCDCreate( &cd_cache );
+  remove( CACHEFILE );
+  if( !dis || !rkCDChainReg( &cd, &chain, RK_CD_CELL_MOVE ) ||
+      !rkCDChainRegDefer( &cd_defer, &chain, RK_CD_CELL_MOVE, CACHEFILE ) ||
+      !( fp = fopen( CACHEFILE, "r" ) ) ){
+    result = false;
+    goto TERMINATE;
+  }
+  n = fread( buf, 1, CACHESIZE, fp );
+  fclose( fp );
+  /* pairs in permanent collision are excluded, and no pairs are created yet */
+  if( ( exclnum = cd_defer._exclnum ) == 0 || !zListIsEmpty( &cd_defer.plist ) ) result = false;
+  /* the cache is accepted as it is */
+  if( !rkCDChainRegDefer( &cd_cache, &chain, RK_CD_CELL_MOVE, CACHEFILE ) ||
+      cd_cache._exclnum != exclnum || !cache_cmp( buf, n ) ) result = false;
+  for( i=0; i<NP; i++ ){
+    for( j=1; j<=NL; j++ ){
+      zVec3DCreate( &aa, zRandF(-zPI,zPI), zRandF(-zPI,zPI), zRandF(-zPI,zPI) );
+      chain_link_move( &chain, j, zRandF(-0.5,0.5), zRandF(-0.5,0.5), zRandF(0,0.3), &aa );
+    }
+    rkCDColChkGJK( &cd );
+    rkCDColChkGJK( &cd_defer );
+    rkCDColChkGJK( &cd_cache );
+    if( !cd_col_cmp( &cd, &cd_defer, &chain ) || !cd_col_cmp( &cd, &cd_cache, &chain ) ) result = false;
+  }
+  /* the cache is rejected and rewritten at another posture */
+  rkCDCreate( &cd_reject );
+  if( !rkCDChainRegDefer( &cd_reject, &chain, RK_CD_CELL_MOVE, CACHEFILE ) || cache_cmp( buf, n ) ) result = false;
+  rkCDDestroy( &cd_reject );
+  /* the same cache is written again at the original posture */
+  rkChainFK( &chain, dis );
+  rkCDCreate( &cd_reject );
+  if( !rkCDChainRegDefer( &cd_reject, &chain, RK_CD_CELL_MOVE, CACHEFILE ) ||
+      cd_reject._exclnum != exclnum || !cache_cmp( buf, n ) ) result = false;
+  rkCDDestroy( &cd_reject );
+  /* the cache is rejected for an enlarged shape */
+  s = zListHead( rkLinkShapeList(rkChainLink(&chain,1)) )->data;
+  for( i=0; i<zShape3DVertNum(s); i++ )
+    zVec3DMulDRC( zShape3DVert(s,i), 1.1 );
+  rkCDCreate( &cd_reject );
+  if( !rkCDChainRegDefer( &cd_reject, &chain, RK_CD_CELL_MOVE, CACHEFILE ) || cache_cmp( buf, n ) ) result = false;
+  rkCDDestroy( &cd_reject );
+
+ TERMINATE:
+  remove( CACHEFILE );
+  zVecFree( dis );
+  rkCDDestroy( &cd_cache );
+  rkCDDestroy( &cd_defer );
+  cd_destroy( &cd, &chain );
+  return result;
+}
+
+int main(void)
+{
+  zRandInit();
+  zAssert( rkCDColChkGJK (random polyhedra), assert_gjk_rand() );
+  zAssert( rkCDColChkGJK (degenerate cases), assert_gjk_degenerate() );
+  zAssert( rkCDColChkTOI, assert_toi() );
+  zAssert( rkCDColChkTOI (rotation), assert_toi_rot() );
+  zAssert( rkCDColChkGJK (edges of boxes), assert_prim_boxbox() );
+  zAssert( rkCDColChkGJK (closed-form tests of primitives), assert_prim_closed() );
+  zAssert( rkCDColChkVert (hierarchies of vertices and faces), assert_vert_bvh() );
+  zAssert( rkCDColChkVert (history of contact vertices), assert_vert_hist() );
+  zAssert( rkCDPlaneAlloc, assert_plane_alloc() );
+  zAssert( rkCDSetThreadNum, assert_colchk_mt() );
+  zAssert( rkCDColChkAABB (sweep-and-prune), assert_sap() );
+  zAssert( rkCDChainRegDefer, assert_chainreg_defer() );
+  return 0;
+}
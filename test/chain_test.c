@@ -79,6 +79,85 @@ bool check_fd(rkChain *chain, zMat inertia, zVec bias, zVec vel, double tol)
   return ret;
 }
 
+bool check_coriolis(rkChain *chain, zVec bias, zVec dis, zVec vel, double dt, double tol)
+{
+  zMat c, m1, m2;
+  zVec g, d;
+  int n;
+  bool ret;
+
+  n = rkChainJointSize( chain );
+  c = zMatAllocSqr( n );
+  m1 = zMatAllocSqr( n );
+  m2 = zMatAllocSqr( n );
+  g = zVecAlloc( n );
+  d = zVecAlloc( n );
+  rkChainCoriolisMat( chain, c );
+  /* velocity-dependent part of the bias force */
+  zMulMatVec( c, vel, d );
+  rkChainSetJointVelAll( chain, NULL );
+  rkChainInertiaMatBiasVec( chain, m1, g );
+  zVecAddDRC( d, g );
+  ret = zVecIsEqual( d, bias, tol );
+  /* skew-symmetry of Mdot - 2C */
+  zVecCopy( dis, d );
+  rkChainCatJointDisAll( chain, d, dt, vel );
+  rkChainFK( chain, d );
+  rkChainInertiaMatBiasVec( chain, m1, g );
+  zVecCopy( dis, d );
+  rkChainCatJointDisAll( chain, d, -dt, vel );
+  rkChainFK( chain, d );
+  rkChainInertiaMatBiasVec( chain, m2, g );
+  zMatSubDRC( m1, m2 );
+  zMatMulDRC( m1, 0.5/dt );
+  zMatT( c, m2 );
+  zMatAddDRC( m2, c );
+  if( !zMatIsEqual( m1, m2, tol ) ) ret = false;
+  /* restore the state */
+  rkChainFK( chain, dis );
+  rkChainSetJointVelAll( chain, vel );
+  zMatFreeAO( 3, c, m1, m2 );
+  zVecFreeAO( 2, g, d );
+  return ret;
+}
+
+bool check_id_select(rkChain *chain, zVec vel, double tol)
+{
+  zVec acc, trq, trq_sel;
+  zVec6D w;
+  int n;
+  bool ret;
+
+  n = rkChainJointSize( chain );
+  acc = zVecAlloc( n );
+  trq = zVecAlloc( n );
+  trq_sel = zVecAlloc( n );
+  zVecRandUniform( acc, -1.0, 1.0 );
+  /* root wrench only: joint torques have to be left unchanged */
+  rkChainID( chain, vel, acc );
+  rkChainGetJointTrqAll( chain, trq );
+  zVecMulDRC( acc, 2.0 );
+  rkChainIDSelect( chain, vel, acc, RK_ID_ROOTWRENCH | RK_ID_NOCOM );
+  rkChainGetJointTrqAll( chain, trq_sel );
+  zVec6DCopy( rkChainRootWrench(chain), &w );
+  ret = zVecIsEqual( trq, trq_sel, tol );
+  rkChainID( chain, vel, acc );
+  zVec6DSubDRC( &w, rkChainRootWrench(chain) );
+  if( !zVec6DIsTol( &w, tol ) ) ret = false;
+  /* gravity only */
+  zVecZero( acc );
+  rkChainID( chain, acc, acc );
+  rkChainGetJointTrqAll( chain, trq );
+  rkChainSetJointVelAll( chain, vel );
+  rkChainIDSelect( chain, NULL, NULL, RK_ID_GRAVITY );
+  rkChainGetJointTrqAll( chain, trq_sel );
+  if( !zVecIsEqual( trq, trq_sel, tol ) ) ret = false;
+  /* restore the state */
+  rkChainSetJointVelAll( chain, vel );
+  zVecFreeAO( 3, acc, trq, trq_sel );
+  return ret;
+}
+
 #define LINK_NUM 8
 
 void link_mp_rand(rkLink *l)
@@ -138,13 +217,15 @@ int chain_init(rkChain *chain)
 
 #define N 1000
 #define TOL (1.0e-10)
+#define TOL_CORIOLIS (1.0e-6)
+#define DT (1.0e-6)
 
 int main(int argc, char *argv[])
 {
   rkChain chain;
   zMat h;
   zVec b, dis, vel;
-  int i, count_im, count_ke, count_fd;
+  int i, count_im, count_ke, count_fd, count_cm, count_is;
   int n;
 
   /* initialization */
@@ -155,7 +236,7 @@ int main(int argc, char *argv[])
   vel = zVecAlloc( n );
   b = zVecAlloc( n );
 
-  count_im = count_ke = count_fd = 0;
+  count_im = count_ke = count_fd = count_cm = count_is = 0;
   for( i=0; i<N; i++ ){
     /* generate posture and velocity randomly */
     zVecRandUniform( dis, -10, 10 );
@@ -167,10 +248,14 @@ int main(int argc, char *argv[])
     if( check_inertia_matrix( &chain, h, TOL ) ) count_im++;
     if( check_kinetic_energy( &chain, h, vel, TOL ) ) count_ke++;
     if( check_fd( &chain, h, b, vel, TOL ) ) count_fd++;
+    if( check_coriolis( &chain, b, dis, vel, DT, TOL_CORIOLIS ) ) count_cm++;
+    if( check_id_select( &chain, vel, TOL ) ) count_is++;
   }
   zAssert( rkChainInertiaMatBiasVec, count_im == N );
   zAssert( rkChainInertiaMatBiasVec + rkChainKE, count_ke == N );
   zAssert( rkChainInertiaMatBiasVec (FD-ID), count_fd == N );
+  zAssert( rkChainCoriolisMat, count_cm == N );
+  zAssert( rkChainIDSelect, count_is == N );
 
   /* termination */
   zMatFree( h );
@@ -451,6 +451,328 @@ void assert_ik_l2l(void)
   zAssert( rkIKSolve (link-to-link), result );
 }
 
+void assert_ik_timed(void)
+{
+  register int i;
+  rkChain chain;
+  rkIKCell *cell;
+  rkIKCellAttr attr;
+  rkIK ik;
+  zVec dis;
+  zVec3D err;
+  bool result = true;
+
+  rkChainInit( &chain );
+  zArrayAlloc( &chain.link, rkLink, NL );
+  for( i=0; i<NL; i++ ){
+    chain_create_link( &chain, i, i < NL-1 ? &rk_joint_revol : &rk_joint_fixed );
+    if( i > 0 ){
+      rkLinkAddChild( rkChainLink(&chain,i-1), rkChainLink(&chain,i) );
+      zVec3DCreate( rkChainLinkOrgPos(&chain,i), 1, 0, 0 );
+    }
+    zFrame3DCopy( rkChainLinkOrgFrame(&chain,i), rkChainLinkAdjFrame(&chain,i) );
+  }
+  rkChainSetMass( &chain, 1.0 ); /* dummy weight */
+  rkChainSetOffset( &chain );
+  rkChainUpdateFK( &chain );
+  rkChainUpdateID( &chain );
+
+  dis = zVecAlloc( rkChainJointSize(&chain) );
+  rkIKCreate( &ik, &chain );
+  rkIKJointRegAll( &ik, 0.01 );
+
+  attr.id = rkChainLinkNum(&chain)-1;
+  zVec3DZero( &attr.ap );
+  cell = rkIKCellRegWldPos( &ik, &attr, RK_IK_CELL_ATTR_ID );
+
+  for( i=0; i<N;i ++ ){
+    rkIKDeactivate( &ik );
+    rkIKBind( &ik );
+    /* no time to spare: only one iteration is allowed for a target
+       behind the stretched arm, which is never reached by one step */
+    zVec2DCreatePolar( (zVec2D*)&cell->data.ref.pos, zRandF(1,rkChainLinkNum(&chain)-2), zRandF(zPI_2,zPI) );
+    cell->data.ref.pos.c.z = 0;
+    zVecZero( dis );
+    rkChainFK( &chain, dis );
+    if( rkIKSolveTimed( &ik, dis, zTOL, 0, 0 ) != RK_IK_TIMEOUT ||
+        rkIKLastStat(&ik)->iter != 1 ){
+      eprintf( "status = %d, number of iterations = %d under no time budget\n", rkIKLastStat(&ik)->status, rkIKLastStat(&ik)->iter );
+      result = false;
+    }
+    zVec2DCreatePolar( (zVec2D*)&cell->data.ref.pos, zRandF(1,rkChainLinkNum(&chain)-2), zRandF(-zPI,zPI) );
+    cell->data.ref.pos.c.z = 0;
+    zVecRandUniform( dis, -zPI_2, zPI_2 );
+    rkChainFK( &chain, dis );
+    /* sufficient time budget */
+    if( rkIKSolveTimed( &ik, dis, zTOL, 0, HUGE_VAL ) != RK_IK_CONVERGED ){
+      eprintf( "not converged (status = %d)\n", rkIKLastStat(&ik)->status );
+      result = false;
+    }
+    zVec3DSub( &cell->data.ref.pos, zFrame3DPos(rkChainLinkWldFrame(&chain,rkChainLinkNum(&chain)-1)), &err );
+    if( !zVec3DIsTol( &err, zTOL*10 ) ){
+      eprintf( "error: " );
+      zVec3DFPrint( stderr, &err );
+      result = false;
+    }
+  }
+  rkIKDestroy( &ik );
+  rkChainDestroy( &chain );
+  zVecFree( dis );
+  zAssert( rkIKSolveTimed, result );
+}
+
+void assert_ik_trace(void)
+{
+  register int i;
+  rkChain chain;
+  rkIKCell *cell;
+  rkIKCellAttr attr;
+  rkIK ik;
+  zVec dis;
+  double *rec;
+  bool result = true;
+
+  rkChainInit( &chain );
+  zArrayAlloc( &chain.link, rkLink, NL );
+  for( i=0; i<NL; i++ ){
+    chain_create_link( &chain, i, i < NL-1 ? &rk_joint_revol : &rk_joint_fixed );
+    if( i > 0 ){
+      rkLinkAddChild( rkChainLink(&chain,i-1), rkChainLink(&chain,i) );
+      zVec3DCreate( rkChainLinkOrgPos(&chain,i), 1, 0, 0 );
+    }
+    zFrame3DCopy( rkChainLinkOrgFrame(&chain,i), rkChainLinkAdjFrame(&chain,i) );
+  }
+  rkChainSetOffset( &chain );
+  rkChainUpdateFK( &chain );
+
+  dis = zVecAlloc( rkChainJointSize(&chain) );
+  rkIKCreate( &ik, &chain );
+  rkIKJointRegAll( &ik, 0.01 );
+  attr.id = rkChainLinkNum(&chain)-1;
+  zVec3DZero( &attr.ap );
+  cell = rkIKCellRegWldPos( &ik, &attr, RK_IK_CELL_ATTR_ID );
+  rkIKTraceAlloc( &ik, NC );
+
+  rkIKDeactivate( &ik );
+  rkIKBind( &ik );
+  zVec3DCreate( &cell->data.ref.pos, 0, 2, 0 );
+  for( i=0; i<2*NC; i++ ){
+    rkIKSolveOne( &ik, dis, 0.1 );
+    rec = rkIKTraceRec( &ik, rkIKTraceRecNum(&ik)-1 );
+    if( rkIKTraceRecNum(&ik) != zMin(i+1,NC) || (int)rec[0] != i ||
+        !zIsTiny( rec[1] - ik.eval ) ||
+        !zIsTiny( rec[RK_IK_TRACE_HEADSIZE] - cell->data._eval ) ){
+      eprintf( "invalid record at iteration %d\n", i );
+      result = false;
+    }
+  }
+  if( (int)rkIKTraceRec(&ik,0)[0] != NC || rkIKTraceRec(&ik,NC) ) result = false;
+  rkIKDestroy( &ik );
+  rkChainDestroy( &chain );
+  zVecFree( dis );
+  zAssert( rkIKTraceAlloc + rkIKTraceRec, result );
+}
+
+void assert_ik_seed(void)
+{
+  register int i;
+  rkChain chain;
+  rkIKCell *cell;
+  rkIKCellAttr attr;
+  rkIK ik;
+  rkIKSeedDB db, db2;
+  zVec dis, seed;
+  zVec3D ref[NC];
+  FILE *fp;
+  bool result = true;
+
+  rkChainInit( &chain );
+  zArrayAlloc( &chain.link, rkLink, NL );
+  for( i=0; i<NL; i++ ){
+    chain_create_link( &chain, i, i < NL-1 ? &rk_joint_revol : &rk_joint_fixed );
+    if( i > 0 ){
+      rkLinkAddChild( rkChainLink(&chain,i-1), rkChainLink(&chain,i) );
+      zVec3DCreate( rkChainLinkOrgPos(&chain,i), 1, 0, 0 );
+    }
+    zFrame3DCopy( rkChainLinkOrgFrame(&chain,i), rkChainLinkAdjFrame(&chain,i) );
+  }
+  rkChainSetOffset( &chain );
+  rkChainUpdateFK( &chain );
+
+  dis = zVecAlloc( rkChainJointSize(&chain) );
+  seed = zVecAlloc( rkChainJointSize(&chain) );
+  rkIKCreate( &ik, &chain );
+  rkIKJointRegAll( &ik, 0.01 );
+  attr.id = rkChainLinkNum(&chain)-1;
+  zVec3DZero( &attr.ap );
+  cell = rkIKCellRegWldPos( &ik, &attr, RK_IK_CELL_ATTR_ID );
+  rkIKSeedDBCreate( &db, &ik );
+  rkIKSeedDBCreate( &db2, &ik );
+
+  rkIKDeactivate( &ik );
+  rkIKBind( &ik );
+  for( i=0; i<NC; i++ ){
+    zVec2DCreatePolar( (zVec2D*)&ref[i], zRandF(1,rkChainLinkNum(&chain)-2), zRandF(-zPI,zPI) );
+    ref[i].c.z = 0;
+    zVec3DCopy( &ref[i], &cell->data.ref.pos );
+    rkIKSolve( &ik, dis, zTOL, 0 );
+    rkIKSeedDBAddIK( &db, &ik, dis );
+  }
+  fp = tmpfile();
+  rkIKSeedDBFWrite( fp, &db );
+  rewind( fp );
+  if( !rkIKSeedDBFRead( fp, &db2 ) || db2.num != NC ) result = false;
+  fclose( fp );
+  rkIKSetSeedDB( &ik, &db2 );
+  for( i=0; i<NC; i++ ){
+    zVec3DCopy( &ref[i], &cell->data.ref.pos );
+    if( !rkIKSeedDBFind( &db2, &ik, seed ) ||
+        memcmp( zVecBuf(seed), rkIKSeedDBDis(&db,i), sizeof(double)*zVecSizeNC(seed) ) != 0 ){
+      eprintf( "unmatched seed\n" );
+      result = false;
+    }
+    /* one iteration from the seed is enough */
+    rkIKSolveTimed( &ik, dis, zTOL, 1, HUGE_VAL );
+    if( rkIKLastStat(&ik)->eval > zTOL*10 ){
+      eprintf( "not started from the seed (error = %g)\n", rkIKLastStat(&ik)->eval );
+      result = false;
+    }
+  }
+  rkIKSeedDBDestroy( &db );
+  rkIKSeedDBDestroy( &db2 );
+  rkIKDestroy( &ik );
+  rkChainDestroy( &chain );
+  zVecFree( dis );
+  zVecFree( seed );
+  zAssert( rkIKSeedDBAddIK + rkIKSeedDBFind + rkIKSeedDBFWrite/FRead, result );
+}
+
+void assert_ik_frame(void)
+{
+  register int i;
+  rkChain chain;
+  rkIKCell *cell;
+  rkIKCellAttr attr;
+  rkIK ik;
+  zVec dis, dis0;
+  zFrame3D ref;
+  zVec6D err;
+  bool result = true;
+
+  rkChainInit( &chain );
+  zArrayAlloc( &chain.link, rkLink, NL+2 );
+  for( i=0; i<NL+2; i++ ){
+    chain_create_link( &chain, i, i < NL+1 ? &rk_joint_spher : &rk_joint_fixed );
+    if( i > 0 ){
+      rkLinkAddChild( rkChainLink(&chain,i-1), rkChainLink(&chain,i) );
+      zVec3DCreate( rkChainLinkOrgPos(&chain,i), 1, 0, 0 );
+    }
+    zFrame3DCopy( rkChainLinkOrgFrame(&chain,i), rkChainLinkAdjFrame(&chain,i) );
+  }
+  rkChainSetOffset( &chain );
+  rkChainUpdateFK( &chain );
+
+  dis = zVecAlloc( rkChainJointSize(&chain) );
+  dis0 = zVecAlloc( rkChainJointSize(&chain) );
+  rkIKCreate( &ik, &chain );
+  rkIKJointRegAll( &ik, 0.01 );
+  attr.id = rkChainLinkNum(&chain)-1;
+  zVec3DZero( &attr.ap );
+  cell = rkIKCellRegWldFrame( &ik, &attr, RK_IK_CELL_ATTR_ID );
+  if( zMatRowSizeNC(ik._c_mat) != 6 ) result = false;
+
+  for( i=0; i<N; i++ ){
+    /* a reachable target */
+    zVecRandUniform( dis0, -zPI_2, zPI_2 );
+    rkChainFK( &chain, dis0 );
+    zFrame3DCopy( rkChainLinkWldFrame(&chain,rkChainLinkNum(&chain)-1), &ref );
+    zVecRandUniform( dis, -0.1, 0.1 );
+    rkChainFK( &chain, zVecAddDRC( dis, dis0 ) );
+    rkIKDeactivate( &ik );
+    rkIKCellSetRefFrame( cell, &ref );
+    rkIKSolve( &ik, dis, zTOL, 0 );
+    rkIKLinkWldErr( &chain, &cell->data.attr, NULL, &cell->data.ref, zVec6DLin(&err) );
+    if( !zVec6DIsTol( &err, zTOL*10 ) ){
+      eprintf( "error: " );
+      zVec6DFPrint( stderr, &err );
+      result = false;
+    }
+  }
+  rkIKDestroy( &ik );
+  rkChainDestroy( &chain );
+  zVecFree( dis );
+  zVecFree( dis0 );
+  zAssert( rkIKCellRegWldFrame, result );
+}
+
+bool ikseq_cell_equal(rkIKSeqCell *c1, rkIKSeqCell *c2)
+{
+  register int i;
+
+  if( c1->dt != c2->dt || c1->nc != c2->nc ) return false;
+  for( i=0; i<c1->nc; i++ )
+    if( c1->entry[i].id != c2->entry[i].id ||
+        memcmp( c1->entry[i].w, c2->entry[i].w, sizeof(double)*3 ) != 0 ||
+        memcmp( c1->entry[i].val, c2->entry[i].val, sizeof(double)*3 ) != 0 ) return false;
+  return true;
+}
+
+void assert_ikseq_bin(void)
+{
+  register int i, j;
+  rkIKSeqCell cell, cell2;
+  rkIKEntry entry[NC];
+  FILE *ftxt, *fbin, *ftxt2;
+  int n = 0;
+  bool result = true;
+
+  ftxt = tmpfile();
+  fbin = tmpfile();
+  ftxt2 = tmpfile();
+  /* text */
+  for( i=0; i<N; i++ ){
+    cell.dt = zRandF(0,1);
+    cell.nc = zRandI(0,NC-1);
+    cell.entry = entry;
+    for( j=0; j<cell.nc; j++ ){
+      entry[j].id = zRandI(0,NC-1);
+      entry[j].w[0] = zRandF(0,1); entry[j].w[1] = zRandF(0,1); entry[j].w[2] = zRandF(0,1);
+      entry[j].val[0] = zRandF(-1,1); entry[j].val[1] = zRandF(-1,1); entry[j].val[2] = zRandF(-1,1);
+    }
+    rkIKSeqCellFPrint( ftxt, &cell );
+  }
+  /* text to binary */
+  rewind( ftxt );
+  rkIKSeqCellInit( &cell );
+  if( !rkIKSeqBinFWriteHeader( fbin ) ) result = false;
+  while( rkIKSeqCellFScan( ftxt, &cell ) )
+    if( !rkIKSeqCellFWrite( fbin, &cell ) ) result = false;
+  /* binary to text */
+  rewind( fbin );
+  if( !rkIKSeqBinFReadHeader( fbin ) ) result = false;
+  while( rkIKSeqCellFRead( fbin, &cell ) )
+    rkIKSeqCellFPrint( ftxt2, &cell );
+  /* compare cell by cell */
+  rewind( ftxt );
+  rewind( ftxt2 );
+  rkIKSeqCellInit( &cell2 );
+  while( rkIKSeqCellFScan( ftxt, &cell ) ){
+    if( !rkIKSeqCellFScan( ftxt2, &cell2 ) || !ikseq_cell_equal( &cell, &cell2 ) ){
+      eprintf( "unmatched cell #%d\n", n );
+      result = false;
+      break;
+    }
+    n++;
+  }
+  if( n != N || rkIKSeqCellFScan( ftxt2, &cell2 ) ) result = false;
+  rkIKSeqCellFree( &cell );
+  rkIKSeqCellFree( &cell2 );
+  fclose( ftxt );
+  fclose( fbin );
+  fclose( ftxt2 );
+  zAssert( rkIKSeqCellFWrite + rkIKSeqCellFRead, result );
+}
+
 int main(void)
 {
   zRandInit();
@@ -460,5 +782,10 @@ int main(void)
   assert_ik_spher();
   assert_ik_float();
   assert_ik_l2l();
+  assert_ik_timed();
+  assert_ik_trace();
+  assert_ik_seed();
+  assert_ik_frame();
+  assert_ikseq_bin();
   return 0;
 }
@@ -167,6 +167,28 @@ bool assert_zeroacc(rkChain *chain, int id, zVec dis, zVec vel, zVec acc, zMat j
   return zVec6DIsTiny( &av );
 }
 
+bool assert_wld_jacobi(rkChain *chain, int id, zMat jacobi)
+{
+  zMat j6;
+  zVec3D p;
+  register int i, j;
+  bool result = true;
+
+  j6 = zMatAlloc( 6, rkChainJointSize(chain) );
+  zVec3DCreate( &p, zRandF(-1,1), zRandF(-1,1), zRandF(-1,1) );
+  rkChainLinkWldJacobi( chain, id, &p, j6 );
+  rkChainLinkWldLinJacobi( chain, id, &p, jacobi );
+  for( i=0; i<3; i++ )
+    for( j=0; j<rkChainJointSize(chain); j++ )
+      if( !zIsTiny( zMatElemNC(j6,i,j) - zMatElemNC(jacobi,i,j) ) ) result = false;
+  rkChainLinkWldAngJacobi( chain, id, jacobi );
+  for( i=0; i<3; i++ )
+    for( j=0; j<rkChainJointSize(chain); j++ )
+      if( !zIsTiny( zMatElemNC(j6,i+3,j) - zMatElemNC(jacobi,i,j) ) ) result = false;
+  zMatFree( j6 );
+  return result;
+}
+
 int main(int argc, char *argv[])
 {
   rkChain chain;
@@ -196,6 +218,7 @@ int main(int argc, char *argv[])
   zAssert( rkChainLinkAMMat, assert_jacobi( &chain, jacobi, dis, vel, acc, ev, link_am_test ) );
   zAssert( rkChainAMMat, assert_jacobi( &chain, jacobi, dis, vel, acc, ev, am_test ) );
   zAssert( rkChainLinkZeroAcc, assert_zeroacc( &chain, TIP, dis, vel, acc, jacobi, ev ) );
+  zAssert( rkChainLinkWldJacobi, assert_wld_jacobi( &chain, TIP, jacobi ) );
 
   /* termination */
   zVecFree( dis );